@@ -0,0 +1,73 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_ADAPTIVEQUALITYCONTROLLER_H
+#define PROJECT_ADAPTIVEQUALITYCONTROLLER_H
+
+#include <string>
+
+namespace phoxi_camera {
+
+    //* AdaptiveQualityController
+    /**
+     * Keeps the trigger to publish latency of the frames under a deadline by stepping through quality levels,
+     * level 0 is the configured quality and each following level is cheaper than the previous one.
+     *
+     * The level is increased as soon as a frame misses the deadline and decreased when the filtered latency stays
+     * below headroom * deadline for holdFrames frames since the last change. The latency filter is restarted on
+     * every change because the latencies measured at the previous level are not representative anymore.
+     */
+    class AdaptiveQualityController {
+    public:
+        AdaptiveQualityController();
+        /**
+        * Set controller parameters
+        *
+        * \param deadline - maximum trigger to publish latency in seconds
+        * \param headroom - ratio of the deadline below which the quality is increased, from 0 to 1
+        * \param maxLevel - cheapest allowed level
+        * \param holdFrames - minimum number of frames between two changes of the level towards better quality
+        */
+        void setParameters(double deadline, double headroom, int maxLevel, int holdFrames);
+        /**
+        * Add the latency of a published frame
+        *
+        * \return true if the level changed
+        */
+        bool update(double latency);
+        /**
+        * Return to level 0
+        */
+        void reset();
+        int getLevel() const {
+            return level;
+        }
+        double getFilteredLatency() const {
+            return filteredLatency;
+        }
+        double getDeadline() const {
+            return deadline;
+        }
+        /**
+        * Description of the last change of level
+        */
+        const std::string& getLastDecision() const {
+            return lastDecision;
+        }
+
+    private:
+        void setLevel(int newLevel, const std::string& reason);
+
+        double deadline;
+        double headroom;
+        int maxLevel;
+        int holdFrames;
+        int level;
+        int framesSinceChange;
+        double filteredLatency;
+        std::string lastDecision;
+    };
+}
+
+#endif //PROJECT_ADAPTIVEQUALITYCONTROLLER_H
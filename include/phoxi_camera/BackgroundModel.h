@@ -0,0 +1,65 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_BACKGROUNDMODEL_H
+#define PROJECT_BACKGROUNDMODEL_H
+
+#include <PhoXi.h>
+#include <cstdint>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* BackgroundModel
+    /**
+     * Per pixel background depth of a static scene (for example the walls and floor of an empty bin),
+     * learned as the mean distance of the valid points of the captured frames.
+     *
+     * A point is foreground when its distance to the scanner differs from the background by more than a threshold,
+     * or when the background of its pixel was never valid.
+     */
+    class BackgroundModel {
+    public:
+        BackgroundModel();
+        /**
+        * Accumulate the point cloud of the frame into the background, frames with different resolution than the
+        * previously accumulated ones restart the learning
+        */
+        void addFrame(const pho::api::Frame& frame);
+        /**
+        * Forget the background
+        */
+        void reset();
+        /**
+        * Test if at least one frame was accumulated
+        */
+        bool isLearned() const {
+            return learnedFrames > 0;
+        }
+        /**
+        * Number of accumulated frames
+        */
+        uint32_t getLearnedFrames() const {
+            return learnedFrames;
+        }
+        /**
+        * Compute the foreground mask of the point cloud of the frame
+        *
+        * \param depthThreshold - distance difference in mm above which a point is foreground
+        * \param mask - row major mask with the size of the point cloud, 1 for foreground points
+        * \return number of foreground points, all valid points are foreground when the resolution of the frame differs from the background
+        */
+        size_t computeForegroundMask(const pho::api::Frame& frame, float depthThreshold, std::vector<uint8_t>& mask) const;
+
+    private:
+        int width;
+        int height;
+        uint32_t learnedFrames;
+        std::vector<float> depthSum;
+        std::vector<uint16_t> depthCount;
+        std::vector<float> background;
+    };
+}
+
+#endif //PROJECT_BACKGROUNDMODEL_H
@@ -0,0 +1,142 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_DEPTHBACKPROJECTION_H
+#define PROJECT_DEPTHBACKPROJECTION_H
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* DepthBackProjection
+    /**
+     * Header-only client library rebuilding the point cloud from the depth_map and depth_map/camera_info topics,
+     * so that remote consumers receive one float per pixel instead of the full point cloud.
+     *
+     * The undistorted viewing ray of each pixel is computed once per camera_info. The back-projection of a depth map
+     * is then a branch-free multiplication of the depth by the rays, auto-vectorized by the compiler.
+     * Only depth in the camera coordinate space is supported, the depth map is not transformed by the coordinate
+     * spaces of the scanner.
+     */
+    class DepthBackProjection {
+    public:
+        DepthBackProjection() : width(0), height(0) {
+        }
+        /**
+        * Set the intrinsics, the rays are recomputed only when they changed
+        *
+        * \param cameraMatrix - row major 3x3 matrix in pixels
+        * \param distortion - k1 k2 p1 p2 [k3 [k4 k5 k6]] of the plumb_bob or rational_polynomial model
+        */
+        void setIntrinsics(int width, int height, const double* cameraMatrix, const std::vector<double>& distortion) {
+            std::vector<double> intrinsics(cameraMatrix, cameraMatrix + 9);
+            intrinsics.insert(intrinsics.end(), distortion.begin(), distortion.end());
+            if (width == this->width && height == this->height && intrinsics == this->intrinsics) {
+                return;
+            }
+            this->width = width;
+            this->height = height;
+            this->intrinsics = intrinsics;
+            computeRays(cameraMatrix, distortion);
+        }
+        /**
+        * Set the intrinsics from a sensor_msgs::CameraInfo
+        */
+        template <typename CameraInfoT>
+        void setCameraInfo(const CameraInfoT& cameraInfo) {
+            const std::vector<double> distortion(cameraInfo.D.begin(), cameraInfo.D.end());
+            setIntrinsics((int) cameraInfo.width, (int) cameraInfo.height, &cameraInfo.K[0], distortion);
+        }
+        int getWidth() const {
+            return width;
+        }
+        int getHeight() const {
+            return height;
+        }
+        /**
+        * Back-project a row major depth map with the size of the intrinsics
+        *
+        * \param depth - z of each pixel, 0 for invalid pixels
+        * \param points - output of width * height interleaved x y z, NaN for invalid pixels
+        * \param scale - factor from the depth units to the point units, 0.001 from the millimeters of the scanner to meters
+        */
+        void backProject(const float* depth, float* points, float scale = 0.001f) const {
+            const size_t size = (size_t) width * height;
+            const float* x = raysX.data();
+            const float* y = raysY.data();
+            const float invalid = std::numeric_limits<float>::quiet_NaN();
+            for (size_t i = 0; i < size; ++i) {
+                const float z = depth[i] * scale;
+                const bool valid = z > 0.0f;
+                points[3 * i] = valid ? z * x[i] : invalid;
+                points[3 * i + 1] = valid ? z * y[i] : invalid;
+                points[3 * i + 2] = valid ? z : invalid;
+            }
+        }
+        /**
+        * Back-project a depth map into a vector resized to width * height * 3
+        */
+        void backProject(const std::vector<float>& depth, std::vector<float>& points, float scale = 0.001f) const {
+            points.resize((size_t) width * height * 3);
+            if (depth.size() >= (size_t) width * height) {
+                backProject(depth.data(), points.data(), scale);
+            }
+        }
+        /**
+        * x / z of the viewing ray of each pixel, row major
+        */
+        const std::vector<float>& getRaysX() const {
+            return raysX;
+        }
+        /**
+        * y / z of the viewing ray of each pixel, row major
+        */
+        const std::vector<float>& getRaysY() const {
+            return raysY;
+        }
+
+    private:
+        void computeRays(const double* K, const std::vector<double>& D) {
+            const double fx = K[0], fy = K[4], cx = K[2], cy = K[5];
+            double k[8] = {0.0};
+            for (size_t i = 0; i < D.size() && i < 8; ++i) {
+                k[i] = D[i];
+            }
+            const bool distorted = k[0] != 0.0 || k[1] != 0.0 || k[2] != 0.0 || k[3] != 0.0 || k[4] != 0.0 ||
+                                   k[5] != 0.0 || k[6] != 0.0 || k[7] != 0.0;
+            raysX.resize((size_t) width * height);
+            raysY.resize((size_t) width * height);
+            for (int v = 0; v < height; ++v) {
+                for (int u = 0; u < width; ++u) {
+                    const double xd = (u - cx) / fx;
+                    const double yd = (v - cy) / fy;
+                    double x = xd, y = yd;
+                    //fixed point inversion of the distortion, as cv::undistortPoints
+                    for (int iteration = 0; distorted && iteration < 20; ++iteration) {
+                        const double r2 = x * x + y * y;
+                        const double radial = (1.0 + ((k[7] * r2 + k[6]) * r2 + k[5]) * r2) /
+                                              (1.0 + ((k[4] * r2 + k[1]) * r2 + k[0]) * r2);
+                        const double dx = 2.0 * k[2] * x * y + k[3] * (r2 + 2.0 * x * x);
+                        const double dy = k[2] * (r2 + 2.0 * y * y) + 2.0 * k[3] * x * y;
+                        x = (xd - dx) * radial;
+                        y = (yd - dy) * radial;
+                    }
+                    raysX[(size_t) v * width + u] = (float) x;
+                    raysY[(size_t) v * width + u] = (float) y;
+                }
+            }
+        }
+
+        int width;
+        int height;
+        std::vector<double> intrinsics;
+        std::vector<float> raysX;
+        std::vector<float> raysY;
+    };
+}
+
+#endif //PROJECT_DEPTHBACKPROJECTION_H
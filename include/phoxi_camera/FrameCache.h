@@ -0,0 +1,69 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_FRAMECACHE_H
+#define PROJECT_FRAMECACHE_H
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+class FramePostProcessed;
+typedef std::shared_ptr <FramePostProcessed> PFramePostProcessed;
+
+namespace phoxi_camera {
+
+    //* FrameCache
+    /**
+     * Bounded cache of the last post-processed frames keyed by frame index, with least recently used eviction
+     * when either the number of frames or their memory exceeds the limits
+     */
+    class FrameCache {
+    public:
+        FrameCache();
+        /**
+        * Set limits of the cache, frames exceeding them are evicted immediately
+        *
+        * \param maxFrames - maximum number of cached frames, 0 disables the cache
+        * \param maxBytes - maximum memory of the cached frames
+        */
+        void setLimits(size_t maxFrames, size_t maxBytes);
+        /**
+        * Add frame to the cache, frames bigger than the memory limit are not cached
+        */
+        void insert(PFramePostProcessed frame);
+        /**
+        * Get frame with frameIndex, the frame becomes the most recently used
+        *
+        * \return null when the frame is not cached
+        */
+        PFramePostProcessed find(uint64_t frameIndex);
+        void clear();
+        size_t size() const;
+        size_t memory() const;
+        /**
+        * Approximate memory of the maps of frame
+        */
+        static size_t frameMemory(const FramePostProcessed& frame);
+
+    private:
+        struct Entry {
+            uint64_t frameIndex;
+            PFramePostProcessed frame;
+            size_t bytes;
+        };
+        void evict();
+
+        mutable std::mutex mutex;
+        size_t maxFrames;
+        size_t maxBytes;
+        size_t bytes;
+        std::list<Entry> entries;   //most recently used first
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    };
+}
+
+#endif //PROJECT_FRAMECACHE_H
@@ -0,0 +1,119 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_FRAMESTATISTICS_H
+#define PROJECT_FRAMESTATISTICS_H
+
+#include <PhoXi.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace phoxi_camera {
+
+    /**
+     * Outputs of the driver whose publishing rate and throughput are measured
+     */
+    enum class OutputChannel {
+        PointCloud = 0,
+        PointCloudPreview,
+        PointCloudBands,
+        PointCloudForeground,
+        PointCloudTargetFrames,
+        DepthMap,
+        Texture,
+        Image,
+        ImageRect,
+        ConfidenceMap,
+        NormalMap,
+        Mesh,
+        HeightMap,
+        Plane,
+        PlaneMask,
+        PointCloudVoxelGrid,
+        Count
+    };
+
+    /**
+     * Topic name of the output channel
+     */
+    const char* outputChannelName(OutputChannel channel);
+
+    //* FrameStatistics
+    /**
+     * Counters of the frames received and published by the driver, updated from the acquisition and publishing
+     * threads with relaxed atomic operations only (no locks on the hot path) and read periodically by diagnostics.
+     *
+     * Cumulative counters are never reset. Latencies are accumulated in a histogram with logarithmic buckets
+     * which is emptied by each snapshot, so percentiles cover the period between two snapshots.
+     */
+    class FrameStatistics {
+    public:
+        static const int LatencyBuckets = 64;
+
+        /**
+        * State of the counters, with percentiles of the latencies since the previous snapshot
+        */
+        struct Snapshot {
+            std::chrono::steady_clock::time_point time;
+            uint64_t framesReceived;
+            uint64_t framesPublished;
+            uint64_t framesDropped;
+            uint64_t frameIndexGaps;
+            uint64_t messages[(int) OutputChannel::Count];
+            uint64_t bytes[(int) OutputChannel::Count];
+            uint64_t latencySamples;
+            double latencyP50;
+            double latencyP90;
+            double latencyP99;
+            double latencyMax;
+            double validPointsRatio;
+            int64_t lastPublishTime;      ///< steady clock time of the last published frame in microseconds, 0 if none
+        };
+
+        FrameStatistics();
+        /**
+        * Account a frame received from the scanner, the valid points ratio is estimated on a subsampled grid
+        */
+        void frameReceived(const pho::api::Frame& frame);
+        /**
+        * Account a frame which was requested but not received or could not be published
+        */
+        void frameDropped();
+        /**
+        * Account a published frame with its trigger to publish latency in seconds
+        */
+        void framePublished(double latency);
+        /**
+        * Account a message published on an output
+        */
+        void outputPublished(OutputChannel channel, size_t bytes);
+        /**
+        * Read the counters and empty the latency histogram
+        */
+        Snapshot snapshot();
+        /**
+        * Steady clock time in microseconds used for lastPublishTime
+        */
+        static int64_t now();
+
+    private:
+        static int latencyBucket(double latency);
+        static double bucketUpperBound(int bucket);
+
+        std::atomic<uint64_t> framesReceived;
+        std::atomic<uint64_t> framesPublished;
+        std::atomic<uint64_t> framesDropped;
+        std::atomic<uint64_t> frameIndexGaps;
+        std::atomic<int64_t> lastFrameIndex;
+        std::atomic<uint64_t> messages[(int) OutputChannel::Count];
+        std::atomic<uint64_t> bytes[(int) OutputChannel::Count];
+        std::atomic<uint64_t> latencyHistogram[LatencyBuckets];
+        std::atomic<uint64_t> latencyMaxMicroseconds;
+        std::atomic<uint32_t> validPointsPerMille;
+        std::atomic<int64_t> lastPublishTime;
+    };
+}
+
+#endif //PROJECT_FRAMESTATISTICS_H
@@ -6,6 +6,7 @@
 #define PROJECT_PHOXIEXCEPTION_H
 
 #include <exception>
+#include <string>
 class PhoXiInterfaceException : public std::exception {
 public:
     PhoXiInterfaceException(std::string message) : message(message){
@@ -77,5 +78,22 @@ public:
     }
 };
 
+class  UnableToWriteTrace : public PhoXiInterfaceException {
+public:
+    UnableToWriteTrace(std::string message) : PhoXiInterfaceException(message){
+    }
+};
+
+class  SharedMemoryError : public PhoXiInterfaceException {
+public:
+    SharedMemoryError(std::string message) : PhoXiInterfaceException(message){
+    }
+};
+
+class  ThreadSchedulingError : public PhoXiInterfaceException {
+public:
+    ThreadSchedulingError(std::string message) : PhoXiInterfaceException(message){
+    }
+};
 
 #endif //PROJECT_PHOXIEXCEPTION_H
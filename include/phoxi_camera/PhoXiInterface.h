@@ -9,9 +9,15 @@
 #include <pcl/point_types.h>
 #include <pcl_ros/point_cloud.h>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <phoxi_camera/PhoXiException.h>
+#include <phoxi_camera/FrameCache.h>
+#include <phoxi_camera/ThreadPool.h>
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <limits>
+#include <unordered_map>
 #include <opencv2/core.hpp>
 
 /**
@@ -21,9 +27,133 @@ class FramePostProcessed {
     public:
         pho::api::PFrame PFrame;
         cv::Mat TextureAfterPostProcessing;
+        cv::Mat TextureRectified;                            ///< undistorted TextureAfterPostProcessing, empty if rectification is disabled
+        std::chrono::steady_clock::time_point TriggerTime;   ///< time of the software trigger, or of the frame request if triggered elsewhere
+        uint64_t TextureSettingsVersion;                     ///< version of the texture settings TextureAfterPostProcessing and TextureRectified were made with
 };
 typedef std::shared_ptr <FramePostProcessed> PFramePostProcessed;
 
+/**
+ * Selection of the point representing each block of a preview point cloud
+ */
+enum class PreviewPooling {
+    MinDepth = 0,       ///< point closest to the scanner
+    MedianDepth = 1     ///< point with the median depth, more robust to outliers
+};
+
+/**
+ * Statistics of the points of a frame accumulated during the point cloud conversion
+ */
+struct PointCloudStatistics {
+    static const int TextureHistogramBins = 32;
+
+    PointCloudStatistics() {
+        reset();
+    }
+    void reset() {
+        totalPoints = 0;
+        validPoints = 0;
+        boundingBoxMin = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+        boundingBoxMax = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+        depthMin = std::numeric_limits<float>::max();
+        depthMax = 0.0f;
+        depthSum = 0.0;
+        confidenceSum = 0.0;
+        confidencePoints = 0;
+        std::fill(textureHistogram, textureHistogram + TextureHistogramBins, 0);
+    }
+    void merge(const PointCloudStatistics& other) {
+        totalPoints += other.totalPoints;
+        validPoints += other.validPoints;
+        boundingBoxMin = boundingBoxMin.cwiseMin(other.boundingBoxMin);
+        boundingBoxMax = boundingBoxMax.cwiseMax(other.boundingBoxMax);
+        depthMin = std::min(depthMin, other.depthMin);
+        depthMax = std::max(depthMax, other.depthMax);
+        depthSum += other.depthSum;
+        confidenceSum += other.confidenceSum;
+        confidencePoints += other.confidencePoints;
+        for (int i = 0; i < TextureHistogramBins; ++i) {
+            textureHistogram[i] += other.textureHistogram[i];
+        }
+    }
+
+    uint64_t totalPoints;
+    uint64_t validPoints;
+    Eigen::Vector3f boundingBoxMin;     ///< in meters, in the frame of the point cloud
+    Eigen::Vector3f boundingBoxMax;
+    float depthMin;                     ///< in meters, along the optical axis of the scanner
+    float depthMax;
+    double depthSum;
+    double confidenceSum;
+    uint64_t confidencePoints;
+    uint32_t textureHistogram[TextureHistogramBins];   ///< post-processed 8 bit texture of the valid points
+};
+
+/**
+ * Indexed triangle mesh of the organized point cloud of a frame
+ */
+struct OrganizedMesh {
+    int width;                          ///< size of the grid of the (decimated) point cloud the vertices come from
+    int height;
+    int step;                           ///< every step-th row and column of the point cloud is in the grid
+    std::vector<float> vertices;        ///< x, y, z in meters of the valid grid points
+    std::vector<uint32_t> triangles;    ///< 3 vertex indices per triangle, counter clockwise seen from the scanner
+};
+
+/**
+ * Intrinsic calibration of the camera of the scanner for a resolution
+ */
+struct ScannerIntrinsics {
+    ScannerIntrinsics() : width(0), height(0) {
+        std::fill(cameraMatrix, cameraMatrix + 9, 0.0);
+    }
+    int width;
+    int height;
+    double cameraMatrix[9];                     ///< row major fx 0 cx, 0 fy cy, 0 0 1 in pixels
+    std::vector<double> distortionCoefficients; ///< k1 k2 p1 p2 [k3 [k4 k5 k6 ...]] in the order of OpenCV
+};
+
+/**
+ * Top-down grid of the maximum height of the points in each cell, with the grid geometry set by the caller
+ */
+struct HeightMap {
+    HeightMap() : resolution(0.002f), originX(0.0f), originY(0.0f), width(0), height(0), minPoints(1) {
+    }
+    float resolution;                   ///< size of a cell in meters
+    float originX;                      ///< corner of cell (0, 0) in meters, columns along +x and rows along +y
+    float originY;
+    int width;                          ///< number of cells
+    int height;
+    int minPoints;                      ///< cells with fewer points are empty
+    std::vector<float> heights;         ///< row major maximum z in meters, NaN for empty cells
+    std::vector<uint32_t> counts;       ///< row major number of points in each cell
+};
+
+/**
+ * Sums of the points falling into one cell of a voxel grid
+ */
+struct VoxelGridCell {
+    double x;                           ///< sum of the coordinates in meters, in double to keep the centroid of dense cells exact
+    double y;
+    double z;
+    float normalX;                      ///< sum of the unit normals
+    float normalY;
+    float normalZ;
+    uint32_t intensity;                 ///< sum of the texture intensities
+    uint32_t count;
+};
+
+/**
+ * Named set of capturing settings switched as a whole, negative values leave the setting unchanged
+ */
+struct CaptureProfile {
+    CaptureProfile() : resolution(-1), scanMultiplier(-1), shutterMultiplier(-1), confidence(-1.0) {}
+    int resolution;             ///< 0 = Low, 1 = High
+    int scanMultiplier;
+    int shutterMultiplier;
+    double confidence;
+};
+
 //* PhoXiInterface
 /**
  * Wrapper to PhoXi 3D Scanner api to make interface easier
@@ -62,11 +192,20 @@ public:
     /**
     * Get frame based on id. If id is negative new image is triggered and new PFrame returned.
     *
-    * \note only last triggered frame can be returned - recommended usage is with negative number
+    * \note frames in the frame cache are returned without communicating with the scanner, their texture is processed
+    * again when the texture settings changed since they were cached, otherwise
+    * only last triggered frame can be returned - recommended usage is with negative number
     * \param id - frame id to return
     * \throw PhoXiScannerNotConnected when no scanner is connected
     */
     PFramePostProcessed getPFrame(int id = -1);
+    /**
+    * Set limits of the cache of the last frames returned by getPFrame
+    *
+    * \param maxFrames - maximum number of cached frames, 0 disables the cache
+    * \param maxBytes - maximum memory of the cached frames
+    */
+    void setFrameCacheLimits(size_t maxFrames, size_t maxBytes);
     /**
      * Post processing stage of frame data
      */
@@ -79,9 +218,117 @@ public:
     std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> getPointCloud();
     /**
     * Convert PFrame to point cloud
+    *
+    * \throw CorruptedFrame when frame is null or was not successfully captured
     */
     std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> getPointCloudFromFrame(PFramePostProcessed frame);
     /**
+    * Convert PFrame to point cloud of type PointT
+    *
+    * \tparam PointT pcl::PointXYZ, pcl::PointXYZI, pcl::PointXYZRGB or pcl::PointXYZRGBNormal
+    * \param transform - affine transformation (in meters) applied on the host to points and normals during the
+    * conversion, on top of the coordinate space configured in the scanner
+    * \param statistics - if not null, statistics of the frame are accumulated into it during the conversion
+    * \note intensity and color are filled from the post-processed texture and normals from the normal map,
+    * only when PointT has these fields
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    template <typename PointT>
+    std::shared_ptr<pcl::PointCloud<PointT>> getPointCloudFromFrame(PFramePostProcessed frame, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity(), PointCloudStatistics* statistics = nullptr);
+    /**
+    * Accumulate the statistics of the points of PFrame that getPointCloudFromFrame would keep, without converting
+    * them, for when no full resolution conversion runs. The rows are processed in parallel by the worker threads.
+    *
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    void getPointCloudStatisticsFromFrame(PFramePostProcessed frame, PointCloudStatistics& statistics);
+    /**
+    * Convert the rows [rowBegin, rowEnd) of PFrame to an organized point cloud of type PointT,
+    * used to publish large point clouds progressively while the rest of the frame is converted
+    *
+    * \tparam PointT pcl::PointXYZ, pcl::PointXYZI, pcl::PointXYZRGB or pcl::PointXYZRGBNormal
+    * \param statistics - if not null, statistics of the band are accumulated into it
+    * \note the band is always organized, generatePointCloudWithOnlyValidPoints is ignored
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    template <typename PointT>
+    std::shared_ptr<pcl::PointCloud<PointT>> getPointCloudBandFromFrame(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity(), PointCloudStatistics* statistics = nullptr);
+    /**
+    * Convert the valid points of PFrame selected by pixelMask to a dense point cloud of type PointT
+    *
+    * \tparam PointT pcl::PointXYZ, pcl::PointXYZI, pcl::PointXYZRGB or pcl::PointXYZRGBNormal
+    * \param pixelMask - row major mask with the size of the point cloud, points with 0 are discarded
+    * \throw CorruptedFrame when frame is null, was not successfully captured or pixelMask has a different size
+    */
+    template <typename PointT>
+    std::shared_ptr<pcl::PointCloud<PointT>> getMaskedPointCloudFromFrame(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity());
+    /**
+    * Convert PFrame to an organized preview point cloud downsampled by factor in both directions.
+    * Each factor x factor block of valid points is represented by one of its points selected with pooling.
+    *
+    * \tparam PointT pcl::PointXYZ, pcl::PointXYZI, pcl::PointXYZRGB or pcl::PointXYZRGBNormal
+    * \param factor - downsampling factor, from 1 to 8
+    * \param transform - affine transformation (in meters) applied to the selected points and normals during the conversion
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    template <typename PointT>
+    std::shared_ptr<pcl::PointCloud<PointT>> getPreviewPointCloudFromFrame(PFramePostProcessed frame, int factor, PreviewPooling pooling = PreviewPooling::MinDepth, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity());
+    /**
+    * Convert PFrame to a dense point cloud with one point per occupied cell of a metric voxel grid, in parallel by
+    * the worker threads. Each point is the centroid of the valid points of its cell, with their averaged normal and
+    * intensity. The points are hashed into the cells of one map per worker thread while the frame is read, the maps
+    * are merged at the end, so the full resolution point cloud is neither built nor sorted.
+    *
+    * \tparam PointT pcl::PointXYZ, pcl::PointXYZI, pcl::PointXYZRGB or pcl::PointXYZRGBNormal
+    * \param leafSize - edge of a cell in meters, in the frame of transform
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    template <typename PointT>
+    std::shared_ptr<pcl::PointCloud<PointT>> getVoxelGridPointCloudFromFrame(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity());
+    /**
+    * Triangulate the organized point cloud of PFrame. Each quad of the grid with 4 valid corners and edges not longer
+    * than maxEdgeLength gives two triangles. The rows are triangulated in parallel by the worker threads.
+    *
+    * \param mesh - output, its buffers are reused between frames
+    * \param maxEdgeLength - in meters, edges are not limited if <= 0
+    * \param step - decimation of the grid, every step-th row and column is used, from 1 to 8
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    void getMeshFromFrame(PFramePostProcessed frame, OrganizedMesh& mesh, float maxEdgeLength, int step = 1, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity());
+    /**
+    * Project the valid points of PFrame into the height map grid. Each worker thread projects a block of rows
+    * of the frame and sorts the projected points by band of grid rows, then each thread merges the points of
+    * one band into the grid.
+    *
+    * \param heightMap - grid geometry as input, heights and counts as output, its buffers are reused between frames
+    * \param transform - from the frame of the point cloud to the frame of the height map, with z up
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    void getHeightMapFromFrame(PFramePostProcessed frame, HeightMap& heightMap, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity());
+    /**
+    * Gather the valid points of every subsampling-th row and column of PFrame
+    *
+    * \param points - output in meters, its buffer is reused between frames
+    * \param intensities - optional output of the post-processed texture of each point, left empty without texture
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    void getSubsampledPointsFromFrame(PFramePostProcessed frame, int subsampling, std::vector<Eigen::Vector3f>& points, std::vector<uint8_t>* intensities = nullptr);
+    /**
+    * Compute the mask of the valid points of PFrame closer than maxDistance to plane, in parallel by the worker threads
+    *
+    * \param plane - coefficients (a, b, c, d) of ax + by + cz + d = 0 in meters with a unit normal
+    * \param mask - row major mask with the size of the point cloud, 255 for plane points and 0 otherwise
+    * \throw CorruptedFrame when frame is null or was not successfully captured
+    */
+    void getPlaneMaskFromFrame(PFramePostProcessed frame, const Eigen::Vector4f& plane, float maxDistance, std::vector<uint8_t>& mask);
+    /**
+    * Start the worker threads of the parallel conversions
+    *
+    * \param threads - number of threads including the calling thread, the number of hardware threads if <= 0
+    * \param initializer - called by each worker thread when it starts, for example to set its scheduling
+    */
+    void setWorkerThreads(int threads, const std::function<void()>& initializer = std::function<void()>());
+    /**
     * Test if connection to PhoXi 3D Scanner is working
     *
     * \throw PhoXiScannerNotConnected when no scanner is connected
@@ -184,6 +431,12 @@ public:
     */
     std::vector<pho::api::PhoXiCapturingMode> getSupportedCapturingModes();
     /**
+    * Get the intrinsic calibration of the scanner for the active capturing mode
+    *
+    * \throw PhoXiScannerNotConnected when no scanner is connected
+    */
+    ScannerIntrinsics getScannerIntrinsics();
+    /**
     * Set high resolution (2064 x 1544)
     *
     * \throw PhoXiScannerNotConnected when no scanner is connected
@@ -196,6 +449,15 @@ public:
     */
     void setLowResolution();
     /**
+    * Apply the settings of profile which differ from current, each group of settings (capturing mode,
+    * capturing settings, processing settings) is written at most once and acquisition is not restarted
+    *
+    * \param current - settings of the scanner, used to skip unchanged settings without reading them from the device
+    * \return number of settings groups written to the device
+    * \throw PhoXiScannerNotConnected when no scanner is connected
+    */
+    int setCaptureProfile(const CaptureProfile& profile, const CaptureProfile& current);
+    /**
     * Set trigger mode
     *
     * \param mode new trigger mode
@@ -222,6 +484,7 @@ public:
      * Sets the minimum intensity when coloring point cloud from the image texture
      */
     void setTextureMinIntensity(float minIntensity) {
+        textureSettingsVersion += minIntensity != textureMinIntensity;
         PhoXiInterface::textureMinIntensity = minIntensity;
     }
     /**
@@ -234,6 +497,7 @@ public:
      * Gets the maximum intensity when coloring point cloud from the image texture
      */
     void setTextureMaxIntensity(float maxIntensity) {
+        textureSettingsVersion += maxIntensity != textureMaxIntensity;
         PhoXiInterface::textureMaxIntensity = maxIntensity;
     }
     /**
@@ -246,6 +510,7 @@ public:
      * Sets the CLAHE clip limit
      */
     void setTextureContrastLimitedAdaptiveHistogramEqualizationClipLimit(double claheClipLimit) {
+        textureSettingsVersion += claheClipLimit != textureContrastLimitedAdaptiveHistogramEqualizationClipLimit;
         PhoXiInterface::textureContrastLimitedAdaptiveHistogramEqualizationClipLimit = claheClipLimit;
     }
     /**
@@ -258,6 +523,7 @@ public:
      * Sets the number of bins in the X axis for CLAHE
      */
     void setTextureContrastLimitedAdaptiveHistogramEqualizationSizeX(int claheSizeX) {
+        textureSettingsVersion += claheSizeX != textureContrastLimitedAdaptiveHistogramEqualizationSizeX;
         PhoXiInterface::textureContrastLimitedAdaptiveHistogramEqualizationSizeX = claheSizeX;
     }
     /**
@@ -270,6 +536,7 @@ public:
      * Sets the number of bins in the Y axis for CLAHE
      */
     void setTextureContrastLimitedAdaptiveHistogramEqualizationSizeY(int claheSizeY) {
+        textureSettingsVersion += claheSizeY != textureContrastLimitedAdaptiveHistogramEqualizationSizeY;
         PhoXiInterface::textureContrastLimitedAdaptiveHistogramEqualizationSizeY = claheSizeY;
     }
     /**
@@ -287,11 +554,89 @@ public:
     void setGeneratePointCloudWithOnlyValidPoints(bool generatePointcloudWithOnlyValidPoints) {
         PhoXiInterface::generatePointCloudWithOnlyValidPoints = generatePointcloudWithOnlyValidPoints;
     }
+    /**
+     * Gets the minimum confidence map value that a point must have to be kept in the point cloud
+     */
+    float getPointCloudMinConfidence() const {
+        return pointCloudMinConfidence;
+    }
+    /**
+     * Sets the minimum confidence map value that a point must have to be kept in the point cloud.
+     * The filter is disabled if minConfidence <= 0 or if the frame has no confidence map.
+     */
+    void setPointCloudMinConfidence(float minConfidence) {
+        PhoXiInterface::pointCloudMinConfidence = minConfidence;
+    }
+    /**
+     * Gets the maximum depth ratio between a point and its 4-neighbours before the point is rejected as a jump edge
+     */
+    float getPointCloudJumpEdgeMaxDepthRatio() const {
+        return pointCloudJumpEdgeMaxDepthRatio;
+    }
+    /**
+     * Sets the maximum depth ratio between a point and its 4-neighbours before the point is rejected as a jump edge
+     * (flying pixel at a depth discontinuity). The filter is disabled if maxDepthRatio <= 1.
+     */
+    void setPointCloudJumpEdgeMaxDepthRatio(float maxDepthRatio) {
+        PhoXiInterface::pointCloudJumpEdgeMaxDepthRatio = maxDepthRatio;
+    }
+    /**
+     * Gets the minimum number of valid 8-neighbours that a point must have to be kept in the point cloud
+     */
+    int getPointCloudMinValidNeighbours() const {
+        return pointCloudMinValidNeighbours;
+    }
+    /**
+     * Sets the minimum number of valid 8-neighbours that a point must have to be kept in the point cloud.
+     * The filter is disabled if minValidNeighbours <= 0.
+     */
+    void setPointCloudMinValidNeighbours(int minValidNeighbours) {
+        PhoXiInterface::pointCloudMinValidNeighbours = minValidNeighbours;
+    }
+    /**
+     * Sets the undistortion of the post-processed texture into FramePostProcessed::TextureRectified. The remap tables
+     * are computed once per resolution and intrinsics, the rectified image keeps the camera matrix of intrinsics.
+     *
+     * \param intrinsics - calibration of the texture, scaled to the resolution of the frames if it differs
+     */
+    void setTextureRectification(bool enabled, const ScannerIntrinsics& intrinsics = ScannerIntrinsics());
+    /**
+     * Test if postProcessFrame rectifies the texture
+     */
+    bool isTextureRectificationEnabled() const {
+        return textureRectification;
+    }
+    /**
+     * Sets the plane whose points are discarded by the point cloud conversions, as if they were invalid, until it is
+     * disabled. Prefer ScopedPointCloudPlaneRemoval, which limits the removal to the conversions of one frame.
+     *
+     * \param plane - coefficients (a, b, c, d) of ax + by + cz + d = 0 in meters with a unit normal, in the frame of
+     * the point cloud before the host transformation
+     * \param maxDistance - points closer to the plane are discarded, in meters
+     */
+    void setPointCloudPlaneRemoval(bool enabled, const Eigen::Vector4f& plane = Eigen::Vector4f::Zero(), float maxDistance = 0.0f) {
+        PhoXiInterface::pointCloudPlaneRemoval = enabled;
+        PhoXiInterface::pointCloudPlaneNormal = plane.head<3>();
+        PhoXiInterface::pointCloudPlaneOffset = plane[3];
+        PhoXiInterface::pointCloudPlaneMaxDistance = maxDistance;
+    }
     /**
      * Value associated with an invalid point for which the depth value could not be calculated
      */
     static const pho::api::Point3_32f invalidPoint;
 protected:
+    /**
+    * Conversion kernel of getPointCloudFromFrame, specialized for each point type and for dense (OnlyValidPoints)
+    * or organized output, converts the rows [rowBegin, rowEnd) and discards the points with 0 in the optional pixelMask.
+    * Statistics of the converted points are accumulated into the optional statistics.
+    */
+    template <typename PointT, bool OnlyValidPoints>
+    std::shared_ptr<pcl::PointCloud<PointT>> convertFrameToPointCloud(FramePostProcessed& frame, const Eigen::Affine3f& transform, int rowBegin, int rowEnd, const uint8_t* pixelMask = nullptr, PointCloudStatistics* statistics = nullptr);
+    /**
+    * Undistort the post-processed texture of frame into a buffer of the pool, rebuilding the remap tables when the resolution changed
+    */
+    void rectifyTexture(FramePostProcessed& frame);
+
     pho::api::PPhoXi scanner;
     pho::api::PhoXiFactory phoXiFactory;
     float textureMinIntensity;
@@ -300,6 +645,65 @@ protected:
     int textureContrastLimitedAdaptiveHistogramEqualizationSizeX;
     int textureContrastLimitedAdaptiveHistogramEqualizationSizeY;
     bool generatePointCloudWithOnlyValidPoints;
+    float pointCloudMinConfidence;
+    float pointCloudJumpEdgeMaxDepthRatio;
+    int pointCloudMinValidNeighbours;
+    bool pointCloudPlaneRemoval;
+    Eigen::Vector3f pointCloudPlaneNormal;
+    float pointCloudPlaneOffset;
+    float pointCloudPlaneMaxDistance;
+    bool textureRectification;
+    ScannerIntrinsics textureRectificationIntrinsics;
+    cv::Size textureRectificationMapSize;               ///< resolution of the remap tables, empty when they must be rebuilt
+    cv::Mat textureRectificationMap1;                   ///< fixed point coordinates, CV_16SC2
+    cv::Mat textureRectificationMap2;                   ///< interpolation weights, CV_16UC1
+    std::vector<cv::Mat> textureRectifiedPool;          ///< buffers of TextureRectified, reused when no frame references them
+    uint64_t textureSettingsVersion;                    ///< incremented by every change of the texture post-processing settings
+    int lastTriggeredFrameId;
+    phoxi_camera::FrameCache frameCache;
+    std::chrono::steady_clock::time_point lastTriggerTime;
+    phoxi_camera::ThreadPool threadPool;
+    //buffers of getMeshFromFrame reused between frames
+    std::vector<float> meshGridPoints;
+    std::vector<uint8_t> meshGridValid;
+    std::vector<uint8_t> meshQuads;
+    std::vector<uint32_t> meshRowVertices;
+    std::vector<uint32_t> meshRowTriangles;
+    //projected points of getHeightMapFromFrame, one bucket per worker thread and band of grid rows
+    std::vector<std::vector<uint32_t>> heightMapBucketCells;
+    std::vector<std::vector<float>> heightMapBucketHeights;
+    //cells of getVoxelGridPointCloudFromFrame, one map per worker thread
+    std::vector<std::unordered_map<uint64_t, VoxelGridCell>> voxelGridMaps;
+};
+
+//* ScopedPointCloudPlaneRemoval
+/**
+ * Plane removal enabled for the lifetime of the scope, so that the plane of a frame is not applied to later
+ * conversions of other frames, for example by services converting cached frames.
+ *
+ * The removal affects the conversions of the valid points: getPointCloudFromFrame, getPointCloudBandFromFrame,
+ * getMaskedPointCloudFromFrame and getVoxelGridPointCloudFromFrame. The preview point cloud, the mesh, the height map,
+ * the subsampled points and the plane mask are not affected.
+ */
+class ScopedPointCloudPlaneRemoval {
+public:
+    /**
+    * \param enabled - the scope does nothing if false
+    * \param plane - coefficients (a, b, c, d) in meters with a unit normal, in the frame of the point cloud
+    * \param maxDistance - points closer to the plane are discarded, in meters
+    */
+    ScopedPointCloudPlaneRemoval(PhoXiInterface& phoxiInterface, bool enabled, const Eigen::Vector4f& plane, float maxDistance)
+            : phoxiInterface(phoxiInterface) {
+        phoxiInterface.setPointCloudPlaneRemoval(enabled, plane, maxDistance);
+    }
+    ~ScopedPointCloudPlaneRemoval() {
+        phoxiInterface.setPointCloudPlaneRemoval(false);
+    }
+    ScopedPointCloudPlaneRemoval(const ScopedPointCloudPlaneRemoval&) = delete;
+    ScopedPointCloudPlaneRemoval& operator=(const ScopedPointCloudPlaneRemoval&) = delete;
+
+private:
+    PhoXiInterface& phoxiInterface;
 };
 
 
@@ -0,0 +1,93 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_PLANEDETECTOR_H
+#define PROJECT_PLANEDETECTOR_H
+
+#include <phoxi_camera/ThreadPool.h>
+#include <Eigen/Core>
+#include <cstdint>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* PlaneDetector
+    /**
+     * Estimates the dominant plane (bin floor, conveyor belt) of a sample of the valid points of each frame.
+     *
+     * The plane of the previous frame is a temporal prior: while it still explains at least priorKeepRatio of its
+     * previous inliers it is only refined by least squares on its inliers, so a stable plane costs two passes over
+     * the samples instead of a full RANSAC. Otherwise the RANSAC hypotheses are split between the threads of the pool,
+     * each hypothesis drawn from its own random generator seeded by the frame and hypothesis index so that results
+     * do not depend on the number of threads, and the best hypothesis is refined by least squares.
+     */
+    class PlaneDetector {
+    public:
+        PlaneDetector();
+        /**
+        * Set detection parameters, the prior plane is dropped
+        *
+        * \param inlierDistance - distance in meters below which a point is an inlier of a plane
+        * \param iterations - number of RANSAC hypotheses
+        * \param minInlierRatio - ratio of inlier samples above which the dominant plane is found
+        * \param priorKeepRatio - the prior plane is refined without RANSAC while its inlier ratio is at least this
+        * fraction of its previous inlier ratio, RANSAC runs on every frame if > 1
+        */
+        void setParameters(float inlierDistance, int iterations, float minInlierRatio, float priorKeepRatio);
+        /**
+        * Estimate the dominant plane of the points
+        *
+        * \param points - sample of the valid points in meters
+        * \return true if a plane with enough inliers was found, it becomes the prior of the next call
+        */
+        bool detect(const std::vector<Eigen::Vector3f>& points, ThreadPool& threadPool);
+        /**
+        * Drop the prior plane, next call runs RANSAC
+        */
+        void reset();
+        /**
+        * Test if the last call found a plane
+        */
+        bool hasPlane() const {
+            return planeFound;
+        }
+        /**
+        * Coefficients (a, b, c, d) of the plane ax + by + cz + d = 0 found by the last call, with the unit normal
+        * (a, b, c) pointing to the origin of the points. The normal faces the scanner only when the points are in the
+        * camera coordinate space of the scanner, in other coordinate spaces it faces the origin of that space.
+        */
+        Eigen::Vector4f getPlane() const {
+            return Eigen::Vector4f(normal.x(), normal.y(), normal.z(), offset);
+        }
+        /**
+        * Ratio of inlier samples of the plane found by the last call
+        */
+        float getInlierRatio() const {
+            return inlierRatio;
+        }
+        /**
+        * Test if the last call refined the prior plane without RANSAC
+        */
+        bool isPriorReused() const {
+            return priorReused;
+        }
+
+    private:
+        size_t countInliers(const std::vector<Eigen::Vector3f>& points, const Eigen::Vector3f& planeNormal, float planeOffset, ThreadPool& threadPool) const;
+        bool refine(const std::vector<Eigen::Vector3f>& points, Eigen::Vector3f& planeNormal, float& planeOffset, ThreadPool& threadPool) const;
+
+        float inlierDistance;
+        int iterations;
+        float minInlierRatio;
+        float priorKeepRatio;
+        bool planeFound;
+        bool priorReused;
+        Eigen::Vector3f normal;
+        float offset;
+        float inlierRatio;
+        uint64_t detections;        ///< seeds the random generators
+    };
+}
+
+#endif //PROJECT_PLANEDETECTOR_H
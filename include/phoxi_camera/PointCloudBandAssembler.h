@@ -0,0 +1,136 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_POINTCLOUDBANDASSEMBLER_H
+#define PROJECT_POINTCLOUDBANDASSEMBLER_H
+
+#include <phoxi_camera/PointCloudBand.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* PointCloudBandAssembler
+    /**
+     * Header only client library reconstructing the full organized point cloud from the bands published on the
+     * pointcloud_bands topic of phoxi_camera node.
+     *
+     * Bands can arrive in any order, frames are completed independently and incomplete frames are dropped
+     * when more than maxPendingFrames frames are being assembled.
+     *
+     * \code
+     * phoxi_camera::PointCloudBandAssembler assembler;
+     * void bandCallback(const phoxi_camera::PointCloudBand& band) {
+     *     //band.cloud can already be processed here
+     *     sensor_msgs::PointCloud2 cloud;
+     *     if (assembler.addBand(band, cloud)) {
+     *         //full point cloud of band.frame_index
+     *     }
+     * }
+     * \endcode
+     */
+    class PointCloudBandAssembler {
+    public:
+        explicit PointCloudBandAssembler(size_t maxPendingFrames = 2) : maxPendingFrames(std::max<size_t>(1, maxPendingFrames)) {
+        }
+
+        /**
+        * Add band to its frame
+        *
+        * \param cloud - full point cloud, filled only when the frame of the band is complete
+        * \return true if the frame of the band is complete
+        */
+        bool addBand(const phoxi_camera::PointCloudBand& band, sensor_msgs::PointCloud2& cloud) {
+            const sensor_msgs::PointCloud2& bandCloud = band.cloud;
+            if (band.band_count == 0 || band.band_index >= band.band_count ||
+                band.row_offset + bandCloud.height > band.frame_height ||
+                bandCloud.data.size() < (size_t) bandCloud.row_step * bandCloud.height) {
+                return false;
+            }
+
+            std::map<uint64_t, PendingFrame>::iterator it = pendingFrames.find(band.frame_index);
+            if (it == pendingFrames.end()) {
+                it = pendingFrames.insert(std::make_pair(band.frame_index, PendingFrame())).first;
+                PendingFrame& frame = it->second;
+                frame.cloud.header = bandCloud.header;
+                frame.cloud.fields = bandCloud.fields;
+                frame.cloud.is_bigendian = bandCloud.is_bigendian;
+                frame.cloud.point_step = bandCloud.point_step;
+                frame.cloud.row_step = bandCloud.row_step;
+                frame.cloud.width = bandCloud.width;
+                frame.cloud.height = band.frame_height;
+                frame.cloud.is_dense = false;
+                frame.cloud.data.resize((size_t) bandCloud.row_step * band.frame_height);
+                frame.received.assign(band.band_count, false);
+                frame.receivedCount = 0;
+                dropOldFrames();
+                it = pendingFrames.find(band.frame_index);
+                if (it == pendingFrames.end()) {
+                    return false;
+                }
+            }
+
+            PendingFrame& frame = it->second;
+            if (bandCloud.row_step != frame.cloud.row_step || band.band_count != frame.received.size()) {
+                return false;
+            }
+            if (!frame.received[band.band_index]) {
+                std::memcpy(&frame.cloud.data[(size_t) band.row_offset * frame.cloud.row_step], &bandCloud.data[0],
+                            (size_t) bandCloud.row_step * bandCloud.height);
+                frame.received[band.band_index] = true;
+                ++frame.receivedCount;
+            }
+            if (frame.receivedCount < frame.received.size()) {
+                return false;
+            }
+            cloud.header = frame.cloud.header;
+            cloud.fields.swap(frame.cloud.fields);
+            cloud.is_bigendian = frame.cloud.is_bigendian;
+            cloud.point_step = frame.cloud.point_step;
+            cloud.row_step = frame.cloud.row_step;
+            cloud.width = frame.cloud.width;
+            cloud.height = frame.cloud.height;
+            cloud.is_dense = false;
+            cloud.data.swap(frame.cloud.data);
+            pendingFrames.erase(it);
+            return true;
+        }
+
+        /**
+        * Number of frames with missing bands
+        */
+        size_t pendingFramesCount() const {
+            return pendingFrames.size();
+        }
+
+        /**
+        * Drop all the frames being assembled
+        */
+        void clear() {
+            pendingFrames.clear();
+        }
+
+    private:
+        struct PendingFrame {
+            sensor_msgs::PointCloud2 cloud;
+            std::vector<bool> received;
+            size_t receivedCount;
+        };
+
+        void dropOldFrames() {
+            //frame indexes increase, the lowest ones are the oldest
+            while (pendingFrames.size() > maxPendingFrames) {
+                pendingFrames.erase(pendingFrames.begin());
+            }
+        }
+
+        size_t maxPendingFrames;
+        std::map<uint64_t, PendingFrame> pendingFrames;
+    };
+}
+
+#endif //PROJECT_POINTCLOUDBANDASSEMBLER_H
@@ -11,6 +11,11 @@
 #include <ros/callback_queue.h>
 #include <camera_info_manager/camera_info_manager.h>
 #include <image_transport/image_transport.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
+#include <Eigen/StdVector>
 
 //dynamic reconfigure
 #include <dynamic_reconfigure/server.h>
@@ -36,8 +41,38 @@
 #include <phoxi_camera/GetSupportedCapturingModes.h>
 #include <phoxi_camera/SetCoordinatesSpace.h>
 #include <phoxi_camera/SetTransformationMatrix.h>
+#include <phoxi_camera/SaveTrace.h>
+#include <phoxi_camera/PointCloudBand.h>
+#include <phoxi_camera/DominantPlane.h>
+#include <phoxi_camera/PlaneDetector.h>
+#include <phoxi_camera/ExtractTsdf.h>
+#include <phoxi_camera/TsdfVolume.h>
+#include <phoxi_camera/PointCloudMesh.h>
+#include <phoxi_camera/PointCloudStatistics.h>
+#include <phoxi_camera/SceneChange.h>
+#include <phoxi_camera/SceneChangeDetector.h>
+#include <phoxi_camera/CaptureBackground.h>
+#include <phoxi_camera/BackgroundModel.h>
+#include <phoxi_camera/SetCaptureProfile.h>
+#include <phoxi_camera/AdaptiveQualityController.h>
+#include <phoxi_camera/FrameStatistics.h>
+#include <phoxi_camera/SharedMemoryFrameWriter.h>
+#include <phoxi_camera/ThreadScheduling.h>
+#include <map>
+#include <memory>
 
 
+/**
+ * Additional frame in which the point cloud is published, transformed on the host
+ */
+struct PointCloudTargetFrame {
+    std::string frameId;
+    ros::Publisher publisher;
+    bool useStaticTransform;
+    Eigen::Affine3d staticTransform;
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
 class RosInterface : protected  PhoXiInterface {
 public:
     RosInterface();
@@ -47,6 +82,72 @@ protected:
     int triggerImage();
     void connectCamera(std::string HWIdentification, pho::api::PhoXiTriggerMode mode = pho::api::PhoXiTriggerMode::Software, bool startAcquisition = true);
     std::string getTriggerMode(pho::api::PhoXiTriggerMode mode);
+    /**
+     * Convert frame to point cloud message using the point type selected in dynamic reconfigure
+     */
+    void getPointCloudMsgFromFrame(PFramePostProcessed frame, sensor_msgs::PointCloud2& output, const Eigen::Affine3f& transform = Eigen::Affine3f::Identity(), PointCloudStatistics* statistics = nullptr);
+    /**
+     * Convert frame to preview point cloud message using the point type, downsampling and pooling selected in dynamic reconfigure
+     */
+    void getPreviewPointCloudMsgFromFrame(PFramePostProcessed frame, sensor_msgs::PointCloud2& output);
+    /**
+     * Call function with a default constructed point of the type selected in dynamic reconfigure
+     */
+    template <typename Function>
+    void dispatchPointCloudType(Function function) {
+        switch (dynamicReconfigureConfig.point_cloud_type) {
+            case 0:
+                function(pcl::PointXYZ());
+                break;
+            case 1:
+                function(pcl::PointXYZI());
+                break;
+            case 2:
+                function(pcl::PointXYZRGB());
+                break;
+            default:
+                function(pcl::PointXYZRGBNormal());
+                break;
+        }
+    }
+    /**
+     * Publish the point cloud of the frame as a sequence of bands of rows, each band is published as soon as it is converted
+     */
+    void publishPointCloudBands(PFramePostProcessed frame, const std_msgs::Header& header, PointCloudStatistics* statistics = nullptr);
+    void publishMesh(PFramePostProcessed frame, const std_msgs::Header& header);
+    void publishPointCloudStatistics(PFramePostProcessed frame, const std_msgs::Header& header, const PointCloudStatistics& statistics);
+    /**
+     * Publish the points of the frame which differ from the learned background
+     */
+    void publishForegroundPointCloud(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Publish the point cloud of the frame in each of the additional target frames, the transformation of each target
+     * is fused into its conversion of the frame. The target point clouds are whole also when the point cloud is
+     * published in bands.
+     */
+    void publishPointCloudTargetFrames(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Publish the maximum height of the points of the frame in each cell of the height map grid
+     */
+    void publishHeightMap(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Estimate and publish the dominant plane of the frame, and its mask in mode PlaneLabeled
+     */
+    void publishDominantPlane(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Integrate the frame into the fusion volume with the pose of the scanner in tsdfFrameId at the stamp of the frame.
+     * The points must be in camera space for the rays to start at the scanner, frames in other coordinate spaces
+     * are not integrated.
+     */
+    void integrateTsdf(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Publish the centroids of the points of the frame in each voxel of voxel_grid_leaf_size
+     */
+    void publishVoxelGridPointCloud(PFramePostProcessed frame, const std_msgs::Header& header);
+    /**
+     * Camera info for images of size, from the calibration of the scanner or from camera_info_url
+     */
+    sensor_msgs::CameraInfo getCameraInfo(const pho::api::PhoXiSize& size, const std_msgs::Header& header);
 
     std::string frameId;
 private:
@@ -68,10 +169,48 @@ private:
     bool getSupportedCapturingModes(phoxi_camera::GetSupportedCapturingModes::Request &req, phoxi_camera::GetSupportedCapturingModes::Response &res);
     bool setCoordianteSpace(phoxi_camera::SetCoordinatesSpace::Request &req, phoxi_camera::SetCoordinatesSpace::Response &res);
     bool setTransformation(phoxi_camera::SetTransformationMatrix::Request &req, phoxi_camera::SetTransformationMatrix::Response &res);
+    bool startTraceCapture(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res);
+    bool stopTraceCapture(phoxi_camera::SaveTrace::Request &req, phoxi_camera::SaveTrace::Response &res);
+    bool captureBackground(phoxi_camera::CaptureBackground::Request &req, phoxi_camera::CaptureBackground::Response &res);
+    bool resetBackground(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res);
+    bool extractTsdf(phoxi_camera::ExtractTsdf::Request &req, phoxi_camera::ExtractTsdf::Response &res);
+    bool resetTsdf(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res);
+    bool setCaptureProfile(phoxi_camera::SetCaptureProfile::Request &req, phoxi_camera::SetCaptureProfile::Response &res);
     void dynamicReconfigureCallback(phoxi_camera::phoxi_cameraConfig &config, uint32_t level);
     void diagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status);
+    void frameStatisticsDiagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status);
+    void schedulingDiagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status);
     void diagnosticTimerCallback(const ros::TimerEvent&);
     void initFromPhoXi();
+    void updateScannerCameraInfo(const pho::api::PhoXiSize& size);
+    void updateTextureRectification();
+    void initPointCloudTargetFrames(bool latchTopics);
+    void initHeightMap(bool latchTopics);
+    void initCaptureProfiles();
+    void initThreadScheduling();
+    /**
+    * Scheduling configured in thread_scheduling for the driver thread, default scheduling if not configured
+    */
+    phoxi_camera::ThreadSchedulingConfig getThreadSchedulingConfig(const std::string& thread);
+    /**
+    * Apply the configured scheduling to the calling thread, failures are logged and reported in diagnostics
+    */
+    void applyThreadScheduling(const std::string& thread);
+    void applyAdaptiveQualityLevel(int level, int previousLevel);
+    /**
+    * Adaptive quality level 3 replaces the full resolution point clouds, bands and target frames by the point cloud
+    * decimated 2x
+    */
+    bool isPointCloudDecimated() const {
+        return dynamicReconfigureConfig.adaptive_quality && adaptiveQualityController.getLevel() >= 3;
+    }
+    /**
+    * Adaptive quality level 2 and above holds the scanner in low resolution, the configured resolution (from dynamic
+    * reconfigure or a capture profile) is only recorded and it is applied when the quality is restored
+    */
+    bool isResolutionReduced() const {
+        return dynamicReconfigureConfig.adaptive_quality && adaptiveQualityController.getLevel() >= 2;
+    }
 
     //node handle
     ros::NodeHandle nh;
@@ -95,9 +234,26 @@ private:
     ros::ServiceServer getSupportedCapturingModesService;
     ros::ServiceServer setCoordianteSpaceService;
     ros::ServiceServer setTransformationService;
+    ros::ServiceServer startTraceCaptureService;
+    ros::ServiceServer stopTraceCaptureService;
+    ros::ServiceServer captureBackgroundService;
+    ros::ServiceServer resetBackgroundService;
+    ros::ServiceServer extractTsdfService;
+    ros::ServiceServer resetTsdfService;
+    ros::ServiceServer setCaptureProfileService;
 
     //ros publishers
     ros::Publisher cloudPub;
+    ros::Publisher previewCloudPub;
+    ros::Publisher voxelGridCloudPub;
+    ros::Publisher cloudBandsPub;
+    ros::Publisher sceneChangePub;
+    ros::Publisher cloudStatisticsPub;
+    ros::Publisher meshPub;
+    ros::Publisher planePub;
+    ros::Publisher planeMaskPub;
+    ros::Publisher tsdfCloudPub;
+    ros::Publisher foregroundCloudPub;
     ros::Publisher normalMapPub;
     ros::Publisher confidenceMapPub;
     ros::Publisher depthMapPub;
@@ -105,6 +261,66 @@ private:
     image_transport::ImageTransport mono8ImageTransport;
     camera_info_manager::CameraInfoManager mono8CameraInfoManager;
     image_transport::CameraPublisher mono8CameraPublisher;
+    image_transport::Publisher rectifiedImagePub;
+    ros::Publisher depthCameraInfoPub;
+    ros::Publisher textureCameraInfoPub;
+
+    //outputs of the scanner before depth_only was enabled
+    pho::api::PhoXiOutputSettings depthOnlyPreviousOutputs;
+
+    //camera_info read from the scanner, cached for the resolution of the last frame
+    bool cameraInfoFromScanner;
+    sensor_msgs::CameraInfo scannerCameraInfo;
+
+    //point cloud in additional frames
+    tf2_ros::Buffer tfBuffer;
+    tf2_ros::TransformListener tfListener;
+    std::vector<PointCloudTargetFrame, Eigen::aligned_allocator<PointCloudTargetFrame>> pointCloudTargetFrames;
+    double pointCloudTargetFramesTfTimeout;
+
+    //suppression of point clouds of static scenes
+    phoxi_camera::SceneChangeDetector sceneChangeDetector;
+
+    //foreground point cloud
+    phoxi_camera::BackgroundModel backgroundModel;
+    std::vector<uint8_t> foregroundMask;
+
+    //capture profiles
+    std::map<std::string, CaptureProfile> captureProfiles;
+    std::string activeCaptureProfile;
+    double captureProfileSwitchLatency;
+
+    //deadline aware quality control
+    phoxi_camera::AdaptiveQualityController adaptiveQualityController;
+    double lastFrameLatency;
+
+    //triangulated point cloud, buffers reused between frames
+    OrganizedMesh mesh;
+
+    //height map, published in the frame of heightMapFrame with its publisher
+    PointCloudTargetFrame heightMapFrame;
+    HeightMap heightMap;
+
+    //dominant plane, buffers reused between frames
+    phoxi_camera::PlaneDetector planeDetector;
+    std::vector<Eigen::Vector3f> planeSamples;
+    std::vector<uint8_t> planeMask;
+
+    //multi-view fusion in tsdfFrameId, buffers reused between frames
+    phoxi_camera::TsdfVolume tsdfVolume;
+    std::string tsdfFrameId;
+    std::vector<Eigen::Vector3f> tsdfPoints;
+    std::vector<uint8_t> tsdfIntensities;
+
+    //frames for consumers on the same host outside of ROS
+    std::unique_ptr<phoxi_camera::SharedMemoryFrameWriter> sharedMemoryFrameWriter;
+
+    //real-time scheduling of the driver threads
+    XmlRpc::XmlRpcValue threadSchedulingParameters;
+    std::map<std::string, std::string> threadSchedulingStates;
+    bool threadSchedulingFailed;
+    std::string memoryLockState;
+    phoxi_camera::SchedulingJitterProbe schedulingJitterProbe;
 
     //dynamic reconfigure
     boost::recursive_mutex dynamicReconfigureMutex;
@@ -114,7 +330,17 @@ private:
     //diagnostic
     diagnostic_updater::Updater diagnosticUpdater;
     diagnostic_updater::FunctionDiagnosticTask PhoXi3DscannerDiagnosticTask;
+    diagnostic_updater::FunctionDiagnosticTask FrameStatisticsDiagnosticTask;
+    diagnostic_updater::FunctionDiagnosticTask SchedulingDiagnosticTask;
     ros::Timer diagnosticTimer;
+    phoxi_camera::FrameStatistics frameStatistics;
+    phoxi_camera::FrameStatistics::Snapshot previousFrameStatistics;
+    double diagnosticsMinFrameRate;
+    double diagnosticsMaxFrameAge;
+    double diagnosticsLatencyWarn;
+    double diagnosticsLatencyError;
+    double diagnosticsDropRatioWarn;
+    double diagnosticsDropRatioError;
 
 };
 
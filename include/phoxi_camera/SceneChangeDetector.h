@@ -0,0 +1,75 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_SCENECHANGEDETECTOR_H
+#define PROJECT_SCENECHANGEDETECTOR_H
+
+#include <PhoXi.h>
+#include <cstdint>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* SceneChangeDetector
+    /**
+     * Detects if the scene seen by the scanner changed since the last frame reported as changed.
+     *
+     * The depth of every subsampling-th pixel of every subsampling-th row is gathered into a contiguous buffer
+     * and compared against the reference buffer with a branch-free loop (auto-vectorized by the compiler).
+     * The scene is changed when the ratio of samples whose depth differs by more than depthThreshold
+     * (invalid points have depth 0) is above minChangedRatio. The reference is replaced only by changed frames,
+     * so slow drifts of the scene are accumulated until they are detected.
+     */
+    class SceneChangeDetector {
+    public:
+        SceneChangeDetector();
+        /**
+        * Set detection parameters
+        *
+        * \param subsampling - distance in pixels between samples in both directions
+        * \param depthThreshold - depth difference in mm above which a sample is changed
+        * \param minChangedRatio - ratio of changed samples above which the scene is changed
+        * \param maxUnchangedFrames - frames reported as changed after this number of consecutive unchanged frames, 0 for no limit
+        */
+        void setParameters(int subsampling, float depthThreshold, float minChangedRatio, int maxUnchangedFrames);
+        /**
+        * Compare the frame with the reference
+        *
+        * \return true if the scene changed, the frame becomes the new reference
+        */
+        bool update(const pho::api::Frame& frame);
+        /**
+        * Drop the reference, next frame is reported as changed
+        */
+        void reset();
+        /**
+        * Ratio of changed samples of the last updated frame
+        */
+        float getChangedRatio() const {
+            return changedRatio;
+        }
+        /**
+        * Number of consecutive unchanged frames
+        */
+        uint32_t getUnchangedFrames() const {
+            return unchangedFrames;
+        }
+
+    private:
+        void gatherSamples(const pho::api::Frame& frame, std::vector<float>& samples);
+
+        int subsampling;
+        float depthThreshold;
+        float minChangedRatio;
+        int maxUnchangedFrames;
+        int referenceWidth;
+        int referenceHeight;
+        std::vector<float> reference;
+        std::vector<float> current;
+        float changedRatio;
+        uint32_t unchangedFrames;
+    };
+}
+
+#endif //PROJECT_SCENECHANGEDETECTOR_H
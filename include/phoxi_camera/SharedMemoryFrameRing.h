@@ -0,0 +1,273 @@
+//
+// Created by controller on 10/19/26.
+//
+// Layout of the shared memory frame ring and header-only client, it depends only on the standard and POSIX libraries
+// so that processes outside of ROS can read the frames of the phoxi_camera node.
+//
+
+#ifndef PROJECT_SHAREDMEMORYFRAMERING_H
+#define PROJECT_SHAREDMEMORYFRAMERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "phoxi_camera/PhoXiException.h"
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "The shared memory frame ring requires lock free 64 bit atomics"
+#endif
+
+namespace phoxi_camera {
+
+    namespace SharedMemoryFrameRing {
+        const uint32_t Magic = 0x52584850;      //"PHXR"
+        const uint32_t Version = 1;
+        const size_t Alignment = 64;
+
+        /**
+         * Maps of a frame, stored row major with the resolution of the frame
+         */
+        enum Channel {
+            PointCloud = 0,     ///< 3 x float32 per pixel, in millimeters
+            NormalMap,          ///< 3 x float32 per pixel
+            DepthMap,           ///< float32 per pixel, in millimeters
+            ConfidenceMap,      ///< float32 per pixel
+            Texture,            ///< float32 per pixel
+            ChannelCount
+        };
+
+        inline size_t channelPixelSize(int channel) {
+            return channel == PointCloud || channel == NormalMap ? 3 * sizeof(float) : sizeof(float);
+        }
+
+        inline size_t align(size_t bytes) {
+            return (bytes + Alignment - 1) / Alignment * Alignment;
+        }
+
+        struct alignas(64) RingHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t slotCount;
+            uint32_t maxWidth;
+            uint32_t maxHeight;
+            uint32_t reserved;
+            uint64_t slotSize;                  ///< bytes of a slot including its header
+            std::atomic<uint64_t> lastSequence; ///< sequence of the last completely written frame, 0 before the first
+        };
+
+        struct ChannelInfo {
+            uint64_t offset;                    ///< from the beginning of the slot
+            uint64_t bytes;                     ///< 0 when the map was not sent by the scanner
+        };
+
+        /**
+         * Frame with sequence n is written to slot n % slotCount. The slot is guarded by a sequence lock,
+         * lock is 2n - 1 while the frame is written and 2n once it is complete.
+         */
+        struct alignas(64) SlotHeader {
+            std::atomic<uint64_t> lock;
+            uint64_t frameIndex;
+            int64_t stamp;                      ///< in nanoseconds since epoch
+            uint32_t width;
+            uint32_t height;
+            ChannelInfo channels[ChannelCount];
+        };
+
+        inline size_t slotSize(uint32_t maxWidth, uint32_t maxHeight) {
+            size_t bytes = align(sizeof(SlotHeader));
+            for (int channel = 0; channel < ChannelCount; ++channel) {
+                bytes += align((size_t) maxWidth * maxHeight * channelPixelSize(channel));
+            }
+            return bytes;
+        }
+
+        inline size_t ringSize(uint32_t slotCount, uint32_t maxWidth, uint32_t maxHeight) {
+            return align(sizeof(RingHeader)) + (size_t) slotCount * slotSize(maxWidth, maxHeight);
+        }
+    }
+
+    //* SharedMemoryFrameView
+    /**
+     * Frame mapped from the ring without copies. The slot may be overwritten by the writer at any time,
+     * results computed from the maps are valid only when SharedMemoryFrameReader::isValid returns true afterwards.
+     */
+    struct SharedMemoryFrameView {
+        uint64_t sequence;
+        uint64_t frameIndex;
+        int64_t stamp;
+        uint32_t width;
+        uint32_t height;
+        SharedMemoryFrameRing::ChannelInfo channels[SharedMemoryFrameRing::ChannelCount];
+        const uint8_t* slot;
+        const std::atomic<uint64_t>* lock;
+
+        /**
+        * \return null when the map was not sent
+        */
+        const float* channel(SharedMemoryFrameRing::Channel channel) const {
+            return channels[channel].bytes ? reinterpret_cast<const float*>(slot + channels[channel].offset) : nullptr;
+        }
+        const float* pointCloud() const { return channel(SharedMemoryFrameRing::PointCloud); }
+        const float* normalMap() const { return channel(SharedMemoryFrameRing::NormalMap); }
+        const float* depthMap() const { return channel(SharedMemoryFrameRing::DepthMap); }
+        const float* confidenceMap() const { return channel(SharedMemoryFrameRing::ConfidenceMap); }
+        const float* texture() const { return channel(SharedMemoryFrameRing::Texture); }
+    };
+
+    //* SharedMemoryFrameReader
+    /**
+     * Read only client of the shared memory frame ring published by the phoxi_camera node
+     * with the shared_memory_name parameter
+     *
+     * \code
+     * phoxi_camera::SharedMemoryFrameReader reader("/phoxi_camera");
+     * phoxi_camera::SharedMemoryFrameView frame;
+     * if (reader.next(frame)) {
+     *     process(frame.pointCloud(), frame.width, frame.height);
+     *     if (!reader.isValid(frame)) {
+     *         //the slot was overwritten while processing, discard the results
+     *     }
+     * }
+     * \endcode
+     */
+    class SharedMemoryFrameReader {
+    public:
+        /**
+        * Map the ring, it must be already created by the node
+        *
+        * \param name - name of the POSIX shared memory object
+        * \throw SharedMemoryError when the ring does not exist or has a different layout version
+        */
+        explicit SharedMemoryFrameReader(const std::string& name) : ring(nullptr), ringBytes(0), lastSequence(0), skippedFrames(0) {
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                throw SharedMemoryError("Shared memory " + name + " not found!");
+            }
+            struct stat info;
+            if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(SharedMemoryFrameRing::RingHeader)) {
+                close(fd);
+                throw SharedMemoryError("Shared memory " + name + " is not initialized!");
+            }
+            ringBytes = (size_t) info.st_size;
+            void* memory = mmap(nullptr, ringBytes, PROT_READ, MAP_SHARED, fd, 0);
+            close(fd);
+            if (memory == MAP_FAILED) {
+                throw SharedMemoryError("Unable to map shared memory " + name + "!");
+            }
+            ring = static_cast<const uint8_t*>(memory);
+            const SharedMemoryFrameRing::RingHeader* header = ringHeader();
+            if (header->magic != SharedMemoryFrameRing::Magic || header->version != SharedMemoryFrameRing::Version ||
+                SharedMemoryFrameRing::ringSize(header->slotCount, header->maxWidth, header->maxHeight) > ringBytes) {
+                munmap(const_cast<uint8_t*>(ring), ringBytes);
+                throw SharedMemoryError("Shared memory " + name + " has incompatible layout!");
+            }
+        }
+
+        ~SharedMemoryFrameReader() {
+            munmap(const_cast<uint8_t*>(ring), ringBytes);
+        }
+
+        SharedMemoryFrameReader(const SharedMemoryFrameReader&) = delete;
+        SharedMemoryFrameReader& operator=(const SharedMemoryFrameReader&) = delete;
+
+        /**
+        * Map the newest frame, frames between the last read and the newest are skipped
+        *
+        * \return false when there is no frame newer than the last read
+        */
+        bool latest(SharedMemoryFrameView& view) {
+            const uint64_t newest = ringHeader()->lastSequence.load(std::memory_order_acquire);
+            if (newest <= lastSequence) {
+                return false;
+            }
+            if (acquire(newest, view)) {
+                skippedFrames += newest - lastSequence - 1;
+                lastSequence = newest;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+        * Map the frame following the last read, frames which were already overwritten are skipped
+        *
+        * \return false when there is no frame newer than the last read
+        */
+        bool next(SharedMemoryFrameView& view) {
+            const SharedMemoryFrameRing::RingHeader* header = ringHeader();
+            for (;;) {
+                const uint64_t newest = header->lastSequence.load(std::memory_order_acquire);
+                if (newest <= lastSequence) {
+                    return false;
+                }
+                uint64_t sequence = lastSequence + 1;
+                //older frames were overwritten, the oldest one left may be overwritten next
+                if (newest - sequence >= header->slotCount) {
+                    sequence = newest - header->slotCount + 1;
+                }
+                skippedFrames += sequence - lastSequence - 1;
+                lastSequence = sequence;
+                if (acquire(sequence, view)) {
+                    return true;
+                }
+                ++skippedFrames;
+            }
+        }
+
+        /**
+        * Check that the slot of view was not overwritten since it was mapped
+        */
+        bool isValid(const SharedMemoryFrameView& view) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return view.lock->load(std::memory_order_relaxed) == 2 * view.sequence;
+        }
+
+        /**
+        * \return number of frames which were overwritten before they were read
+        */
+        uint64_t getSkippedFrames() const {
+            return skippedFrames;
+        }
+
+    private:
+        const SharedMemoryFrameRing::RingHeader* ringHeader() const {
+            return reinterpret_cast<const SharedMemoryFrameRing::RingHeader*>(ring);
+        }
+
+        bool acquire(uint64_t sequence, SharedMemoryFrameView& view) const {
+            const SharedMemoryFrameRing::RingHeader* header = ringHeader();
+            const uint8_t* slot = ring + SharedMemoryFrameRing::align(sizeof(SharedMemoryFrameRing::RingHeader)) +
+                                  (sequence % header->slotCount) * header->slotSize;
+            const SharedMemoryFrameRing::SlotHeader* slotHeader = reinterpret_cast<const SharedMemoryFrameRing::SlotHeader*>(slot);
+            if (slotHeader->lock.load(std::memory_order_acquire) != 2 * sequence) {
+                return false;
+            }
+            view.sequence = sequence;
+            view.frameIndex = slotHeader->frameIndex;
+            view.stamp = slotHeader->stamp;
+            view.width = slotHeader->width;
+            view.height = slotHeader->height;
+            for (int channel = 0; channel < SharedMemoryFrameRing::ChannelCount; ++channel) {
+                view.channels[channel] = slotHeader->channels[channel];
+            }
+            view.slot = slot;
+            view.lock = &slotHeader->lock;
+            //the slot header fields are validated like the maps
+            return isValid(view);
+        }
+
+        const uint8_t* ring;
+        size_t ringBytes;
+        uint64_t lastSequence;
+        uint64_t skippedFrames;
+    };
+}
+
+#endif //PROJECT_SHAREDMEMORYFRAMERING_H
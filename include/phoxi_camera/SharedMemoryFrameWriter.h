@@ -0,0 +1,59 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_SHAREDMEMORYFRAMEWRITER_H
+#define PROJECT_SHAREDMEMORYFRAMEWRITER_H
+
+#include <PhoXi.h>
+#include <cstdint>
+#include <string>
+
+#include "phoxi_camera/SharedMemoryFrameRing.h"
+
+namespace phoxi_camera {
+
+    //* SharedMemoryFrameWriter
+    /**
+     * Creates the POSIX shared memory frame ring and copies the maps of each frame into its next slot,
+     * read by SharedMemoryFrameReader in other processes without serialization
+     */
+    class SharedMemoryFrameWriter {
+    public:
+        /**
+        * Create the ring, an existing ring with the same name is replaced
+        *
+        * \param name - name of the POSIX shared memory object, for example /phoxi_camera
+        * \param slotCount - number of frames kept in the ring
+        * \param maxWidth, maxHeight - biggest resolution of the frames, bigger frames are not written
+        * \throw SharedMemoryError when the shared memory can not be created
+        */
+        SharedMemoryFrameWriter(const std::string& name, uint32_t slotCount, uint32_t maxWidth, uint32_t maxHeight);
+        ~SharedMemoryFrameWriter();
+
+        SharedMemoryFrameWriter(const SharedMemoryFrameWriter&) = delete;
+        SharedMemoryFrameWriter& operator=(const SharedMemoryFrameWriter&) = delete;
+
+        /**
+        * Copy maps of frame into the next slot
+        *
+        * \param stamp - in nanoseconds since epoch
+        * \return false when the frame is bigger than the slots
+        */
+        bool write(const pho::api::Frame& frame, int64_t stamp);
+        /**
+        * Back the ring with transparent huge pages, the kernel must allow them for shared memory (shmem_enabled)
+        *
+        * \return false if the kernel refused the advice
+        */
+        bool adviseHugePages();
+        const std::string& getName() const;
+
+    private:
+        std::string name;
+        uint8_t* ring;
+        size_t ringBytes;
+    };
+}
+
+#endif //PROJECT_SHAREDMEMORYFRAMEWRITER_H
@@ -0,0 +1,75 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_THREADPOOL_H
+#define PROJECT_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* ThreadPool
+    /**
+     * Persistent worker threads for data parallel loops over the rows of a frame. The calling thread works
+     * on the loop too, so a pool without workers runs the loops inline. Loops of concurrent callers are serialized.
+     */
+    class ThreadPool {
+    public:
+        ThreadPool();
+        ~ThreadPool();
+        /**
+        * Start the worker threads, running workers are stopped first
+        *
+        * \param threads - number of threads working on a loop including the calling thread,
+        * the number of hardware threads if <= 0
+        * \param initializer - called by each worker before its first loop, for example to set its scheduling.
+        * start returns when all the workers were initialized.
+        */
+        void start(int threads, const std::function<void()>& initializer = std::function<void()>());
+        void stop();
+        /**
+        * Number of threads working on a loop including the calling thread
+        */
+        int getThreadCount() const;
+        /**
+        * Split [begin, end) into chunks of at least minChunk iterations and call body(chunkBegin, chunkEnd)
+        * for each of them from the workers and the calling thread, returns when all chunks are done.
+        * If body throws, the chunks not started yet are skipped and the first exception is rethrown
+        * by parallelFor once all the threads left the loop.
+        */
+        void parallelFor(int begin, int end, const std::function<void(int, int)>& body, int minChunk = 1);
+
+    private:
+        void run(std::function<void()> initializer);
+        void runChunks();
+
+        std::vector<std::thread> workers;
+        std::mutex loopMutex;               ///< serializes the loops of concurrent callers
+
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workDone;
+        bool stopping;
+        uint64_t generation;                ///< incremented for each loop
+        int initializedWorkers;
+        int activeWorkers;
+
+        const std::function<void(int, int)>* body;
+        int begin;
+        int end;
+        int chunkSize;
+        int chunkCount;
+        std::atomic<int> nextChunk;
+        std::exception_ptr firstException;  ///< first exception thrown by body in the current loop
+    };
+}
+
+#endif //PROJECT_THREADPOOL_H
@@ -0,0 +1,104 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_THREADSCHEDULING_H
+#define PROJECT_THREADSCHEDULING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace phoxi_camera {
+
+    /**
+     * Scheduling of a driver thread, the default values keep the scheduling inherited from the creating thread
+     */
+    struct ThreadSchedulingConfig {
+        ThreadSchedulingConfig() : policy("other"), priority(0), numaNode(-1) {
+        }
+        std::string policy;         ///< other, fifo or rr
+        int priority;               ///< 1 - 99 for fifo and rr
+        std::vector<int> cpus;      ///< CPUs the thread may run on, all if empty
+        int numaNode;               ///< restricts cpus to the CPUs of the NUMA node, any if < 0
+    };
+
+    /**
+    * Apply config to the calling thread. With a NUMA node, the memory allocated by the thread is placed on the node
+    * by the first touch policy of the kernel.
+    *
+    * \throw ThreadSchedulingError when the policy is unknown or the thread is not permitted to use it
+    * (SCHED_FIFO and SCHED_RR need CAP_SYS_NICE or an rtprio limit)
+    * \return description of the applied scheduling
+    */
+    std::string applyThreadScheduling(const ThreadSchedulingConfig& config);
+
+    /**
+    * CPUs of NUMA node read from sysfs
+    *
+    * \return empty when the node does not exist
+    */
+    std::vector<int> numaNodeCpus(int node);
+
+    /**
+    * Lock the current and future memory of the process in RAM and keep freed frame buffers in the heap, so that
+    * the buffers of the following frames are reused without page faults
+    *
+    * \throw ThreadSchedulingError when the memory can not be locked (RLIMIT_MEMLOCK)
+    */
+    void lockProcessMemory();
+
+    /**
+    * Back the memory range with transparent huge pages if the kernel allows it
+    *
+    * \return false if the kernel refused the advice
+    */
+    bool adviseHugePages(void* memory, size_t bytes);
+
+    //* SchedulingJitterProbe
+    /**
+     * Thread with the scheduling of a driver thread which wakes up periodically and measures how late it runs,
+     * like cyclictest. The wake-up latencies show the preemption the driver threads suffer with their scheduling.
+     */
+    class SchedulingJitterProbe {
+    public:
+        static const int JitterBuckets = 64;
+
+        struct Snapshot {
+            uint64_t samples;
+            double jitterP50;       ///< in seconds
+            double jitterP99;
+            double jitterMax;
+        };
+
+        SchedulingJitterProbe();
+        ~SchedulingJitterProbe();
+        /**
+        * Start the probe thread, a running probe is restarted
+        *
+        * \param period - in seconds
+        * \param config - scheduling of the probe thread, failures are ignored
+        */
+        void start(double period, const ThreadSchedulingConfig& config);
+        void stop();
+        bool isRunning() const;
+        /**
+        * Percentiles of the wake-up latencies since the previous snapshot
+        */
+        Snapshot snapshot();
+
+    private:
+        void run(int64_t periodNanoseconds, ThreadSchedulingConfig config);
+        static int jitterBucket(int64_t nanoseconds);
+        static double bucketUpperBound(int bucket);
+
+        std::thread thread;
+        std::atomic<bool> running;
+        std::atomic<uint64_t> jitterHistogram[JitterBuckets];
+        std::atomic<int64_t> jitterMaxNanoseconds;
+    };
+}
+
+#endif //PROJECT_THREADSCHEDULING_H
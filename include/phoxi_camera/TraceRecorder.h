@@ -0,0 +1,136 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_TRACERECORDER_H
+#define PROJECT_TRACERECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace phoxi_camera {
+
+    /**
+     * Event recorded by the TraceRecorder, name and category must be string literals
+     */
+    struct TraceEvent {
+        const char* name;
+        const char* category;
+        int64_t timestamp;
+        int64_t duration;
+        int64_t frameIndex;
+        bool instant;
+    };
+
+    //* TraceRecorder
+    /**
+     * Records trace events of the driver into per-thread buffers and exports them as Chrome/Perfetto JSON trace files
+     * (open them in chrome://tracing or https://ui.perfetto.dev).
+     *
+     * Recording an event does not take any lock, each thread appends to its own fixed size buffer which is
+     * registered once per thread. When the buffer of a thread is full, its following events are dropped.
+     * The buffer is freed when its thread exits, or by the next stop when it holds events of the running capture.
+     */
+    class TraceRecorder {
+    public:
+        /**
+        * Recorder shared by all the threads of the process
+        */
+        static TraceRecorder& instance();
+        /**
+        * Start a new capture, events of previous captures are discarded
+        *
+        * \param eventsPerThread - capacity of the buffer of each thread, used only for threads recording their first event
+        */
+        void start(size_t eventsPerThread = 65536);
+        /**
+        * Stop the capture and write the recorded events to a Chrome/Perfetto JSON trace file
+        *
+        * \return number of events written
+        * \throw UnableToWriteTrace when the file could not be written
+        */
+        size_t stop(const std::string& path);
+        /**
+        * Test if events are being recorded
+        */
+        bool isRecording() const {
+            return recording.load(std::memory_order_relaxed);
+        }
+        /**
+        * Record an event which started at timestamp and took duration microseconds
+        */
+        void record(const char* name, const char* category, int64_t timestamp, int64_t duration, int64_t frameIndex = -1);
+        /**
+        * Record an instant event happening now
+        */
+        void recordInstant(const char* name, const char* category, int64_t frameIndex = -1);
+        /**
+        * Monotonic time in microseconds used for the timestamps of the events
+        */
+        static int64_t now();
+
+    private:
+        struct ThreadBuffer {
+            std::unique_ptr<TraceEvent[]> events;
+            size_t capacity;
+            std::atomic<size_t> size;
+            std::atomic<uint64_t> session;
+            int threadId;
+            bool exited;                    ///< the thread exited, guarded by buffersMutex
+        };
+        //thread local owner releasing the buffer when the thread exits
+        struct ThreadBufferOwner {
+            ThreadBuffer* buffer;
+            ~ThreadBufferOwner();
+        };
+
+        TraceRecorder();
+        ThreadBuffer* threadBuffer();
+        void append(const TraceEvent& event);
+        void releaseThreadBuffer(ThreadBuffer* buffer);
+        /**
+        * Free the buffers of the exited threads, buffersMutex must be held
+        */
+        void removeExitedBuffers();
+
+        std::atomic<bool> recording;
+        std::atomic<uint64_t> session;
+        std::atomic<size_t> eventsPerThread;
+        std::mutex buffersMutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    };
+
+    //* TraceScope
+    /**
+     * Records a trace event covering the lifetime of the object, costs a relaxed atomic load when not recording
+     */
+    class TraceScope {
+    public:
+        TraceScope(const char* name, const char* category, int64_t frameIndex = -1) :
+                name(name), category(category), frameIndex(frameIndex),
+                start(TraceRecorder::instance().isRecording() ? TraceRecorder::now() : -1) {
+        }
+        ~TraceScope() {
+            if (start >= 0 && TraceRecorder::instance().isRecording()) {
+                TraceRecorder::instance().record(name, category, start, TraceRecorder::now() - start, frameIndex);
+            }
+        }
+        /**
+        * Set the frame index when it is known only after the start of the scope
+        */
+        void setFrameIndex(int64_t index) {
+            frameIndex = index;
+        }
+    private:
+        const char* name;
+        const char* category;
+        int64_t frameIndex;
+        int64_t start;
+    };
+}
+
+#endif //PROJECT_TRACERECORDER_H
@@ -0,0 +1,112 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#ifndef PROJECT_TSDFVOLUME_H
+#define PROJECT_TSDFVOLUME_H
+
+#include <phoxi_camera/ThreadPool.h>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace phoxi_camera {
+
+    //* TsdfVolume
+    /**
+     * Truncated signed distance function fused from the point clouds of several scanner poses, for example
+     * with the scanner on the wrist of a robot, to get a single cloud of a scene that no single view covers.
+     *
+     * The volume is sparse: only the blocks of BlockSize^3 voxels within the truncation distance of an integrated
+     * point are allocated, in a hash map of the block coordinates. A frame is integrated in two parallel passes over
+     * its points: the first gathers the blocks crossed by the truncated rays, which are allocated by the calling
+     * thread, and the second updates the voxels of these blocks, each block guarded by one of a set of striped locks.
+     */
+    class TsdfVolume {
+    public:
+        static const int BlockSize = 8;
+        static const int BlockVoxels = BlockSize * BlockSize * BlockSize;
+
+        struct Voxel {
+            float distance;             ///< weighted mean signed distance to the surface in meters, positive in front of it
+            float weight;               ///< accumulated weight, 0 for voxels that were never observed
+            float intensity;            ///< weighted mean texture intensity
+        };
+        struct Block {
+            Voxel voxels[BlockVoxels];  ///< x fastest, then y, then z
+        };
+
+        TsdfVolume();
+        /**
+        * Set the fusion parameters, the volume is reset when the voxel size or the truncation distance change
+        *
+        * \param voxelSize - edge of a voxel in meters
+        * \param truncationDistance - distances to the surface are truncated to this value in meters,
+        * at least one voxel
+        * \param maxWeight - the weight of a voxel saturates at this value, so that the volume keeps adapting
+        * to changes of the scene
+        */
+        void setParameters(float voxelSize, float truncationDistance, float maxWeight);
+        /**
+        * Integrate the points of one view
+        *
+        * \param points - valid points in meters in the frame of the sensor, with the sensor at its origin.
+        * Points in another frame, for example in the marker or robot space of the scanner, give rays that do not
+        * start at the sensor and carve free space in the wrong places.
+        * \param intensities - texture intensity of each point, or empty
+        * \param pose - transformation from the frame of the sensor to the frame of the volume,
+        * its translation is the origin of the rays
+        */
+        void integrate(const std::vector<Eigen::Vector3f>& points, const std::vector<uint8_t>& intensities,
+                       const Eigen::Affine3f& pose, ThreadPool& threadPool);
+        /**
+        * Extract the zero crossings of the distance between neighbouring voxels
+        *
+        * \param points - output surface points in meters in the frame of the volume
+        * \param intensities - output intensity of each surface point
+        * \param minWeight - voxels with a lower weight are ignored, observed voxels are used if <= 0
+        */
+        void extractSurface(std::vector<Eigen::Vector3f>& points, std::vector<uint8_t>& intensities,
+                            float minWeight, ThreadPool& threadPool) const;
+        /**
+        * Free all the blocks
+        */
+        void reset();
+        size_t getBlockCount() const {
+            return blocks.size();
+        }
+        size_t getVoxelCount() const {
+            return blocks.size() * BlockVoxels;
+        }
+        /**
+        * Approximate heap memory of the blocks and of the hash map in bytes
+        */
+        size_t getMemoryUsage() const;
+        uint32_t getIntegratedFrames() const {
+            return integratedFrames;
+        }
+        float getVoxelSize() const {
+            return voxelSize;
+        }
+
+    private:
+        static const int LockStripes = 1024;
+
+        static uint64_t blockKey(int x, int y, int z);
+        static Eigen::Vector3i blockCoordinates(uint64_t key);
+        const Voxel* findVoxel(const Eigen::Vector3i& voxel) const;
+
+        float voxelSize;
+        float truncationDistance;
+        float maxWeight;
+        uint32_t integratedFrames;
+        std::unordered_map<uint64_t, std::unique_ptr<Block>> blocks;
+        std::unique_ptr<std::mutex[]> blockLocks;     ///< block with key k is guarded by blockLocks[k % LockStripes]
+    };
+}
+
+#endif //PROJECT_TSDFVOLUME_H
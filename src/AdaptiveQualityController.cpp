@@ -0,0 +1,58 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/AdaptiveQualityController.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace phoxi_camera {
+
+    namespace {
+        const double latencyFilterWeight = 0.3;
+    }
+
+    AdaptiveQualityController::AdaptiveQualityController() : deadline(1.0), headroom(0.6), maxLevel(0), holdFrames(3),
+                                                             level(0), framesSinceChange(0), filteredLatency(0.0) {
+    }
+
+    void AdaptiveQualityController::setParameters(double deadline, double headroom, int maxLevel, int holdFrames) {
+        this->deadline = std::max(0.0, deadline);
+        this->headroom = std::max(0.0, std::min(headroom, 1.0));
+        this->maxLevel = std::max(0, maxLevel);
+        this->holdFrames = std::max(1, holdFrames);
+        if (level > this->maxLevel) {
+            setLevel(this->maxLevel, "max level decreased");
+        }
+    }
+
+    void AdaptiveQualityController::reset() {
+        level = 0;
+        framesSinceChange = 0;
+        filteredLatency = 0.0;
+        lastDecision.clear();
+    }
+
+    bool AdaptiveQualityController::update(double latency) {
+        filteredLatency = framesSinceChange == 0 ? latency : latencyFilterWeight * latency + (1.0 - latencyFilterWeight) * filteredLatency;
+        ++framesSinceChange;
+        char reason[128];
+        if (latency > deadline && level < maxLevel) {
+            std::snprintf(reason, sizeof(reason), "latency %.3f s above deadline %.3f s", latency, deadline);
+            setLevel(level + 1, reason);
+            return true;
+        }
+        if (level > 0 && framesSinceChange >= holdFrames && filteredLatency < headroom * deadline) {
+            std::snprintf(reason, sizeof(reason), "filtered latency %.3f s below %.3f s", filteredLatency, headroom * deadline);
+            setLevel(level - 1, reason);
+            return true;
+        }
+        return false;
+    }
+
+    void AdaptiveQualityController::setLevel(int newLevel, const std::string& reason) {
+        lastDecision = std::string(newLevel > level ? "decreased" : "increased") + " quality to level " + std::to_string(newLevel) + ": " + reason;
+        level = newLevel;
+        framesSinceChange = 0;
+    }
+}
@@ -0,0 +1,83 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/BackgroundModel.h"
+#include <cmath>
+#include <limits>
+
+namespace phoxi_camera {
+
+    namespace {
+        inline float pointDistance(const pho::api::Point3_32f& point) {
+            return std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z);
+        }
+    }
+
+    BackgroundModel::BackgroundModel() : width(0), height(0), learnedFrames(0) {
+    }
+
+    void BackgroundModel::reset() {
+        width = 0;
+        height = 0;
+        learnedFrames = 0;
+        depthSum.clear();
+        depthCount.clear();
+        background.clear();
+    }
+
+    void BackgroundModel::addFrame(const pho::api::Frame& frame) {
+        const int frameWidth = frame.PointCloud.Size.Width;
+        const int frameHeight = frame.PointCloud.Size.Height;
+        if (frame.PointCloud.Empty()) {
+            return;
+        }
+        if (frameWidth != width || frameHeight != height) {
+            reset();
+            width = frameWidth;
+            height = frameHeight;
+            depthSum.assign((size_t) width * height, 0.0f);
+            depthCount.assign((size_t) width * height, 0);
+            background.assign((size_t) width * height, 0.0f);
+        }
+        //the per pixel counters would overflow
+        if (learnedFrames >= std::numeric_limits<uint16_t>::max()) {
+            return;
+        }
+        for (int r = 0; r < height; ++r) {
+            const pho::api::Point3_32f* points = frame.PointCloud[r];
+            float* sum = &depthSum[(size_t) r * width];
+            uint16_t* count = &depthCount[(size_t) r * width];
+            float* mean = &background[(size_t) r * width];
+            for (int c = 0; c < width; ++c) {
+                const float distance = pointDistance(points[c]);
+                const uint16_t valid = distance > 0.0f;
+                sum[c] += distance;
+                count[c] += valid;
+                //pixels without any valid point keep a background distance of 0
+                mean[c] = count[c] ? sum[c] / count[c] : 0.0f;
+            }
+        }
+        ++learnedFrames;
+    }
+
+    size_t BackgroundModel::computeForegroundMask(const pho::api::Frame& frame, float depthThreshold, std::vector<uint8_t>& mask) const {
+        const int frameWidth = frame.PointCloud.Size.Width;
+        const int frameHeight = frame.PointCloud.Size.Height;
+        const bool backgroundAvailable = isLearned() && frameWidth == width && frameHeight == height;
+        mask.resize((size_t) frameWidth * frameHeight);
+        size_t foreground = 0;
+        for (int r = 0; r < frameHeight; ++r) {
+            const pho::api::Point3_32f* points = frame.PointCloud[r];
+            const float* mean = backgroundAvailable ? &background[(size_t) r * width] : nullptr;
+            uint8_t* maskRow = &mask[(size_t) r * frameWidth];
+            for (int c = 0; c < frameWidth; ++c) {
+                const float distance = pointDistance(points[c]);
+                const float backgroundDistance = mean ? mean[c] : 0.0f;
+                maskRow[c] = (uint8_t) ((distance > 0.0f) & ((backgroundDistance == 0.0f) | (std::fabs(distance - backgroundDistance) > depthThreshold)));
+                foreground += maskRow[c];
+            }
+        }
+        return foreground;
+    }
+}
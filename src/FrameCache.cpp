@@ -0,0 +1,94 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/FrameCache.h"
+#include "phoxi_camera/PhoXiInterface.h"
+
+namespace phoxi_camera {
+
+    FrameCache::FrameCache() : maxFrames(0), maxBytes(0), bytes(0) {
+    }
+
+    void FrameCache::setLimits(size_t maxFrames, size_t maxBytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->maxFrames = maxFrames;
+        this->maxBytes = maxBytes;
+        evict();
+    }
+
+    void FrameCache::insert(PFramePostProcessed frame) {
+        if (!frame || !frame->PFrame) {
+            return;
+        }
+        const uint64_t frameIndex = frame->PFrame->Info.FrameIndex;
+        const size_t frameBytes = frameMemory(*frame);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (maxFrames == 0 || frameBytes > maxBytes) {
+            return;
+        }
+        std::unordered_map<uint64_t, std::list<Entry>::iterator>::iterator it = index.find(frameIndex);
+        if (it != index.end()) {
+            bytes -= it->second->bytes;
+            entries.erase(it->second);
+            index.erase(it);
+        }
+        Entry entry;
+        entry.frameIndex = frameIndex;
+        entry.frame = frame;
+        entry.bytes = frameBytes;
+        entries.push_front(entry);
+        index[frameIndex] = entries.begin();
+        bytes += frameBytes;
+        evict();
+    }
+
+    PFramePostProcessed FrameCache::find(uint64_t frameIndex) {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unordered_map<uint64_t, std::list<Entry>::iterator>::iterator it = index.find(frameIndex);
+        if (it == index.end()) {
+            return PFramePostProcessed();
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->frame;
+    }
+
+    void FrameCache::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+        bytes = 0;
+    }
+
+    size_t FrameCache::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    size_t FrameCache::memory() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return bytes;
+    }
+
+    size_t FrameCache::frameMemory(const FramePostProcessed& frame) {
+        size_t frameBytes = frame.TextureAfterPostProcessing.total() * frame.TextureAfterPostProcessing.elemSize();
+        frameBytes += frame.TextureRectified.total() * frame.TextureRectified.elemSize();
+        if (frame.PFrame) {
+            const pho::api::Frame& phoxiFrame = *frame.PFrame;
+            frameBytes += (size_t) phoxiFrame.PointCloud.Size.Width * phoxiFrame.PointCloud.Size.Height * sizeof(pho::api::Point3_32f);
+            frameBytes += (size_t) phoxiFrame.NormalMap.Size.Width * phoxiFrame.NormalMap.Size.Height * sizeof(pho::api::Point3_32f);
+            frameBytes += (size_t) phoxiFrame.DepthMap.Size.Width * phoxiFrame.DepthMap.Size.Height * sizeof(float);
+            frameBytes += (size_t) phoxiFrame.ConfidenceMap.Size.Width * phoxiFrame.ConfidenceMap.Size.Height * sizeof(float);
+            frameBytes += (size_t) phoxiFrame.Texture.Size.Width * phoxiFrame.Texture.Size.Height * sizeof(float);
+        }
+        return frameBytes;
+    }
+
+    void FrameCache::evict() {
+        while (!entries.empty() && (entries.size() > maxFrames || bytes > maxBytes)) {
+            bytes -= entries.back().bytes;
+            index.erase(entries.back().frameIndex);
+            entries.pop_back();
+        }
+    }
+}
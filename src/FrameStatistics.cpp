@@ -0,0 +1,171 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/FrameStatistics.h"
+#include <algorithm>
+#include <cmath>
+
+namespace phoxi_camera {
+
+    namespace {
+        //buckets grow by 2^(1/4) from 1 ms, the last one ends after 60 s
+        const double latencyFirstBucket = 0.001;
+        const double latencyBucketsPerOctave = 4.0;
+        const int validPointsSubsampling = 4;
+    }
+
+    const char* outputChannelName(OutputChannel channel) {
+        switch (channel) {
+            case OutputChannel::PointCloud:
+                return "pointcloud";
+            case OutputChannel::PointCloudPreview:
+                return "pointcloud_preview";
+            case OutputChannel::PointCloudBands:
+                return "pointcloud_bands";
+            case OutputChannel::PointCloudForeground:
+                return "pointcloud_foreground";
+            case OutputChannel::PointCloudTargetFrames:
+                return "pointcloud target frames";
+            case OutputChannel::DepthMap:
+                return "depth_map";
+            case OutputChannel::Texture:
+                return "texture";
+            case OutputChannel::Image:
+                return "image_raw";
+            case OutputChannel::ImageRect:
+                return "image_rect";
+            case OutputChannel::ConfidenceMap:
+                return "confidence_map";
+            case OutputChannel::NormalMap:
+                return "normal_map";
+            case OutputChannel::Mesh:
+                return "mesh";
+            case OutputChannel::HeightMap:
+                return "height_map";
+            case OutputChannel::Plane:
+                return "plane";
+            case OutputChannel::PlaneMask:
+                return "plane_mask";
+            case OutputChannel::PointCloudVoxelGrid:
+                return "pointcloud_voxel_grid";
+            default:
+                return "unknown";
+        }
+    }
+
+    FrameStatistics::FrameStatistics() : framesReceived(0), framesPublished(0), framesDropped(0), frameIndexGaps(0),
+                                         lastFrameIndex(-1), latencyMaxMicroseconds(0), validPointsPerMille(0), lastPublishTime(0) {
+        for (int i = 0; i < (int) OutputChannel::Count; ++i) {
+            messages[i].store(0);
+            bytes[i].store(0);
+        }
+        for (int i = 0; i < LatencyBuckets; ++i) {
+            latencyHistogram[i].store(0);
+        }
+    }
+
+    int64_t FrameStatistics::now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int FrameStatistics::latencyBucket(double latency) {
+        if (latency <= latencyFirstBucket) {
+            return 0;
+        }
+        int bucket = 1 + (int) (std::log2(latency / latencyFirstBucket) * latencyBucketsPerOctave);
+        return std::min(bucket, LatencyBuckets - 1);
+    }
+
+    double FrameStatistics::bucketUpperBound(int bucket) {
+        return latencyFirstBucket * std::exp2(bucket / latencyBucketsPerOctave);
+    }
+
+    void FrameStatistics::frameReceived(const pho::api::Frame& frame) {
+        framesReceived.fetch_add(1, std::memory_order_relaxed);
+        const int64_t frameIndex = (int64_t) frame.Info.FrameIndex;
+        const int64_t previousIndex = lastFrameIndex.exchange(frameIndex, std::memory_order_relaxed);
+        //lower indexes come from the frame cache or from a reconnected scanner
+        if (previousIndex >= 0 && frameIndex > previousIndex + 1) {
+            frameIndexGaps.fetch_add((uint64_t) (frameIndex - previousIndex - 1), std::memory_order_relaxed);
+        }
+
+        const int width = frame.PointCloud.Size.Width;
+        const int height = frame.PointCloud.Size.Height;
+        uint64_t valid = 0;
+        uint64_t total = 0;
+        for (int r = 0; r < height; r += validPointsSubsampling) {
+            const pho::api::Point3_32f* points = frame.PointCloud[r];
+            for (int c = 0; c < width; c += validPointsSubsampling) {
+                valid += (points[c].x != 0.0f) | (points[c].y != 0.0f) | (points[c].z != 0.0f);
+                ++total;
+            }
+        }
+        if (total > 0) {
+            validPointsPerMille.store((uint32_t) (valid * 1000 / total), std::memory_order_relaxed);
+        }
+    }
+
+    void FrameStatistics::frameDropped() {
+        framesDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void FrameStatistics::framePublished(double latency) {
+        framesPublished.fetch_add(1, std::memory_order_relaxed);
+        latencyHistogram[latencyBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+        const uint64_t latencyMicroseconds = (uint64_t) std::max(0.0, latency * 1e6);
+        uint64_t maxLatency = latencyMaxMicroseconds.load(std::memory_order_relaxed);
+        while (latencyMicroseconds > maxLatency &&
+               !latencyMaxMicroseconds.compare_exchange_weak(maxLatency, latencyMicroseconds, std::memory_order_relaxed)) {
+        }
+        lastPublishTime.store(now(), std::memory_order_relaxed);
+    }
+
+    void FrameStatistics::outputPublished(OutputChannel channel, size_t size) {
+        messages[(int) channel].fetch_add(1, std::memory_order_relaxed);
+        bytes[(int) channel].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    FrameStatistics::Snapshot FrameStatistics::snapshot() {
+        Snapshot snapshot;
+        snapshot.time = std::chrono::steady_clock::now();
+        snapshot.framesReceived = framesReceived.load(std::memory_order_relaxed);
+        snapshot.framesPublished = framesPublished.load(std::memory_order_relaxed);
+        snapshot.framesDropped = framesDropped.load(std::memory_order_relaxed);
+        snapshot.frameIndexGaps = frameIndexGaps.load(std::memory_order_relaxed);
+        for (int i = 0; i < (int) OutputChannel::Count; ++i) {
+            snapshot.messages[i] = messages[i].load(std::memory_order_relaxed);
+            snapshot.bytes[i] = bytes[i].load(std::memory_order_relaxed);
+        }
+        snapshot.validPointsRatio = validPointsPerMille.load(std::memory_order_relaxed) / 1000.0;
+        snapshot.lastPublishTime = lastPublishTime.load(std::memory_order_relaxed);
+        snapshot.latencyMax = latencyMaxMicroseconds.exchange(0, std::memory_order_relaxed) * 1e-6;
+
+        uint64_t histogram[LatencyBuckets];
+        uint64_t samples = 0;
+        for (int i = 0; i < LatencyBuckets; ++i) {
+            histogram[i] = latencyHistogram[i].exchange(0, std::memory_order_relaxed);
+            samples += histogram[i];
+        }
+        snapshot.latencySamples = samples;
+        double* percentiles[] = {&snapshot.latencyP50, &snapshot.latencyP90, &snapshot.latencyP99};
+        const double ranks[] = {0.5, 0.9, 0.99};
+        for (int p = 0; p < 3; ++p) {
+            *percentiles[p] = 0.0;
+            if (samples == 0) {
+                continue;
+            }
+            const uint64_t rank = (uint64_t) std::ceil(ranks[p] * samples);
+            uint64_t accumulated = 0;
+            for (int i = 0; i < LatencyBuckets; ++i) {
+                accumulated += histogram[i];
+                if (accumulated >= rank) {
+                    //bucket upper bound, never above the measured maximum
+                    *percentiles[p] = std::min(bucketUpperBound(i), std::max(snapshot.latencyMax, bucketUpperBound(0)));
+                    break;
+                }
+            }
+        }
+        return snapshot;
+    }
+}
@@ -3,7 +3,194 @@
 //
 
 #include "phoxi_camera/PhoXiInterface.h"
+#include "phoxi_camera/TraceRecorder.h"
 #include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace {
+    /**
+     * Streams the point cloud of a frame row by row keeping a window of three rows with the depth and validity of
+     * each pixel, so that the confidence, jump edge and valid neighbours filters are evaluated in the same pass used
+     * for the point cloud conversion. The inner loops have no data dependent branches to allow auto vectorization.
+     */
+    class ValidPointsRowFilter {
+    public:
+        ValidPointsRowFilter(pho::api::Frame& frame, float minConfidence, float jumpEdgeMaxDepthRatio, int minValidNeighbours) :
+                frame(frame),
+                width(frame.PointCloud.Size.Width),
+                height(frame.PointCloud.Size.Height),
+                minConfidence(minConfidence),
+                jumpEdgeMaxDepthRatio(jumpEdgeMaxDepthRatio),
+                minValidNeighbours(minValidNeighbours),
+                lastRow(-2),
+                mask(width) {
+            useConfidence = minConfidence > 0.0f && !frame.ConfidenceMap.Empty() &&
+                            frame.ConfidenceMap.Size.Width == width && frame.ConfidenceMap.Size.Height == height;
+            useDepthMap = !frame.DepthMap.Empty() &&
+                          frame.DepthMap.Size.Width == width && frame.DepthMap.Size.Height == height;
+            useJumpEdge = jumpEdgeMaxDepthRatio > 1.0f;
+            useValidNeighbours = minValidNeighbours > 0;
+            for (int i = 0; i < 3; ++i) {
+                //one padding element on each side to handle the image borders without branches
+                depthRows[i].assign(width + 2, 0.0f);
+                validRows[i].assign(width + 2, 0);
+            }
+        }
+
+        /**
+         * Returns the mask of the valid points of row r (1 if valid, 0 otherwise).
+         * Rows are expected to be requested in increasing order for the window to be reused.
+         */
+        const uint8_t* row(int r) {
+            if (!useJumpEdge && !useValidNeighbours) {
+                loadRow(r, 0);
+                std::copy(validRows[0].begin() + 1, validRows[0].end() - 1, mask.begin());
+                return mask.data();
+            }
+            if (r != lastRow + 1) {
+                loadRow(r - 1, slot(r - 1));
+                loadRow(r, slot(r));
+            }
+            loadRow(r + 1, slot(r + 1));
+            lastRow = r;
+
+            const float* depthCurrent = depthRows[slot(r)].data() + 1;
+            const float* depthPrevious = depthRows[slot(r - 1)].data() + 1;
+            const float* depthNext = depthRows[slot(r + 1)].data() + 1;
+            const uint8_t* validCurrent = validRows[slot(r)].data() + 1;
+            const uint8_t* validPrevious = validRows[slot(r - 1)].data() + 1;
+            const uint8_t* validNext = validRows[slot(r + 1)].data() + 1;
+            uint8_t* rowMask = mask.data();
+
+            std::copy(validCurrent, validCurrent + width, rowMask);
+            if (useJumpEdge) {
+                const float ratio = jumpEdgeMaxDepthRatio;
+                for (int c = 0; c < width; ++c) {
+                    const float d = depthCurrent[c];
+                    uint8_t jump = 0;
+                    jump |= validCurrent[c - 1] & (std::max(d, depthCurrent[c - 1]) > ratio * std::min(d, depthCurrent[c - 1]));
+                    jump |= validCurrent[c + 1] & (std::max(d, depthCurrent[c + 1]) > ratio * std::min(d, depthCurrent[c + 1]));
+                    jump |= validPrevious[c] & (std::max(d, depthPrevious[c]) > ratio * std::min(d, depthPrevious[c]));
+                    jump |= validNext[c] & (std::max(d, depthNext[c]) > ratio * std::min(d, depthNext[c]));
+                    rowMask[c] &= (uint8_t) (jump ^ 1);
+                }
+            }
+            if (useValidNeighbours) {
+                for (int c = 0; c < width; ++c) {
+                    int neighbours = validPrevious[c - 1] + validPrevious[c] + validPrevious[c + 1] +
+                                     validCurrent[c - 1] + validCurrent[c + 1] +
+                                     validNext[c - 1] + validNext[c] + validNext[c + 1];
+                    rowMask[c] &= (uint8_t) (neighbours >= minValidNeighbours);
+                }
+            }
+            return rowMask;
+        }
+
+    private:
+        static int slot(int r) {
+            return ((r % 3) + 3) % 3;
+        }
+
+        void loadRow(int r, int s) {
+            float* depth = depthRows[s].data() + 1;
+            uint8_t* valid = validRows[s].data() + 1;
+            if (r < 0 || r >= height) {
+                std::fill(depth, depth + width, 0.0f);
+                std::fill(valid, valid + width, 0);
+                return;
+            }
+            const pho::api::Point3_32f* points = frame.PointCloud[r];
+            for (int c = 0; c < width; ++c) {
+                valid[c] = (uint8_t) ((points[c].x != 0.0f) | (points[c].y != 0.0f) | (points[c].z != 0.0f));
+            }
+            if (useConfidence) {
+                const float* confidence = frame.ConfidenceMap[r];
+                for (int c = 0; c < width; ++c) {
+                    valid[c] &= (uint8_t) (confidence[c] >= minConfidence);
+                }
+            }
+            if (useJumpEdge) {
+                if (useDepthMap) {
+                    const float* depthMap = frame.DepthMap[r];
+                    std::copy(depthMap, depthMap + width, depth);
+                } else {
+                    for (int c = 0; c < width; ++c) {
+                        depth[c] = std::sqrt(points[c].x * points[c].x + points[c].y * points[c].y + points[c].z * points[c].z);
+                    }
+                }
+            }
+        }
+
+        pho::api::Frame& frame;
+        const int width;
+        const int height;
+        const float minConfidence;
+        const float jumpEdgeMaxDepthRatio;
+        const int minValidNeighbours;
+        bool useConfidence;
+        bool useDepthMap;
+        bool useJumpEdge;
+        bool useValidNeighbours;
+        int lastRow;
+        std::vector<float> depthRows[3];
+        std::vector<uint8_t> validRows[3];
+        std::vector<uint8_t> mask;
+    };
+}
+
+/**
+ * Compile time description of the fields of the point types that can be generated from a frame
+ */
+template <typename PointT>
+struct PointCloudFields;
+
+template <>
+struct PointCloudFields<pcl::PointXYZ> {
+    static const bool HasTexture = false;
+    static const bool HasNormal = false;
+    static void setTexture(pcl::PointXYZ& point, uint8_t intensity) {}
+    static void setNormal(pcl::PointXYZ& point, const pho::api::Point3_32f& normal) {}
+};
+
+template <>
+struct PointCloudFields<pcl::PointXYZI> {
+    static const bool HasTexture = true;
+    static const bool HasNormal = false;
+    static void setTexture(pcl::PointXYZI& point, uint8_t intensity) {
+        point.intensity = intensity;
+    }
+    static void setNormal(pcl::PointXYZI& point, const pho::api::Point3_32f& normal) {}
+};
+
+template <>
+struct PointCloudFields<pcl::PointXYZRGB> {
+    static const bool HasTexture = true;
+    static const bool HasNormal = false;
+    static void setTexture(pcl::PointXYZRGB& point, uint8_t intensity) {
+        point.r = intensity;
+        point.g = intensity;
+        point.b = intensity;
+    }
+    static void setNormal(pcl::PointXYZRGB& point, const pho::api::Point3_32f& normal) {}
+};
+
+template <>
+struct PointCloudFields<pcl::PointXYZRGBNormal> {
+    static const bool HasTexture = true;
+    static const bool HasNormal = true;
+    static void setTexture(pcl::PointXYZRGBNormal& point, uint8_t intensity) {
+        point.r = intensity;
+        point.g = intensity;
+        point.b = intensity;
+    }
+    static void setNormal(pcl::PointXYZRGBNormal& point, const pho::api::Point3_32f& normal) {
+        point.normal_x = normal.x;
+        point.normal_y = normal.y;
+        point.normal_z = normal.z;
+    }
+};
 
 PhoXiInterface::PhoXiInterface() :
         textureMinIntensity(0.0f),
@@ -11,7 +198,17 @@ PhoXiInterface::PhoXiInterface() :
         textureContrastLimitedAdaptiveHistogramEqualizationClipLimit(4.0),
         textureContrastLimitedAdaptiveHistogramEqualizationSizeX(4),
         textureContrastLimitedAdaptiveHistogramEqualizationSizeY(4),
-        generatePointCloudWithOnlyValidPoints(false) {}
+        generatePointCloudWithOnlyValidPoints(false),
+        pointCloudMinConfidence(0.0f),
+        pointCloudJumpEdgeMaxDepthRatio(0.0f),
+        pointCloudMinValidNeighbours(0),
+        pointCloudPlaneRemoval(false),
+        pointCloudPlaneNormal(Eigen::Vector3f::Zero()),
+        pointCloudPlaneOffset(0.0f),
+        pointCloudPlaneMaxDistance(0.0f),
+        textureRectification(false),
+        textureSettingsVersion(0),
+        lastTriggeredFrameId(-1) {}
 
 std::vector<std::string> PhoXiInterface::cameraList(){
     if (!phoXiFactory.isPhoXiControlRunning()){
@@ -50,6 +247,8 @@ void PhoXiInterface::connectCamera(std::string HWIdentification, pho::api::PhoXi
         throw PhoXiScannerNotFound("Scanner not found");
     }
     disconnectCamera();
+    //frame indices restart in a new session, cached frames of the previous one must not be served for them
+    frameCache.clear();
     if(!(scanner = phoXiFactory.CreateAndConnect(device,5000))){
         disconnectCamera();
         throw UnableToStartAcquisition("Scanner was not able to connect. Disconnected.");
@@ -60,21 +259,57 @@ void PhoXiInterface::disconnectCamera(){
     if(scanner && scanner->isConnected()){
         scanner->Disconnect(true);
     }
+    frameCache.clear();
 }
 
 PFramePostProcessed PhoXiInterface::getPFrame(int id){
+    if(id >= 0){
+        PFramePostProcessed cachedFrame = frameCache.find(id);
+        if(cachedFrame && cachedFrame->TextureSettingsVersion != textureSettingsVersion){
+            //the texture of the cached frame was processed with previous settings
+            std::chrono::steady_clock::time_point triggerTime = cachedFrame->TriggerTime;
+            cachedFrame = postProcessFrame(cachedFrame->PFrame);
+            cachedFrame->TriggerTime = triggerTime;
+            frameCache.insert(cachedFrame);
+        }
+        if(cachedFrame){
+            //shallow copy sharing the maps, timed from the request because no scan is involved
+            PFramePostProcessed frameProcessed(new FramePostProcessed(*cachedFrame));
+            frameProcessed->TriggerTime = std::chrono::steady_clock::now();
+            return frameProcessed;
+        }
+    }
     if(id < 0){
         id = this->triggerImage();
     }
     this->isOk();
-    return postProcessFrame(scanner->GetSpecificFrame(id,10000));
+    std::chrono::steady_clock::time_point requestTime = std::chrono::steady_clock::now();
+    pho::api::PFrame frame;
+    {
+        phoxi_camera::TraceScope trace("GetSpecificFrame", "PhoXiInterface", id);
+        frame = scanner->GetSpecificFrame(id,10000);
+    }
+    if (frame) {
+        phoxi_camera::TraceRecorder::instance().recordInstant("frame arrival", "PhoXiInterface", frame->Info.FrameIndex);
+    }
+    PFramePostProcessed frameProcessed = postProcessFrame(frame);
+    frameProcessed->TriggerTime = id == lastTriggeredFrameId ? lastTriggerTime : requestTime;
+    frameCache.insert(frameProcessed);
+    return frameProcessed;
+}
+
+void PhoXiInterface::setFrameCacheLimits(size_t maxFrames, size_t maxBytes){
+    frameCache.setLimits(maxFrames, maxBytes);
 }
 
 PFramePostProcessed PhoXiInterface::postProcessFrame(pho::api::PFrame frame) {
+    phoxi_camera::TraceScope trace("postProcessFrame", "PhoXiInterface", frame ? (int64_t) frame->Info.FrameIndex : -1);
     auto frameProcessed = PFramePostProcessed(new FramePostProcessed());
     frameProcessed->PFrame = frame;
-    bool textureAvailable = scanner->OutputSettings->SendTexture && !frameProcessed->PFrame->Texture.Empty();
+    frameProcessed->TextureSettingsVersion = textureSettingsVersion;
+    bool textureAvailable = frameProcessed->PFrame && !frameProcessed->PFrame->Texture.Empty();
     if (textureAvailable) {
+        phoxi_camera::TraceScope textureTrace("texture normalization", "PhoXiInterface", frame->Info.FrameIndex);
         frameProcessed->TextureAfterPostProcessing = cv::Mat(frameProcessed->PFrame->Texture.Size.Height, frameProcessed->PFrame->Texture.Size.Width, CV_32FC1, frameProcessed->PFrame->Texture.operator[](0));
         bool useAutoMinMax = textureMinIntensity < 0.0f || textureMaxIntensity <= 0.0f || textureMinIntensity >= textureMaxIntensity;
         if (useAutoMinMax) {
@@ -86,67 +321,809 @@ PFramePostProcessed PhoXiInterface::postProcessFrame(pho::api::PFrame frame) {
         }
         bool useTextureHistogramEqualization = textureContrastLimitedAdaptiveHistogramEqualizationSizeX > 0 && textureContrastLimitedAdaptiveHistogramEqualizationSizeY > 0;
         if (useTextureHistogramEqualization) {
+            phoxi_camera::TraceScope claheTrace("texture CLAHE", "PhoXiInterface", frame->Info.FrameIndex);
             auto clahe = cv::createCLAHE(textureContrastLimitedAdaptiveHistogramEqualizationClipLimit, cv::Size(textureContrastLimitedAdaptiveHistogramEqualizationSizeX, textureContrastLimitedAdaptiveHistogramEqualizationSizeY));
             clahe->apply(frameProcessed->TextureAfterPostProcessing, frameProcessed->TextureAfterPostProcessing);
         }
+        if (textureRectification && textureRectificationIntrinsics.cameraMatrix[0] > 0.0) {
+            rectifyTexture(*frameProcessed);
+        }
     }
     return frameProcessed;
 }
 
+void PhoXiInterface::setTextureRectification(bool enabled, const ScannerIntrinsics& intrinsics) {
+    textureSettingsVersion += enabled != textureRectification;
+    textureRectification = enabled;
+    if (!enabled) {
+        textureRectifiedPool.clear();
+        return;
+    }
+    const ScannerIntrinsics& current = textureRectificationIntrinsics;
+    if (intrinsics.width != current.width || intrinsics.height != current.height ||
+        !std::equal(intrinsics.cameraMatrix, intrinsics.cameraMatrix + 9, current.cameraMatrix) ||
+        intrinsics.distortionCoefficients != current.distortionCoefficients) {
+        textureRectificationIntrinsics = intrinsics;
+        textureRectificationMapSize = cv::Size();
+        ++textureSettingsVersion;
+    }
+}
+
+void PhoXiInterface::rectifyTexture(FramePostProcessed& frame) {
+    phoxi_camera::TraceScope trace("texture rectification", "PhoXiInterface", frame.PFrame->Info.FrameIndex);
+    const cv::Mat& texture = frame.TextureAfterPostProcessing;
+    const cv::Size size = texture.size();
+    if (size != textureRectificationMapSize) {
+        phoxi_camera::TraceScope mapsTrace("texture rectification maps", "PhoXiInterface", frame.PFrame->Info.FrameIndex);
+        const ScannerIntrinsics& intrinsics = textureRectificationIntrinsics;
+        const double scaleX = intrinsics.width > 0 ? (double) size.width / intrinsics.width : 1.0;
+        const double scaleY = intrinsics.height > 0 ? (double) size.height / intrinsics.height : 1.0;
+        double cameraMatrixData[9] = {intrinsics.cameraMatrix[0] * scaleX, intrinsics.cameraMatrix[1] * scaleX, (intrinsics.cameraMatrix[2] + 0.5) * scaleX - 0.5,
+                                      0.0, intrinsics.cameraMatrix[4] * scaleY, (intrinsics.cameraMatrix[5] + 0.5) * scaleY - 0.5,
+                                      0.0, 0.0, 1.0};
+        //OpenCV accepts 4, 5, 8, 12 or 14 coefficients
+        std::vector<double> distortion = intrinsics.distortionCoefficients;
+        const size_t counts[] = {4, 5, 8, 12, 14};
+        size_t count = 14;
+        for (size_t c : counts) {
+            if (distortion.size() <= c) {
+                count = c;
+                break;
+            }
+        }
+        distortion.resize(count, 0.0);
+        cv::Mat cameraMatrix(3, 3, CV_64FC1, cameraMatrixData);
+        cv::Mat distortionCoefficients(1, (int) distortion.size(), CV_64FC1, distortion.data());
+        cv::initUndistortRectifyMap(cameraMatrix, distortionCoefficients, cv::Mat(), cameraMatrix, size, CV_16SC2,
+                                    textureRectificationMap1, textureRectificationMap2);
+        textureRectificationMapSize = size;
+        textureRectifiedPool.clear();
+    }
+    //a buffer is free when the pool holds its only reference, frames in the cache keep theirs
+    const size_t maxPoolSize = 8;
+    cv::Mat buffer;
+    for (cv::Mat& pooled : textureRectifiedPool) {
+        if (pooled.u && pooled.u->refcount == 1 && pooled.size() == size && pooled.type() == texture.type()) {
+            buffer = pooled;
+            break;
+        }
+    }
+    if (buffer.empty()) {
+        buffer.create(size, texture.type());
+        if (textureRectifiedPool.size() < maxPoolSize) {
+            textureRectifiedPool.push_back(buffer);
+        }
+    }
+    cv::remap(texture, buffer, textureRectificationMap1, textureRectificationMap2, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    frame.TextureRectified = buffer;
+}
+
 std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getPointCloud() {
     return getPointCloudFromFrame(getPFrame(-1));
 }
 
 std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getPointCloudFromFrame(PFramePostProcessed frame) {
+    return getPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame);
+}
+
+template <typename PointT>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::getPointCloudFromFrame(PFramePostProcessed frame, const Eigen::Affine3f& transform, PointCloudStatistics* statistics) {
     if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
         throw CorruptedFrame("Corrupted frame!");
     }
-    bool textureAvailable = !frame->TextureAfterPostProcessing.empty();
-    bool normalMapAvailable = scanner->OutputSettings->SendNormalMap && !frame->PFrame->NormalMap.Empty();
-    std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> cloud;
+    const int height = frame->PFrame->PointCloud.Size.Height;
     if (generatePointCloudWithOnlyValidPoints)
-        cloud = std::shared_ptr< pcl::PointCloud<pcl::PointXYZRGBNormal> >(new pcl::PointCloud<pcl::PointXYZRGBNormal>());
+        return convertFrameToPointCloud<PointT, true>(*frame, transform, 0, height, nullptr, statistics);
     else
-        cloud = std::shared_ptr< pcl::PointCloud<pcl::PointXYZRGBNormal> >(new pcl::PointCloud<pcl::PointXYZRGBNormal>(frame->PFrame->GetResolution().Width,frame->PFrame->GetResolution().Height));
-    for(int r = 0; r < frame->PFrame->GetResolution().Height; r++){
-        for (int c = 0; c < frame->PFrame->GetResolution().Width; c++){
-            auto point = frame->PFrame->PointCloud.At(r,c);
-            bool validPoint = point != PhoXiInterface::invalidPoint;
-            if (!generatePointCloudWithOnlyValidPoints ||
-                (generatePointCloudWithOnlyValidPoints && validPoint)) {
-                pcl::PointXYZRGBNormal pclPoint;
-                if (validPoint) {
-                    pclPoint.x = point.x / 1000.0;
-                    pclPoint.y = point.y / 1000.0;
-                    pclPoint.z = point.z / 1000.0;
+        return convertFrameToPointCloud<PointT, false>(*frame, transform, 0, height, nullptr, statistics);
+}
+
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> PhoXiInterface::getPointCloudFromFrame<pcl::PointXYZ>(PFramePostProcessed frame, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZI>> PhoXiInterface::getPointCloudFromFrame<pcl::PointXYZI>(PFramePostProcessed frame, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGB>> PhoXiInterface::getPointCloudFromFrame<pcl::PointXYZRGB>(PFramePostProcessed frame, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getPointCloudFromFrame<pcl::PointXYZRGBNormal>(PFramePostProcessed frame, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+
+void PhoXiInterface::getPointCloudStatisticsFromFrame(PFramePostProcessed frame, PointCloudStatistics& statistics) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getPointCloudStatisticsFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int width = phoxiFrame.PointCloud.Size.Width;
+    const int height = phoxiFrame.PointCloud.Size.Height;
+    const bool confidenceAvailable = !phoxiFrame.ConfidenceMap.Empty();
+    const bool textureHistogramAvailable = !frame->TextureAfterPostProcessing.empty();
+    //the same points as in convertFrameToPointCloud are counted, including the plane removal
+    const bool planeRemoval = pointCloudPlaneRemoval;
+    const Eigen::Vector3f planeNormal = pointCloudPlaneNormal;
+    const float planeOffset = pointCloudPlaneOffset * 1000.0f;
+    const float planeMaxDistance = pointCloudPlaneMaxDistance * 1000.0f;
+
+    std::mutex statisticsMutex;
+    threadPool.parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        PointCloudStatistics chunkStatistics;
+        chunkStatistics.totalPoints = (uint64_t) width * (rowEnd - rowBegin);
+        ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+        for (int r = rowBegin; r < rowEnd; ++r) {
+            const uint8_t* validPointsMask = validPointsFilter.row(r);
+            const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+            const float* confidence = confidenceAvailable ? phoxiFrame.ConfidenceMap[r] : nullptr;
+            const uint8_t* texture = textureHistogramAvailable ? frame->TextureAfterPostProcessing.ptr<uint8_t>(r) : nullptr;
+            for (int c = 0; c < width; ++c) {
+                if (!validPointsMask[c] ||
+                    (planeRemoval && std::abs(planeNormal.x() * points[c].x + planeNormal.y() * points[c].y + planeNormal.z() * points[c].z + planeOffset) <= planeMaxDistance)) {
+                    continue;
+                }
+                const Eigen::Vector3f point(points[c].x * 0.001f, points[c].y * 0.001f, points[c].z * 0.001f);
+                ++chunkStatistics.validPoints;
+                chunkStatistics.boundingBoxMin = chunkStatistics.boundingBoxMin.cwiseMin(point);
+                chunkStatistics.boundingBoxMax = chunkStatistics.boundingBoxMax.cwiseMax(point);
+                chunkStatistics.depthMin = std::min(chunkStatistics.depthMin, point.z());
+                chunkStatistics.depthMax = std::max(chunkStatistics.depthMax, point.z());
+                chunkStatistics.depthSum += point.z();
+                if (confidenceAvailable) {
+                    chunkStatistics.confidenceSum += confidence[c];
+                    ++chunkStatistics.confidencePoints;
+                }
+                if (textureHistogramAvailable) {
+                    ++chunkStatistics.textureHistogram[texture[c] * PointCloudStatistics::TextureHistogramBins / 256];
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        statistics.merge(chunkStatistics);
+    }, 16);
+}
+
+template <typename PointT>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::getPointCloudBandFromFrame(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform, PointCloudStatistics* statistics) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    rowBegin = std::max(0, rowBegin);
+    rowEnd = std::min(rowEnd, frame->PFrame->PointCloud.Size.Height);
+    return convertFrameToPointCloud<PointT, false>(*frame, transform, rowBegin, std::max(rowBegin, rowEnd), nullptr, statistics);
+}
+
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> PhoXiInterface::getPointCloudBandFromFrame<pcl::PointXYZ>(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZI>> PhoXiInterface::getPointCloudBandFromFrame<pcl::PointXYZI>(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGB>> PhoXiInterface::getPointCloudBandFromFrame<pcl::PointXYZRGB>(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getPointCloudBandFromFrame<pcl::PointXYZRGBNormal>(PFramePostProcessed frame, int rowBegin, int rowEnd, const Eigen::Affine3f& transform, PointCloudStatistics* statistics);
+
+template <typename PointT>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::getMaskedPointCloudFromFrame(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    const int height = frame->PFrame->PointCloud.Size.Height;
+    if (pixelMask.size() != (size_t) frame->PFrame->PointCloud.Size.Width * height) {
+        throw CorruptedFrame("Pixel mask size does not match the point cloud size!");
+    }
+    return convertFrameToPointCloud<PointT, true>(*frame, transform, 0, height, pixelMask.data());
+}
+
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> PhoXiInterface::getMaskedPointCloudFromFrame<pcl::PointXYZ>(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZI>> PhoXiInterface::getMaskedPointCloudFromFrame<pcl::PointXYZI>(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGB>> PhoXiInterface::getMaskedPointCloudFromFrame<pcl::PointXYZRGB>(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getMaskedPointCloudFromFrame<pcl::PointXYZRGBNormal>(PFramePostProcessed frame, const std::vector<uint8_t>& pixelMask, const Eigen::Affine3f& transform);
+
+template <typename PointT, bool OnlyValidPoints>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::convertFrameToPointCloud(FramePostProcessed& frame, const Eigen::Affine3f& transform, int rowBegin, int rowEnd, const uint8_t* pixelMask, PointCloudStatistics* statistics) {
+    pho::api::Frame& phoxiFrame = *frame.PFrame;
+    phoxi_camera::TraceScope trace("getPointCloudFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int width = phoxiFrame.PointCloud.Size.Width;
+    const int height = rowEnd - rowBegin;
+    //the checks on the point fields are resolved at compile time and the availability checks are loop invariant
+    const bool textureAvailable = PointCloudFields<PointT>::HasTexture && !frame.TextureAfterPostProcessing.empty();
+    const bool normalMapAvailable = PointCloudFields<PointT>::HasNormal && !phoxiFrame.NormalMap.Empty();
+    //the host transformation is fused with the conversion from millimeters to meters
+    const bool transformAvailable = !transform.matrix().isIdentity();
+    const Eigen::Matrix3f rotation = transform.linear();
+    const Eigen::Matrix3f rotationAndScale = rotation * 0.001f;
+    const Eigen::Vector3f translation = transform.translation();
+    //plane points are discarded in the same pass, the plane is in millimeters to test the raw points
+    const bool planeRemoval = pointCloudPlaneRemoval;
+    const Eigen::Vector3f planeNormal = pointCloudPlaneNormal;
+    const float planeOffset = pointCloudPlaneOffset * 1000.0f;
+    const float planeMaxDistance = pointCloudPlaneMaxDistance * 1000.0f;
+
+    std::shared_ptr<pcl::PointCloud<PointT>> cloud(new pcl::PointCloud<PointT>());
+    if (OnlyValidPoints) {
+        //masked point clouds are usually a small fraction of the frame
+        cloud->points.reserve(pixelMask ? (size_t) width * height / 8 : (size_t) width * height);
+    } else {
+        cloud->points.resize((size_t) width * height);
+        cloud->width = width;
+        cloud->height = height;
+    }
+    PointT invalidPclPoint;
+    invalidPclPoint.x = std::numeric_limits<float>::quiet_NaN();
+    invalidPclPoint.y = std::numeric_limits<float>::quiet_NaN();
+    invalidPclPoint.z = std::numeric_limits<float>::quiet_NaN();
+
+    //statistics are accumulated in locals and merged once at the end
+    const bool computeStatistics = statistics != nullptr;
+    const bool confidenceAvailable = computeStatistics && !phoxiFrame.ConfidenceMap.Empty();
+    const bool textureHistogramAvailable = computeStatistics && !frame.TextureAfterPostProcessing.empty();
+    uint64_t validPoints = 0;
+    Eigen::Vector3f boundingBoxMin = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+    Eigen::Vector3f boundingBoxMax = Eigen::Vector3f::Constant(-std::numeric_limits<float>::max());
+    float depthMin = std::numeric_limits<float>::max();
+    float depthMax = 0.0f;
+    double depthSum = 0.0;
+    double confidenceSum = 0.0;
+    uint32_t textureHistogram[PointCloudStatistics::TextureHistogramBins] = {0};
+
+    ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+    for (int r = rowBegin; r < rowEnd; r++) {
+        const uint8_t* validPointsMask = validPointsFilter.row(r);
+        const float* confidence = confidenceAvailable ? phoxiFrame.ConfidenceMap[r] : nullptr;
+        const uint8_t* textureRow = textureHistogramAvailable ? frame.TextureAfterPostProcessing.ptr<uint8_t>(r) : nullptr;
+        float rowDepthSum = 0.0f;
+        const uint8_t* pixelMaskRow = pixelMask ? pixelMask + (size_t) r * width : nullptr;
+        const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+        const pho::api::Point3_32f* normals = normalMapAvailable ? phoxiFrame.NormalMap[r] : nullptr;
+        const uint8_t* texture = textureAvailable ? frame.TextureAfterPostProcessing.ptr<uint8_t>(r) : nullptr;
+        PointT* organizedRow = OnlyValidPoints ? nullptr : &cloud->points[(size_t) (r - rowBegin) * width];
+        for (int c = 0; c < width; c++) {
+            if (validPointsMask[c] && (!pixelMaskRow || pixelMaskRow[c]) &&
+                (!planeRemoval || std::abs(planeNormal.x() * points[c].x + planeNormal.y() * points[c].y + planeNormal.z() * points[c].z + planeOffset) > planeMaxDistance)) {
+                PointT pclPoint;
+                if (transformAvailable) {
+                    pclPoint.getVector3fMap() = rotationAndScale * Eigen::Vector3f(points[c].x, points[c].y, points[c].z) + translation;
+                } else {
+                    pclPoint.x = points[c].x * 0.001f;
+                    pclPoint.y = points[c].y * 0.001f;
+                    pclPoint.z = points[c].z * 0.001f;
+                }
+                if (normalMapAvailable) {
+                    if (transformAvailable) {
+                        Eigen::Vector3f normal = rotation * Eigen::Vector3f(normals[c].x, normals[c].y, normals[c].z);
+                        PointCloudFields<PointT>::setNormal(pclPoint, pho::api::Point3_32f(normal.x(), normal.y(), normal.z()));
+                    } else {
+                        PointCloudFields<PointT>::setNormal(pclPoint, normals[c]);
+                    }
+                }
+                if (textureAvailable) {
+                    PointCloudFields<PointT>::setTexture(pclPoint, texture[c]);
+                }
+                if (computeStatistics) {
+                    ++validPoints;
+                    boundingBoxMin = boundingBoxMin.cwiseMin(pclPoint.getVector3fMap());
+                    boundingBoxMax = boundingBoxMax.cwiseMax(pclPoint.getVector3fMap());
+                    const float depth = points[c].z * 0.001f;
+                    depthMin = std::min(depthMin, depth);
+                    depthMax = std::max(depthMax, depth);
+                    rowDepthSum += depth;
+                    if (confidenceAvailable) {
+                        confidenceSum += confidence[c];
+                    }
+                    if (textureHistogramAvailable) {
+                        ++textureHistogram[textureRow[c] * PointCloudStatistics::TextureHistogramBins / 256];
+                    }
+                }
+                if (OnlyValidPoints)
+                    cloud->points.push_back(pclPoint);
+                else
+                    organizedRow[c] = pclPoint;
+            } else if (!OnlyValidPoints) {
+                organizedRow[c] = invalidPclPoint;
+            }
+        }
+        depthSum += rowDepthSum;
+    }
+    if (computeStatistics) {
+        statistics->totalPoints += (uint64_t) width * height;
+        statistics->validPoints += validPoints;
+        statistics->boundingBoxMin = statistics->boundingBoxMin.cwiseMin(boundingBoxMin);
+        statistics->boundingBoxMax = statistics->boundingBoxMax.cwiseMax(boundingBoxMax);
+        statistics->depthMin = std::min(statistics->depthMin, depthMin);
+        statistics->depthMax = std::max(statistics->depthMax, depthMax);
+        statistics->depthSum += depthSum;
+        if (confidenceAvailable) {
+            statistics->confidenceSum += confidenceSum;
+            statistics->confidencePoints += validPoints;
+        }
+        for (int i = 0; i < PointCloudStatistics::TextureHistogramBins; ++i) {
+            statistics->textureHistogram[i] += textureHistogram[i];
+        }
+    }
+    if (OnlyValidPoints) {
+        cloud->width = (uint32_t) cloud->points.size();
+        cloud->height = 1;
+    }
+    cloud->is_dense = OnlyValidPoints;
+    return cloud;
+}
+
+template <typename PointT>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::getPreviewPointCloudFromFrame(PFramePostProcessed frame, int factor, PreviewPooling pooling, const Eigen::Affine3f& transform) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    factor = std::max(1, std::min(factor, 8));
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getPreviewPointCloudFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int width = phoxiFrame.PointCloud.Size.Width;
+    const int height = phoxiFrame.PointCloud.Size.Height;
+    const int previewWidth = width / factor;
+    const int previewHeight = height / factor;
+    const bool textureAvailable = PointCloudFields<PointT>::HasTexture && !frame->TextureAfterPostProcessing.empty();
+    const bool normalMapAvailable = PointCloudFields<PointT>::HasNormal && !phoxiFrame.NormalMap.Empty();
+    const bool depthMapAvailable = !phoxiFrame.DepthMap.Empty() &&
+                                   phoxiFrame.DepthMap.Size.Width == width && phoxiFrame.DepthMap.Size.Height == height;
+    //the host transformation is fused with the conversion from millimeters to meters
+    const bool transformAvailable = !transform.matrix().isIdentity();
+    const Eigen::Matrix3f rotation = transform.linear();
+    const Eigen::Matrix3f rotationAndScale = rotation * 0.001f;
+    const Eigen::Vector3f translation = transform.translation();
+
+    std::shared_ptr<pcl::PointCloud<PointT>> cloud(new pcl::PointCloud<PointT>());
+    cloud->points.resize((size_t) previewWidth * previewHeight);
+    cloud->width = previewWidth;
+    cloud->height = previewHeight;
+    cloud->is_dense = false;
+    PointT invalidPclPoint;
+    invalidPclPoint.x = std::numeric_limits<float>::quiet_NaN();
+    invalidPclPoint.y = std::numeric_limits<float>::quiet_NaN();
+    invalidPclPoint.z = std::numeric_limits<float>::quiet_NaN();
+
+    //masks of the rows of a block are kept because the filter streams the frame row by row
+    ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+    std::vector<uint8_t> blockMasks((size_t) factor * width);
+    std::vector<std::pair<float, int>> candidates;
+    candidates.reserve(factor * factor);
+    for (int pr = 0; pr < previewHeight; pr++) {
+        for (int i = 0; i < factor; i++) {
+            const uint8_t* rowMask = validPointsFilter.row(pr * factor + i);
+            std::copy(rowMask, rowMask + width, blockMasks.begin() + (size_t) i * width);
+        }
+        for (int pc = 0; pc < previewWidth; pc++) {
+            candidates.clear();
+            for (int i = 0; i < factor; i++) {
+                const int r = pr * factor + i;
+                const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+                const float* depth = depthMapAvailable ? phoxiFrame.DepthMap[r] : nullptr;
+                for (int j = 0; j < factor; j++) {
+                    const int c = pc * factor + j;
+                    if (blockMasks[(size_t) i * width + c]) {
+                        const pho::api::Point3_32f& point = points[c];
+                        float pointDepth = depth ? depth[c] : point.x * point.x + point.y * point.y + point.z * point.z;
+                        candidates.push_back(std::make_pair(pointDepth, i * factor + j));
+                    }
+                }
+            }
+            PointT& pclPoint = cloud->points[(size_t) pr * previewWidth + pc];
+            if (candidates.empty()) {
+                pclPoint = invalidPclPoint;
+                continue;
+            }
+            std::vector<std::pair<float, int>>::iterator selected;
+            if (pooling == PreviewPooling::MedianDepth) {
+                selected = candidates.begin() + candidates.size() / 2;
+                std::nth_element(candidates.begin(), selected, candidates.end());
+            } else {
+                selected = std::min_element(candidates.begin(), candidates.end());
+            }
+            const int r = pr * factor + selected->second / factor;
+            const int c = pc * factor + selected->second % factor;
+            const pho::api::Point3_32f& point = phoxiFrame.PointCloud[r][c];
+            if (transformAvailable) {
+                pclPoint.getVector3fMap() = rotationAndScale * Eigen::Vector3f(point.x, point.y, point.z) + translation;
+            } else {
+                pclPoint.x = point.x * 0.001f;
+                pclPoint.y = point.y * 0.001f;
+                pclPoint.z = point.z * 0.001f;
+            }
+            if (normalMapAvailable) {
+                const pho::api::Point3_32f& normal = phoxiFrame.NormalMap[r][c];
+                if (transformAvailable) {
+                    Eigen::Vector3f rotatedNormal = rotation * Eigen::Vector3f(normal.x, normal.y, normal.z);
+                    PointCloudFields<PointT>::setNormal(pclPoint, pho::api::Point3_32f(rotatedNormal.x(), rotatedNormal.y(), rotatedNormal.z()));
+                } else {
+                    PointCloudFields<PointT>::setNormal(pclPoint, normal);
+                }
+            }
+            if (textureAvailable) {
+                PointCloudFields<PointT>::setTexture(pclPoint, frame->TextureAfterPostProcessing.at<uint8_t>(r, c));
+            }
+        }
+    }
+    return cloud;
+}
+
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> PhoXiInterface::getPreviewPointCloudFromFrame<pcl::PointXYZ>(PFramePostProcessed frame, int factor, PreviewPooling pooling, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZI>> PhoXiInterface::getPreviewPointCloudFromFrame<pcl::PointXYZI>(PFramePostProcessed frame, int factor, PreviewPooling pooling, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGB>> PhoXiInterface::getPreviewPointCloudFromFrame<pcl::PointXYZRGB>(PFramePostProcessed frame, int factor, PreviewPooling pooling, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getPreviewPointCloudFromFrame<pcl::PointXYZRGBNormal>(PFramePostProcessed frame, int factor, PreviewPooling pooling, const Eigen::Affine3f& transform);
+
+template <typename PointT>
+std::shared_ptr<pcl::PointCloud<PointT>> PhoXiInterface::getVoxelGridPointCloudFromFrame(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getVoxelGridPointCloudFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int rows = phoxiFrame.PointCloud.Size.Height;
+    const int columns = phoxiFrame.PointCloud.Size.Width;
+    const bool textureAvailable = PointCloudFields<PointT>::HasTexture && !frame->TextureAfterPostProcessing.empty();
+    const bool normalMapAvailable = PointCloudFields<PointT>::HasNormal && !phoxiFrame.NormalMap.Empty();
+    const float cellsPerMeter = 1.0f / std::max(leafSize, 1e-5f);
+    const Eigen::Matrix3f rotation = transform.linear();
+    const Eigen::Matrix3f rotationAndScale = rotation * 0.001f;
+    const Eigen::Vector3f translation = transform.translation();
+    const bool planeRemoval = pointCloudPlaneRemoval;
+    const Eigen::Vector3f planeNormal = pointCloudPlaneNormal;
+    const float planeOffset = pointCloudPlaneOffset * 1000.0f;
+    const float planeMaxDistance = pointCloudPlaneMaxDistance * 1000.0f;
+    //cell coordinates are offset to fit in 21 unsigned bits each, cells further than 2^20 leaves wrap around
+    const int64_t cellOffset = 1 << 20;
+    const uint64_t cellMask = (1u << 21) - 1;
+
+    const int maps = threadPool.getThreadCount();
+    voxelGridMaps.resize(maps);
+    //one chunk per map, the rows of the frame are split evenly between the maps
+    threadPool.parallelFor(0, maps, [&](int mapBegin, int mapEnd) {
+        for (int m = mapBegin; m < mapEnd; ++m) {
+            std::unordered_map<uint64_t, VoxelGridCell>& cells = voxelGridMaps[m];
+            cells.clear();
+            const int rowBegin = (int) ((int64_t) rows * m / maps);
+            const int rowEnd = (int) ((int64_t) rows * (m + 1) / maps);
+            ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+            for (int r = rowBegin; r < rowEnd; ++r) {
+                const uint8_t* validPointsMask = validPointsFilter.row(r);
+                const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+                const pho::api::Point3_32f* normals = normalMapAvailable ? phoxiFrame.NormalMap[r] : nullptr;
+                const uint8_t* texture = textureAvailable ? frame->TextureAfterPostProcessing.ptr<uint8_t>(r) : nullptr;
+                for (int c = 0; c < columns; ++c) {
+                    if (!validPointsMask[c] ||
+                        (planeRemoval && std::abs(planeNormal.x() * points[c].x + planeNormal.y() * points[c].y + planeNormal.z() * points[c].z + planeOffset) <= planeMaxDistance)) {
+                        continue;
+                    }
+                    const Eigen::Vector3f point = rotationAndScale * Eigen::Vector3f(points[c].x, points[c].y, points[c].z) + translation;
+                    const uint64_t key = (((uint64_t) ((int64_t) std::floor(point.x() * cellsPerMeter) + cellOffset) & cellMask) << 42) |
+                                         (((uint64_t) ((int64_t) std::floor(point.y() * cellsPerMeter) + cellOffset) & cellMask) << 21) |
+                                         ((uint64_t) ((int64_t) std::floor(point.z() * cellsPerMeter) + cellOffset) & cellMask);
+                    VoxelGridCell& cell = cells[key];      //value initialized to zero sums when inserted
+                    cell.x += point.x();
+                    cell.y += point.y();
+                    cell.z += point.z();
                     if (normalMapAvailable) {
-                        auto normal = frame->PFrame->NormalMap.At(r,c);
-                        pclPoint.normal_x = normal.x;
-                        pclPoint.normal_y = normal.y;
-                        pclPoint.normal_z = normal.z;
+                        const Eigen::Vector3f normal = rotation * Eigen::Vector3f(normals[c].x, normals[c].y, normals[c].z);
+                        cell.normalX += normal.x();
+                        cell.normalY += normal.y();
+                        cell.normalZ += normal.z();
                     }
                     if (textureAvailable) {
-                        uint8_t intensity = frame->TextureAfterPostProcessing.at<uint8_t>(r,c);
-                        pclPoint.r = intensity;
-                        pclPoint.g = intensity;
-                        pclPoint.b = intensity;
+                        cell.intensity += texture[c];
                     }
-                } else {
-                    pclPoint.x = std::numeric_limits<float>::quiet_NaN();
-                    pclPoint.y = std::numeric_limits<float>::quiet_NaN();
-                    pclPoint.z = std::numeric_limits<float>::quiet_NaN();
+                    ++cell.count;
                 }
-                if (generatePointCloudWithOnlyValidPoints)
-                    cloud->push_back(pclPoint);
-                else
-                    cloud->at(c,r) = pclPoint;
             }
         }
+    });
+
+    //the maps are merged into the first one and emitted in key order, so the output does not depend on the hash maps
+    std::unordered_map<uint64_t, VoxelGridCell>& merged = voxelGridMaps[0];
+    for (int m = 1; m < maps; ++m) {
+        for (const auto& entry : voxelGridMaps[m]) {
+            VoxelGridCell& cell = merged[entry.first];
+            cell.x += entry.second.x;
+            cell.y += entry.second.y;
+            cell.z += entry.second.z;
+            cell.normalX += entry.second.normalX;
+            cell.normalY += entry.second.normalY;
+            cell.normalZ += entry.second.normalZ;
+            cell.intensity += entry.second.intensity;
+            cell.count += entry.second.count;
+        }
+    }
+    std::vector<std::pair<uint64_t, const VoxelGridCell*>> sortedCells;
+    sortedCells.reserve(merged.size());
+    for (const auto& entry : merged) {
+        sortedCells.push_back(std::make_pair(entry.first, &entry.second));
+    }
+    std::sort(sortedCells.begin(), sortedCells.end(), [](const std::pair<uint64_t, const VoxelGridCell*>& a, const std::pair<uint64_t, const VoxelGridCell*>& b) {
+        return a.first < b.first;
+    });
+
+    std::shared_ptr<pcl::PointCloud<PointT>> cloud(new pcl::PointCloud<PointT>());
+    cloud->points.resize(sortedCells.size());
+    for (size_t i = 0; i < sortedCells.size(); ++i) {
+        const VoxelGridCell& cell = *sortedCells[i].second;
+        const double inverseCount = 1.0 / cell.count;
+        PointT& pclPoint = cloud->points[i];
+        pclPoint.x = (float) (cell.x * inverseCount);
+        pclPoint.y = (float) (cell.y * inverseCount);
+        pclPoint.z = (float) (cell.z * inverseCount);
+        if (normalMapAvailable) {
+            Eigen::Vector3f normal(cell.normalX, cell.normalY, cell.normalZ);
+            const float norm = normal.norm();
+            if (norm > 0.0f) {
+                normal /= norm;
+            }
+            PointCloudFields<PointT>::setNormal(pclPoint, pho::api::Point3_32f(normal.x(), normal.y(), normal.z()));
+        }
+        if (textureAvailable) {
+            PointCloudFields<PointT>::setTexture(pclPoint, (uint8_t) ((cell.intensity + cell.count / 2) / cell.count));
+        }
     }
-    cloud->is_dense = generatePointCloudWithOnlyValidPoints;
+    cloud->width = (uint32_t) cloud->points.size();
+    cloud->height = 1;
+    cloud->is_dense = true;
     return cloud;
 }
 
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> PhoXiInterface::getVoxelGridPointCloudFromFrame<pcl::PointXYZ>(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZI>> PhoXiInterface::getVoxelGridPointCloudFromFrame<pcl::PointXYZI>(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGB>> PhoXiInterface::getVoxelGridPointCloudFromFrame<pcl::PointXYZRGB>(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform);
+template std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> PhoXiInterface::getVoxelGridPointCloudFromFrame<pcl::PointXYZRGBNormal>(PFramePostProcessed frame, float leafSize, const Eigen::Affine3f& transform);
+
+void PhoXiInterface::getMeshFromFrame(PFramePostProcessed frame, OrganizedMesh& mesh, float maxEdgeLength, int step, const Eigen::Affine3f& transform) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getMeshFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    step = std::max(1, std::min(step, 8));
+    const int width = (phoxiFrame.PointCloud.Size.Width + step - 1) / step;
+    const int height = (phoxiFrame.PointCloud.Size.Height + step - 1) / step;
+    mesh.width = width;
+    mesh.height = height;
+    mesh.step = step;
+    mesh.vertices.clear();
+    mesh.triangles.clear();
+    if (width < 2 || height < 2) {
+        return;
+    }
+    const float maxEdgeLengthSquared = maxEdgeLength > 0.0f ? maxEdgeLength * maxEdgeLength : std::numeric_limits<float>::max();
+    const bool transformAvailable = !transform.matrix().isIdentity();
+    const Eigen::Matrix3f rotationAndScale = transform.linear() * 0.001f;
+    const Eigen::Vector3f translation = transform.translation();
+    meshGridPoints.resize((size_t) width * height * 3);
+    meshGridValid.resize((size_t) width * height);
+    meshQuads.resize((size_t) width * height);
+    meshRowVertices.resize(height + 1);
+    meshRowTriangles.resize(height + 1);
+
+    //grid points which pass the point cloud filters, the filters see the full resolution rows
+    threadPool.parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            const uint8_t* validPointsMask = validPointsFilter.row(i * step);
+            const pho::api::Point3_32f* points = phoxiFrame.PointCloud[i * step];
+            float* gridPoints = &meshGridPoints[(size_t) i * width * 3];
+            uint8_t* gridValid = &meshGridValid[(size_t) i * width];
+            uint32_t vertices = 0;
+            for (int j = 0; j < width; ++j) {
+                const int c = j * step;
+                gridValid[j] = validPointsMask[c];
+                if (validPointsMask[c]) {
+                    Eigen::Map<Eigen::Vector3f> point(gridPoints + 3 * j);
+                    if (transformAvailable) {
+                        point = rotationAndScale * Eigen::Vector3f(points[c].x, points[c].y, points[c].z) + translation;
+                    } else {
+                        point = Eigen::Vector3f(points[c].x, points[c].y, points[c].z) * 0.001f;
+                    }
+                    ++vertices;
+                }
+            }
+            meshRowVertices[i + 1] = vertices;
+        }
+    }, 4);
+    meshRowVertices[0] = 0;
+    for (int i = 0; i < height; ++i) {
+        meshRowVertices[i + 1] += meshRowVertices[i];
+    }
+    mesh.vertices.resize((size_t) meshRowVertices[height] * 3);
+
+    //vertices and quads with 4 valid corners and short edges, quad (i, j) has the grid points (i, j) to (i + 1, j + 1)
+    threadPool.parallelFor(0, height, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            const float* gridPoints = &meshGridPoints[(size_t) i * width * 3];
+            const uint8_t* gridValid = &meshGridValid[(size_t) i * width];
+            float* vertices = &mesh.vertices[(size_t) meshRowVertices[i] * 3];
+            for (int j = 0; j < width; ++j) {
+                if (gridValid[j]) {
+                    std::copy(gridPoints + 3 * j, gridPoints + 3 * j + 3, vertices);
+                    vertices += 3;
+                }
+            }
+            uint8_t* quads = &meshQuads[(size_t) i * width];
+            uint32_t triangles = 0;
+            if (i + 1 < height) {
+                const float* nextGridPoints = gridPoints + (size_t) width * 3;
+                const uint8_t* nextGridValid = gridValid + width;
+                for (int j = 0; j + 1 < width; ++j) {
+                    quads[j] = 0;
+                    if (!(gridValid[j] & gridValid[j + 1] & nextGridValid[j] & nextGridValid[j + 1])) {
+                        continue;
+                    }
+                    Eigen::Map<const Eigen::Vector3f> a(gridPoints + 3 * j), b(gridPoints + 3 * j + 3);
+                    Eigen::Map<const Eigen::Vector3f> c(nextGridPoints + 3 * j), d(nextGridPoints + 3 * j + 3);
+                    //4 sides and the shared diagonal b - c
+                    const bool shortEdges = (b - a).squaredNorm() <= maxEdgeLengthSquared && (c - a).squaredNorm() <= maxEdgeLengthSquared &&
+                                            (d - b).squaredNorm() <= maxEdgeLengthSquared && (d - c).squaredNorm() <= maxEdgeLengthSquared &&
+                                            (c - b).squaredNorm() <= maxEdgeLengthSquared;
+                    quads[j] = shortEdges;
+                    triangles += shortEdges ? 2 : 0;
+                }
+            }
+            meshRowTriangles[i + 1] = triangles;
+        }
+    }, 4);
+    meshRowTriangles[0] = 0;
+    for (int i = 0; i < height; ++i) {
+        meshRowTriangles[i + 1] += meshRowTriangles[i];
+    }
+    mesh.triangles.resize((size_t) meshRowTriangles[height] * 3);
+
+    //triangles (a, c, b) and (b, c, d) face the scanner, which looks along +z with rows along +y
+    threadPool.parallelFor(0, height - 1, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            const uint8_t* gridValid = &meshGridValid[(size_t) i * width];
+            const uint8_t* nextGridValid = gridValid + width;
+            const uint8_t* quads = &meshQuads[(size_t) i * width];
+            uint32_t* triangles = &mesh.triangles[(size_t) meshRowTriangles[i] * 3];
+            uint32_t vertex = meshRowVertices[i];
+            uint32_t nextVertex = meshRowVertices[i + 1];
+            for (int j = 0; j + 1 < width; ++j) {
+                if (quads[j]) {
+                    const uint32_t a = vertex, b = vertex + 1, c = nextVertex, d = nextVertex + 1;
+                    triangles[0] = a; triangles[1] = c; triangles[2] = b;
+                    triangles[3] = b; triangles[4] = c; triangles[5] = d;
+                    triangles += 6;
+                }
+                vertex += gridValid[j];
+                nextVertex += nextGridValid[j];
+            }
+        }
+    }, 4);
+}
+
+void PhoXiInterface::getHeightMapFromFrame(PFramePostProcessed frame, HeightMap& heightMap, const Eigen::Affine3f& transform) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getHeightMapFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int width = std::max(0, heightMap.width);
+    const int height = std::max(0, heightMap.height);
+    const size_t cells = (size_t) width * height;
+    heightMap.heights.assign(cells, std::numeric_limits<float>::quiet_NaN());
+    heightMap.counts.assign(cells, 0);
+    if (cells == 0 || heightMap.resolution <= 0.0f) {
+        return;
+    }
+    const int rows = phoxiFrame.PointCloud.Size.Height;
+    const int columns = phoxiFrame.PointCloud.Size.Width;
+    const float cellsPerMeter = 1.0f / heightMap.resolution;
+    const Eigen::Matrix3f rotationAndScale = transform.linear() * 0.001f;
+    const Eigen::Vector3f translation = transform.translation() - Eigen::Vector3f(heightMap.originX, heightMap.originY, 0.0f);
+
+    //the grid rows are split into one band per thread, each thread projects a block of rows of the frame into
+    //one bucket per band and then merges the buckets of its own band, so each cell is written by a single thread
+    //and the memory does not grow with the grid size times the number of threads
+    const int threads = threadPool.getThreadCount();
+    const int bandRows = (height + threads - 1) / threads;
+    const int bands = (height + bandRows - 1) / bandRows;
+    heightMapBucketCells.resize((size_t) threads * bands);
+    heightMapBucketHeights.resize((size_t) threads * bands);
+    threadPool.parallelFor(0, threads, [&](int tileBegin, int tileEnd) {
+        for (int tile = tileBegin; tile < tileEnd; ++tile) {
+            std::vector<uint32_t>* bucketCells = &heightMapBucketCells[(size_t) tile * bands];
+            std::vector<float>* bucketHeights = &heightMapBucketHeights[(size_t) tile * bands];
+            for (int band = 0; band < bands; ++band) {
+                bucketCells[band].clear();
+                bucketHeights[band].clear();
+            }
+            const int rowBegin = (int) ((int64_t) rows * tile / threads);
+            const int rowEnd = (int) ((int64_t) rows * (tile + 1) / threads);
+            ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+            for (int r = rowBegin; r < rowEnd; ++r) {
+                const uint8_t* validPointsMask = validPointsFilter.row(r);
+                const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+                for (int c = 0; c < columns; ++c) {
+                    if (!validPointsMask[c]) {
+                        continue;
+                    }
+                    const Eigen::Vector3f point = rotationAndScale * Eigen::Vector3f(points[c].x, points[c].y, points[c].z) + translation;
+                    const float column = std::floor(point.x() * cellsPerMeter);
+                    const float row = std::floor(point.y() * cellsPerMeter);
+                    if (column < 0.0f || row < 0.0f || column >= width || row >= height) {
+                        continue;
+                    }
+                    const int band = (int) row / bandRows;
+                    bucketCells[band].push_back((uint32_t) ((size_t) row * width + (size_t) column));
+                    bucketHeights[band].push_back(point.z());
+                }
+            }
+        }
+    });
+
+    const int minPoints = std::max(1, heightMap.minPoints);
+    threadPool.parallelFor(0, bands, [&](int bandBegin, int bandEnd) {
+        for (int band = bandBegin; band < bandEnd; ++band) {
+            const size_t cellBegin = (size_t) band * bandRows * width;
+            const size_t cellEnd = std::min(cells, cellBegin + (size_t) bandRows * width);
+            std::fill(heightMap.heights.begin() + cellBegin, heightMap.heights.begin() + cellEnd, -std::numeric_limits<float>::infinity());
+            for (int tile = 0; tile < threads; ++tile) {
+                const std::vector<uint32_t>& bucketCells = heightMapBucketCells[(size_t) tile * bands + band];
+                const std::vector<float>& bucketHeights = heightMapBucketHeights[(size_t) tile * bands + band];
+                for (size_t i = 0; i < bucketCells.size(); ++i) {
+                    const uint32_t cell = bucketCells[i];
+                    heightMap.heights[cell] = std::max(heightMap.heights[cell], bucketHeights[i]);
+                    ++heightMap.counts[cell];
+                }
+            }
+            for (size_t cell = cellBegin; cell < cellEnd; ++cell) {
+                if (heightMap.counts[cell] < (uint32_t) minPoints) {
+                    heightMap.heights[cell] = std::numeric_limits<float>::quiet_NaN();
+                }
+            }
+        }
+    });
+}
+
+void PhoXiInterface::getSubsampledPointsFromFrame(PFramePostProcessed frame, int subsampling, std::vector<Eigen::Vector3f>& points, std::vector<uint8_t>* intensities) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    subsampling = std::max(1, subsampling);
+    const int rows = phoxiFrame.PointCloud.Size.Height;
+    const int columns = phoxiFrame.PointCloud.Size.Width;
+    points.clear();
+    const bool textureAvailable = intensities && !frame->TextureAfterPostProcessing.empty();
+    if (intensities) {
+        intensities->clear();
+    }
+    ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+    for (int r = 0; r < rows; r += subsampling) {
+        const uint8_t* validPointsMask = validPointsFilter.row(r);
+        const pho::api::Point3_32f* row = phoxiFrame.PointCloud[r];
+        const uint8_t* texture = textureAvailable ? frame->TextureAfterPostProcessing.ptr<uint8_t>(r) : nullptr;
+        for (int c = 0; c < columns; c += subsampling) {
+            if (validPointsMask[c]) {
+                points.push_back(Eigen::Vector3f(row[c].x, row[c].y, row[c].z) * 0.001f);
+                if (texture) {
+                    intensities->push_back(texture[c]);
+                }
+            }
+        }
+    }
+}
+
+void PhoXiInterface::getPlaneMaskFromFrame(PFramePostProcessed frame, const Eigen::Vector4f& plane, float maxDistance, std::vector<uint8_t>& mask) {
+    if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+        throw CorruptedFrame("Corrupted frame!");
+    }
+    pho::api::Frame& phoxiFrame = *frame->PFrame;
+    phoxi_camera::TraceScope trace("getPlaneMaskFromFrame", "PhoXiInterface", phoxiFrame.Info.FrameIndex);
+    const int rows = phoxiFrame.PointCloud.Size.Height;
+    const int columns = phoxiFrame.PointCloud.Size.Width;
+    const Eigen::Vector3f normal = plane.head<3>();
+    const float offset = plane[3] * 1000.0f;
+    const float maxDistanceMillimeters = maxDistance * 1000.0f;
+    mask.resize((size_t) rows * columns);
+    threadPool.parallelFor(0, rows, [&](int rowBegin, int rowEnd) {
+        ValidPointsRowFilter validPointsFilter(phoxiFrame, pointCloudMinConfidence, pointCloudJumpEdgeMaxDepthRatio, pointCloudMinValidNeighbours);
+        for (int r = rowBegin; r < rowEnd; ++r) {
+            const uint8_t* validPointsMask = validPointsFilter.row(r);
+            const pho::api::Point3_32f* points = phoxiFrame.PointCloud[r];
+            uint8_t* maskRow = &mask[(size_t) r * columns];
+            for (int c = 0; c < columns; ++c) {
+                const float distance = normal.x() * points[c].x + normal.y() * points[c].y + normal.z() * points[c].z + offset;
+                maskRow[c] = validPointsMask[c] && std::abs(distance) <= maxDistanceMillimeters ? 255 : 0;
+            }
+        }
+    }, 8);
+}
+
+void PhoXiInterface::setWorkerThreads(int threads, const std::function<void()>& initializer) {
+    threadPool.start(threads, initializer);
+}
+
 void PhoXiInterface::isOk(){
     if(!scanner || !scanner->isConnected()){
         throw PhoXiScannerNotConnected("No scanner connected");
@@ -226,8 +1203,13 @@ void PhoXiInterface::stopAcquisition(){
     }
 }
 int PhoXiInterface::triggerImage(){
+    phoxi_camera::TraceScope trace("triggerImage", "PhoXiInterface");
     this->setTriggerMode(pho::api::PhoXiTriggerMode::Software,true);
-    return scanner->TriggerFrame();
+    lastTriggerTime = std::chrono::steady_clock::now();
+    int id = scanner->TriggerFrame();
+    lastTriggeredFrameId = id;
+    trace.setFrameIndex(id);
+    return id;
 }
 
 std::vector<pho::api::PhoXiCapturingMode> PhoXiInterface::getSupportedCapturingModes(){
@@ -235,6 +1217,22 @@ std::vector<pho::api::PhoXiCapturingMode> PhoXiInterface::getSupportedCapturingM
     return scanner->SupportedCapturingModes;
 }
 
+ScannerIntrinsics PhoXiInterface::getScannerIntrinsics(){
+    this->isOk();
+    pho::api::PhoXiCapturingMode mode = scanner->CapturingMode;
+    pho::api::PhoXiCalibrationSettings calibration = scanner->CalibrationSettings;
+    ScannerIntrinsics intrinsics;
+    intrinsics.width = mode.Resolution.Width;
+    intrinsics.height = mode.Resolution.Height;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            intrinsics.cameraMatrix[r * 3 + c] = calibration.CameraMatrix[r][c];
+        }
+    }
+    intrinsics.distortionCoefficients = calibration.DistortionCoefficients;
+    return intrinsics;
+}
+
 void PhoXiInterface::setHighResolution(){
     this->isOk();
     pho::api::PhoXiCapturingMode mode = scanner->CapturingMode;
@@ -250,6 +1248,39 @@ void PhoXiInterface::setLowResolution(){
     scanner->CapturingMode = mode;
 }
 
+int PhoXiInterface::setCaptureProfile(const CaptureProfile& profile, const CaptureProfile& current){
+    phoxi_camera::TraceScope trace("setCaptureProfile", "PhoXiInterface");
+    this->isOk();
+    int deviceWrites = 0;
+    if(profile.resolution >= 0 && profile.resolution != current.resolution){
+        if(profile.resolution == 0){
+            this->setLowResolution();
+        }
+        else{
+            this->setHighResolution();
+        }
+        ++deviceWrites;
+    }
+    bool scanMultiplierChanged = profile.scanMultiplier > 0 && profile.scanMultiplier != current.scanMultiplier;
+    bool shutterMultiplierChanged = profile.shutterMultiplier > 0 && profile.shutterMultiplier != current.shutterMultiplier;
+    if(scanMultiplierChanged || shutterMultiplierChanged){
+        pho::api::PhoXiCapturingSettings settings = scanner->CapturingSettings;
+        if(scanMultiplierChanged){
+            settings.ScanMultiplier = profile.scanMultiplier;
+        }
+        if(shutterMultiplierChanged){
+            settings.ShutterMultiplier = profile.shutterMultiplier;
+        }
+        scanner->CapturingSettings = settings;
+        ++deviceWrites;
+    }
+    if(profile.confidence >= 0.0 && profile.confidence != current.confidence){
+        scanner->ProcessingSettings->Confidence = profile.confidence;
+        ++deviceWrites;
+    }
+    return deviceWrites;
+}
+
 void PhoXiInterface::setTriggerMode(pho::api::PhoXiTriggerMode mode, bool startAcquisition){
     if(!((mode == pho::api::PhoXiTriggerMode::Software) || (mode == pho::api::PhoXiTriggerMode::Hardware) || (mode == pho::api::PhoXiTriggerMode::Freerun) || (mode == pho::api::PhoXiTriggerMode::NoValue))){
         throw InvalidTriggerMode("Invalid trigger mode " + std::to_string(mode) +".");
@@ -0,0 +1,156 @@
+//
+// Created by controller on 10/19/26.
+//
+// Python module phoxi_camera_py, wraps PhoXiInterface without ROS. The maps of the frames and the converted
+// point clouds are returned as NumPy arrays viewing the C++ buffers, which are kept alive by the arrays.
+//
+
+#include <pybind11/pybind11.h>
+#include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "phoxi_camera/PhoXiInterface.h"
+#include "phoxi_camera/PhoXiException.h"
+
+namespace py = pybind11;
+
+namespace {
+    /**
+    * View of map with shape (height, width) or (height, width, channels), owner keeps the frame alive
+    */
+    template <typename T>
+    py::object mapView(pho::api::Mat2D<T>& map, size_t channels, py::handle owner) {
+        if (map.Empty()) {
+            return py::none();
+        }
+        std::vector<ssize_t> shape = {map.Size.Height, map.Size.Width};
+        std::vector<ssize_t> strides = {(ssize_t) (map.Size.Width * sizeof(T)), (ssize_t) sizeof(T)};
+        if (channels > 1) {
+            shape.push_back(channels);
+            strides.push_back(sizeof(float));
+        }
+        return py::array_t<float>(shape, strides, reinterpret_cast<float*>(map.operator[](0)), owner);
+    }
+
+    py::object textureView(cv::Mat& texture, py::handle owner) {
+        if (texture.empty()) {
+            return py::none();
+        }
+        std::vector<ssize_t> shape = {texture.rows, texture.cols};
+        std::vector<ssize_t> strides = {(ssize_t) texture.step[0], (ssize_t) texture.elemSize()};
+        if (texture.depth() == CV_8U) {
+            return py::array_t<uint8_t>(shape, strides, texture.ptr<uint8_t>(), owner);
+        }
+        return py::array_t<float>(shape, strides, texture.ptr<float>(), owner);
+    }
+
+    /**
+    * View of 3 consecutive floats at offset in each point of cloud, with shape (height, width, 3)
+    */
+    template <typename PointT>
+    py::array_t<float> pointFieldView(const std::shared_ptr<pcl::PointCloud<PointT>>& cloud, size_t offset, py::handle owner) {
+        std::vector<ssize_t> shape = {cloud->height, cloud->width, 3};
+        std::vector<ssize_t> strides = {(ssize_t) (cloud->width * sizeof(PointT)), (ssize_t) sizeof(PointT), (ssize_t) sizeof(float)};
+        const float* data = cloud->points.empty() ? nullptr : reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(cloud->points.data()) + offset);
+        return py::array_t<float>(shape, strides, data, owner);
+    }
+
+    template <typename PointT>
+    py::capsule cloudOwner(const std::shared_ptr<pcl::PointCloud<PointT>>& cloud) {
+        return py::capsule(new std::shared_ptr<pcl::PointCloud<PointT>>(cloud), [](void* owner) {
+            delete static_cast<std::shared_ptr<pcl::PointCloud<PointT>>*>(owner);
+        });
+    }
+}
+
+PYBIND11_MODULE(phoxi_camera_py, m) {
+    m.doc() = "PhoXi 3D scanner interface with frames exposed as NumPy arrays without copies";
+
+    py::register_exception<PhoXiInterfaceException>(m, "PhoXiInterfaceError", PyExc_RuntimeError);
+
+    py::class_<FramePostProcessed, PFramePostProcessed>(m, "Frame",
+            "Post-processed frame, the map properties are None when the scanner did not send the map")
+        .def_property_readonly("frame_index", [](const FramePostProcessed& frame) {
+            return frame.PFrame->Info.FrameIndex;
+        })
+        .def_property_readonly("successful", [](const FramePostProcessed& frame) {
+            return (bool) frame.PFrame->Successful;
+        })
+        .def_property_readonly("point_cloud", [](py::object self) {
+            return mapView(self.cast<FramePostProcessed&>().PFrame->PointCloud, 3, self);
+        }, "float32 (height, width, 3) in millimeters, invalid points are 0")
+        .def_property_readonly("normal_map", [](py::object self) {
+            return mapView(self.cast<FramePostProcessed&>().PFrame->NormalMap, 3, self);
+        }, "float32 (height, width, 3)")
+        .def_property_readonly("depth_map", [](py::object self) {
+            return mapView(self.cast<FramePostProcessed&>().PFrame->DepthMap, 1, self);
+        }, "float32 (height, width) in millimeters")
+        .def_property_readonly("confidence_map", [](py::object self) {
+            return mapView(self.cast<FramePostProcessed&>().PFrame->ConfidenceMap, 1, self);
+        }, "float32 (height, width)")
+        .def_property_readonly("texture", [](py::object self) {
+            return mapView(self.cast<FramePostProcessed&>().PFrame->Texture, 1, self);
+        }, "float32 (height, width) as captured")
+        .def_property_readonly("texture_processed", [](py::object self) {
+            return textureView(self.cast<FramePostProcessed&>().TextureAfterPostProcessing, self);
+        }, "uint8 (height, width) after normalization and CLAHE");
+
+    py::class_<PhoXiInterface>(m, "PhoXiInterface")
+        .def(py::init<>())
+        .def("camera_list", &PhoXiInterface::cameraList, py::call_guard<py::gil_scoped_release>())
+        .def("connect_camera", [](PhoXiInterface& interface, const std::string& hardwareIdentification, int triggerMode, bool startAcquisition) {
+            interface.connectCamera(hardwareIdentification, (pho::api::PhoXiTriggerMode) triggerMode, startAcquisition);
+        }, py::arg("hardware_identification"), py::arg("trigger_mode") = 1, py::arg("start_acquisition") = true,
+           py::call_guard<py::gil_scoped_release>(), "trigger_mode: 0 = Free run, 1 = Software, 2 = Hardware")
+        .def("disconnect_camera", &PhoXiInterface::disconnectCamera, py::call_guard<py::gil_scoped_release>())
+        .def("is_connected", &PhoXiInterface::isConnected)
+        .def("is_acquiring", &PhoXiInterface::isAcquiring)
+        .def("start_acquisition", &PhoXiInterface::startAcquisition, py::call_guard<py::gil_scoped_release>())
+        .def("stop_acquisition", &PhoXiInterface::stopAcquisition, py::call_guard<py::gil_scoped_release>())
+        .def("trigger_image", &PhoXiInterface::triggerImage, py::call_guard<py::gil_scoped_release>())
+        .def("get_frame", &PhoXiInterface::getPFrame, py::arg("id") = -1, py::call_guard<py::gil_scoped_release>(),
+             "Trigger a frame when id < 0 and wait for the frame with id, the frame is post-processed")
+        .def("set_high_resolution", &PhoXiInterface::setHighResolution, py::call_guard<py::gil_scoped_release>())
+        .def("set_low_resolution", &PhoXiInterface::setLowResolution, py::call_guard<py::gil_scoped_release>())
+        .def("get_hardware_identification", &PhoXiInterface::getHardwareIdentification)
+        .def("set_coordinate_space", [](PhoXiInterface& interface, int space) {
+            interface.setCoordinateSpace((pho::api::PhoXiCoordinateSpace) space);
+        }, py::arg("space"), py::call_guard<py::gil_scoped_release>(), "1 = Camera, 2 = Mounting, 3 = Marker, 4 = Robot, 5 = Custom")
+        .def("get_point_cloud_from_frame", [](PhoXiInterface& interface, PFramePostProcessed frame, const Eigen::Matrix4f& transform) {
+            std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> cloud;
+            {
+                py::gil_scoped_release release;
+                cloud = interface.getPointCloudFromFrame<pcl::PointXYZ>(frame, Eigen::Affine3f(transform));
+            }
+            return pointFieldView(cloud, 0, cloudOwner(cloud));
+        }, py::arg("frame"), py::arg("transform") = Eigen::Matrix4f(Eigen::Matrix4f::Identity()),
+           "Filtered point cloud in meters, float32 (height, width, 3) with NaN for invalid points or (1, valid points, 3) "
+           "with only valid points. transform is a 4x4 matrix in meters applied to the points")
+        .def("get_point_cloud_with_normals_from_frame", [](PhoXiInterface& interface, PFramePostProcessed frame, const Eigen::Matrix4f& transform) {
+            std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> cloud;
+            {
+                py::gil_scoped_release release;
+                cloud = interface.getPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, Eigen::Affine3f(transform));
+            }
+            py::capsule owner = cloudOwner(cloud);
+            return py::make_tuple(pointFieldView(cloud, offsetof(pcl::PointXYZRGBNormal, x), owner),
+                                  pointFieldView(cloud, offsetof(pcl::PointXYZRGBNormal, normal_x), owner));
+        }, py::arg("frame"), py::arg("transform") = Eigen::Matrix4f(Eigen::Matrix4f::Identity()),
+           "Tuple of points and normals views of the same point cloud, see get_point_cloud_from_frame")
+        .def_property("texture_min_intensity", &PhoXiInterface::getTextureMinIntensity, &PhoXiInterface::setTextureMinIntensity)
+        .def_property("texture_max_intensity", &PhoXiInterface::getTextureMaxIntensity, &PhoXiInterface::setTextureMaxIntensity)
+        .def_property("texture_clahe_clip_limit", &PhoXiInterface::getTextureContrastLimitedAdaptiveHistogramEqualizationClipLimit,
+                      &PhoXiInterface::setTextureContrastLimitedAdaptiveHistogramEqualizationClipLimit)
+        .def_property("texture_clahe_size_x", &PhoXiInterface::getTextureContrastLimitedAdaptiveHistogramEqualizationSizeX,
+                      &PhoXiInterface::setTextureContrastLimitedAdaptiveHistogramEqualizationSizeX)
+        .def_property("texture_clahe_size_y", &PhoXiInterface::getTextureContrastLimitedAdaptiveHistogramEqualizationSizeY,
+                      &PhoXiInterface::setTextureContrastLimitedAdaptiveHistogramEqualizationSizeY)
+        .def_property("only_valid_points", &PhoXiInterface::getGeneratePointCloudWithOnlyValidPoints,
+                      &PhoXiInterface::setGeneratePointCloudWithOnlyValidPoints)
+        .def_property("min_confidence", &PhoXiInterface::getPointCloudMinConfidence, &PhoXiInterface::setPointCloudMinConfidence)
+        .def_property("jump_edge_max_depth_ratio", &PhoXiInterface::getPointCloudJumpEdgeMaxDepthRatio,
+                      &PhoXiInterface::setPointCloudJumpEdgeMaxDepthRatio)
+        .def_property("min_valid_neighbours", &PhoXiInterface::getPointCloudMinValidNeighbours,
+                      &PhoXiInterface::setPointCloudMinValidNeighbours);
+}
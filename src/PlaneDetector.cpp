@@ -0,0 +1,170 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/PlaneDetector.h"
+#include <Eigen/Eigenvalues>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <random>
+
+namespace phoxi_camera {
+
+    PlaneDetector::PlaneDetector() : inlierDistance(0.005f), iterations(200), minInlierRatio(0.2f), priorKeepRatio(0.9f),
+                                     planeFound(false), priorReused(false), normal(Eigen::Vector3f::UnitZ()), offset(0.0f),
+                                     inlierRatio(0.0f), detections(0) {
+    }
+
+    void PlaneDetector::setParameters(float inlierDistance, int iterations, float minInlierRatio, float priorKeepRatio) {
+        this->inlierDistance = std::max(0.0f, inlierDistance);
+        this->iterations = std::max(1, iterations);
+        this->minInlierRatio = std::max(0.0f, minInlierRatio);
+        this->priorKeepRatio = std::max(0.0f, priorKeepRatio);
+        reset();
+    }
+
+    void PlaneDetector::reset() {
+        planeFound = false;
+        priorReused = false;
+        inlierRatio = 0.0f;
+    }
+
+    size_t PlaneDetector::countInliers(const std::vector<Eigen::Vector3f>& points, const Eigen::Vector3f& planeNormal, float planeOffset, ThreadPool& threadPool) const {
+        std::atomic<size_t> inliers(0);
+        threadPool.parallelFor(0, (int) points.size(), [&](int begin, int end) {
+            size_t chunkInliers = 0;
+            for (int i = begin; i < end; ++i) {
+                chunkInliers += std::abs(planeNormal.dot(points[i]) + planeOffset) <= inlierDistance;
+            }
+            inliers.fetch_add(chunkInliers, std::memory_order_relaxed);
+        }, 4096);
+        return inliers.load();
+    }
+
+    bool PlaneDetector::refine(const std::vector<Eigen::Vector3f>& points, Eigen::Vector3f& planeNormal, float& planeOffset, ThreadPool& threadPool) const {
+        //least squares plane of the inliers: through their centroid, normal to the direction of least variance
+        std::mutex sumsMutex;
+        size_t count = 0;
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d sumOuter = Eigen::Matrix3d::Zero();
+        threadPool.parallelFor(0, (int) points.size(), [&](int begin, int end) {
+            size_t chunkCount = 0;
+            Eigen::Vector3d chunkSum = Eigen::Vector3d::Zero();
+            Eigen::Matrix3d chunkSumOuter = Eigen::Matrix3d::Zero();
+            for (int i = begin; i < end; ++i) {
+                if (std::abs(planeNormal.dot(points[i]) + planeOffset) <= inlierDistance) {
+                    const Eigen::Vector3d point = points[i].cast<double>();
+                    ++chunkCount;
+                    chunkSum += point;
+                    chunkSumOuter += point * point.transpose();
+                }
+            }
+            std::lock_guard<std::mutex> lock(sumsMutex);
+            count += chunkCount;
+            sum += chunkSum;
+            sumOuter += chunkSumOuter;
+        }, 4096);
+        if (count < 3) {
+            return false;
+        }
+        const Eigen::Vector3d centroid = sum / (double) count;
+        const Eigen::Matrix3d covariance = sumOuter / (double) count - centroid * centroid.transpose();
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver(covariance);
+        Eigen::Vector3f refinedNormal = solver.eigenvectors().col(0).cast<float>();
+        if (refinedNormal.dot(planeNormal) < 0.0f) {
+            refinedNormal = -refinedNormal;
+        }
+        planeNormal = refinedNormal;
+        planeOffset = -refinedNormal.dot(centroid.cast<float>());
+        return true;
+    }
+
+    bool PlaneDetector::detect(const std::vector<Eigen::Vector3f>& points, ThreadPool& threadPool) {
+        ++detections;
+        priorReused = false;
+        const size_t count = points.size();
+        if (count < 3) {
+            planeFound = false;
+            inlierRatio = 0.0f;
+            return false;
+        }
+
+        //the prior competes with the hypotheses and wins ties
+        size_t bestInliers = 0;
+        int bestHypothesis = -1;
+        Eigen::Vector3f bestNormal = normal;
+        float bestOffset = offset;
+        if (planeFound) {
+            bestInliers = countInliers(points, normal, offset, threadPool);
+            const float priorRatio = (float) bestInliers / count;
+            if (priorRatio >= minInlierRatio && priorRatio >= priorKeepRatio * inlierRatio) {
+                refine(points, normal, offset, threadPool);
+                inlierRatio = priorRatio;
+                priorReused = true;
+                return true;
+            }
+        }
+
+        std::mutex bestMutex;
+        threadPool.parallelFor(0, iterations, [&](int begin, int end) {
+            size_t chunkBestInliers = 0;
+            int chunkBestHypothesis = -1;
+            Eigen::Vector3f chunkBestNormal = Eigen::Vector3f::Zero();
+            float chunkBestOffset = 0.0f;
+            std::uniform_int_distribution<size_t> sample(0, count - 1);
+            for (int h = begin; h < end; ++h) {
+                std::minstd_rand generator((uint32_t) (detections * 2654435761u + h * 40503u + 1));
+                const size_t i0 = sample(generator), i1 = sample(generator), i2 = sample(generator);
+                if (i0 == i1 || i0 == i2 || i1 == i2) {
+                    continue;
+                }
+                Eigen::Vector3f hypothesisNormal = (points[i1] - points[i0]).cross(points[i2] - points[i0]);
+                const float norm = hypothesisNormal.norm();
+                if (norm < 1e-9f) {
+                    continue;
+                }
+                hypothesisNormal /= norm;
+                const float hypothesisOffset = -hypothesisNormal.dot(points[i0]);
+                size_t inliers = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    inliers += std::abs(hypothesisNormal.dot(points[i]) + hypothesisOffset) <= inlierDistance;
+                }
+                if (inliers > chunkBestInliers) {
+                    chunkBestInliers = inliers;
+                    chunkBestHypothesis = h;
+                    chunkBestNormal = hypothesisNormal;
+                    chunkBestOffset = hypothesisOffset;
+                }
+            }
+            //lower hypothesis index wins ties so that the result does not depend on the chunks
+            std::lock_guard<std::mutex> lock(bestMutex);
+            if (chunkBestHypothesis >= 0 && (chunkBestInliers > bestInliers ||
+                    (chunkBestInliers == bestInliers && bestHypothesis >= 0 && chunkBestHypothesis < bestHypothesis))) {
+                bestInliers = chunkBestInliers;
+                bestHypothesis = chunkBestHypothesis;
+                bestNormal = chunkBestNormal;
+                bestOffset = chunkBestOffset;
+            }
+        });
+
+        if (bestInliers < 3 || !refine(points, bestNormal, bestOffset, threadPool)) {
+            planeFound = false;
+            inlierRatio = (float) bestInliers / count;
+            return false;
+        }
+        //the normal points to the scanner at the origin
+        if (bestOffset < 0.0f) {
+            bestNormal = -bestNormal;
+            bestOffset = -bestOffset;
+        }
+        inlierRatio = (float) countInliers(points, bestNormal, bestOffset, threadPool) / count;
+        planeFound = inlierRatio >= minInlierRatio;
+        if (planeFound) {
+            normal = bestNormal;
+            offset = bestOffset;
+        }
+        return planeFound;
+    }
+}
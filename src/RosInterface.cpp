@@ -11,8 +11,10 @@
 #include <phoxi_camera/PhoXiException.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <cv_bridge/cv_bridge.h>
+#include <phoxi_camera/TraceRecorder.h>
+#include <algorithm>
 
-RosInterface::RosInterface() : nh("~"), mono8ImageTransport(nh), mono8CameraInfoManager(nh), dynamicReconfigureServer(dynamicReconfigureMutex,nh), PhoXi3DscannerDiagnosticTask("PhoXi3Dscanner",boost::bind(&RosInterface::diagnosticCallback, this, _1)) {
+RosInterface::RosInterface() : nh("~"), mono8ImageTransport(nh), mono8CameraInfoManager(nh), tfListener(tfBuffer), dynamicReconfigureServer(dynamicReconfigureMutex,nh), PhoXi3DscannerDiagnosticTask("PhoXi3Dscanner",boost::bind(&RosInterface::diagnosticCallback, this, _1)), FrameStatisticsDiagnosticTask("PhoXi3Dscanner frames",boost::bind(&RosInterface::frameStatisticsDiagnosticCallback, this, _1)), SchedulingDiagnosticTask("PhoXi3Dscanner scheduling",boost::bind(&RosInterface::schedulingDiagnosticCallback, this, _1)) {
 
     std::string scannerId;
     nh.param<std::string>("scanner_id", scannerId, "InstalledExamples-basic-example");
@@ -37,23 +39,68 @@ RosInterface::RosInterface() : nh("~"), mono8ImageTransport(nh), mono8CameraInfo
     getSupportedCapturingModesService = nh.advertiseService("get_supported_capturing_modes", &RosInterface::getSupportedCapturingModes, this);
     setCoordianteSpaceService = nh.advertiseService("V2/set_transformation",&RosInterface::setTransformation, this);
     setTransformationService = nh.advertiseService("V2/set_coordination_space",&RosInterface::setCoordianteSpace, this);
+    startTraceCaptureService = nh.advertiseService("start_trace_capture", &RosInterface::startTraceCapture, this);
+    stopTraceCaptureService = nh.advertiseService("stop_trace_capture", &RosInterface::stopTraceCapture, this);
+    captureBackgroundService = nh.advertiseService("capture_background", &RosInterface::captureBackground, this);
+    resetBackgroundService = nh.advertiseService("reset_background", &RosInterface::resetBackground, this);
+    extractTsdfService = nh.advertiseService("extract_tsdf", &RosInterface::extractTsdf, this);
+    resetTsdfService = nh.advertiseService("reset_tsdf", &RosInterface::resetTsdf, this);
+    setCaptureProfileService = nh.advertiseService("set_capture_profile", &RosInterface::setCaptureProfile, this);
 
     //create publishers
     bool latch_topics;
     int topic_queue_size;
     nh.param<bool>("latch_topics", latch_topics, false);
     nh.param<int>("topic_queue_size", topic_queue_size, 1);
-    cloudPub = nh.advertise <pcl::PointCloud<pcl::PointXYZ >>("pointcloud", 1,latch_topics);
+    cloudPub = nh.advertise < sensor_msgs::PointCloud2 > ("pointcloud", 1,latch_topics);
+    previewCloudPub = nh.advertise < sensor_msgs::PointCloud2 > ("pointcloud_preview", 1,latch_topics);
+    voxelGridCloudPub = nh.advertise < sensor_msgs::PointCloud2 > ("pointcloud_voxel_grid", 1,latch_topics);
+    //bands of a frame are published in a burst, the queue must hold all of them
+    cloudBandsPub = nh.advertise < phoxi_camera::PointCloudBand > ("pointcloud_bands", 256,false);
+    sceneChangePub = nh.advertise < phoxi_camera::SceneChange > ("scene_change", topic_queue_size,false);
+    cloudStatisticsPub = nh.advertise < phoxi_camera::PointCloudStatistics > ("pointcloud_statistics", topic_queue_size,false);
+    foregroundCloudPub = nh.advertise < sensor_msgs::PointCloud2 > ("pointcloud_foreground", 1,latch_topics);
+    meshPub = nh.advertise < phoxi_camera::PointCloudMesh > ("mesh", 1,latch_topics);
+    planePub = nh.advertise < phoxi_camera::DominantPlane > ("plane", topic_queue_size,latch_topics);
+    planeMaskPub = nh.advertise < sensor_msgs::Image > ("plane_mask", topic_queue_size,latch_topics);
+    tsdfCloudPub = nh.advertise < sensor_msgs::PointCloud2 > ("tsdf_cloud", 1,latch_topics);
     normalMapPub = nh.advertise < sensor_msgs::Image > ("normal_map", topic_queue_size,latch_topics);
     confidenceMapPub = nh.advertise < sensor_msgs::Image > ("confidence_map", topic_queue_size,latch_topics);
     depthMapPub = nh.advertise < sensor_msgs::Image > ("depth_map", topic_queue_size,latch_topics);
     rawTexturePub = nh.advertise < sensor_msgs::Image > ("texture", topic_queue_size,latch_topics);
+    initPointCloudTargetFrames(latch_topics);
+    initHeightMap(latch_topics);
+    //without frame id the scanner is assumed static and consecutive frames are averaged
+    nh.param<std::string>("tsdf_frame_id", tsdfFrameId, "");
+    initCaptureProfiles();
+    lastFrameLatency = 0.0;
 
+    std::string shared_memory_name;
+    nh.param<std::string>("shared_memory_name", shared_memory_name, "");
+    if (!shared_memory_name.empty()) {
+        int shared_memory_slots, shared_memory_max_width, shared_memory_max_height;
+        nh.param<int>("shared_memory_slots", shared_memory_slots, 4);
+        nh.param<int>("shared_memory_max_width", shared_memory_max_width, 2064);
+        nh.param<int>("shared_memory_max_height", shared_memory_max_height, 1544);
+        try {
+            sharedMemoryFrameWriter.reset(new phoxi_camera::SharedMemoryFrameWriter(shared_memory_name, std::max(1, shared_memory_slots),
+                                                                                   std::max(1, shared_memory_max_width), std::max(1, shared_memory_max_height)));
+            ROS_INFO("Publishing frames to shared memory %s", shared_memory_name.c_str());
+        } catch (PhoXiInterfaceException &e) {
+            ROS_ERROR("%s", e.what());
+        }
+    }
+    //after the shared memory is created, so that it is advised for huge pages before it is locked
+    initThreadScheduling();
+
+    //camera_info_url is the fallback when the calibration of the scanner is not used or can not be read
+    nh.param<bool>("camera_info_from_scanner", cameraInfoFromScanner, true);
     std::string camera_info_url;
     nh.param<std::string>("camera_info_url", camera_info_url, "");
     if (camera_info_url.empty())
     {
-        ROS_WARN("Missing camera_info_url.");
+        if (!cameraInfoFromScanner)
+            ROS_WARN("Missing camera_info_url.");
     }
     else
     {
@@ -75,14 +122,30 @@ RosInterface::RosInterface() : nh("~"), mono8ImageTransport(nh), mono8CameraInfo
     bool image_latched_publisher;
     nh.param<bool>("image_latched_publisher", image_latched_publisher, false);
     mono8CameraPublisher = mono8ImageTransport.advertiseCamera(image_base_topic, image_queue_size, image_latched_publisher);
+    //the rectified image shares the camera_info of image_raw, whose projection matrix describes the rectified image
+    rectifiedImagePub = mono8ImageTransport.advertise("image_rect", image_queue_size, image_latched_publisher);
+    depthCameraInfoPub = nh.advertise < sensor_msgs::CameraInfo > ("depth_map/camera_info", topic_queue_size,latch_topics);
+    textureCameraInfoPub = nh.advertise < sensor_msgs::CameraInfo > ("texture/camera_info", topic_queue_size,latch_topics);
 
-    //set dynamic reconfigure callback
+    //set dynamic reconfigure callback, the defaults are kept until a scanner is connected
+    dynamicReconfigureServer.getConfigDefault(dynamicReconfigureConfig);
     dynamicReconfigureServer.setCallback(boost::bind(&RosInterface::dynamicReconfigureCallback,this, _1, _2));
 
     //set diagnostic Hw id
     diagnosticUpdater.setHardwareID("none");
     diagnosticUpdater.add(PhoXi3DscannerDiagnosticTask);
-    diagnosticTimer  = nh.createTimer(ros::Duration(5.0),&RosInterface::diagnosticTimerCallback, this);
+    diagnosticUpdater.add(FrameStatisticsDiagnosticTask);
+    diagnosticUpdater.add(SchedulingDiagnosticTask);
+    double diagnosticsPeriod;
+    nh.param<double>("diagnostics_period", diagnosticsPeriod, 5.0);
+    nh.param<double>("diagnostics_min_frame_rate", diagnosticsMinFrameRate, 0.0);
+    nh.param<double>("diagnostics_max_frame_age", diagnosticsMaxFrameAge, 0.0);
+    nh.param<double>("diagnostics_latency_warn", diagnosticsLatencyWarn, 0.0);
+    nh.param<double>("diagnostics_latency_error", diagnosticsLatencyError, 0.0);
+    nh.param<double>("diagnostics_drop_ratio_warn", diagnosticsDropRatioWarn, 0.05);
+    nh.param<double>("diagnostics_drop_ratio_error", diagnosticsDropRatioError, 0.2);
+    previousFrameStatistics = frameStatistics.snapshot();
+    diagnosticTimer  = nh.createTimer(ros::Duration(diagnosticsPeriod),&RosInterface::diagnosticTimerCallback, this);
     diagnosticTimer.start();
 
     //connect to default scanner
@@ -97,6 +160,7 @@ RosInterface::RosInterface() : nh("~"), mono8ImageTransport(nh), mono8CameraInfo
 }
 
 bool RosInterface::getDeviceList(phoxi_camera::GetDeviceList::Request &req, phoxi_camera::GetDeviceList::Response &res){
+    phoxi_camera::TraceScope trace("service get_device_list", "RosInterface");
     try {
         res.out = PhoXiInterface::cameraList();
         res.len = res.out.size();
@@ -109,6 +173,7 @@ bool RosInterface::getDeviceList(phoxi_camera::GetDeviceList::Request &req, phox
     return true;
 }
 bool RosInterface::connectCamera(phoxi_camera::ConnectCamera::Request &req, phoxi_camera::ConnectCamera::Response &res){
+    phoxi_camera::TraceScope trace("service connect_camera", "RosInterface");
     try {
         RosInterface::connectCamera(req.name);
         res.success = true;
@@ -120,26 +185,31 @@ bool RosInterface::connectCamera(phoxi_camera::ConnectCamera::Request &req, phox
     return true;
 }
 bool RosInterface::isConnected(phoxi_camera::IsConnected::Request &req, phoxi_camera::IsConnected::Response &res){
+    phoxi_camera::TraceScope trace("service is_connected", "RosInterface");
     res.connected = PhoXiInterface::isConnected();
     return true;
 }
 bool RosInterface::isAcquiring(phoxi_camera::IsAcquiring::Request &req, phoxi_camera::IsAcquiring::Response &res){
+    phoxi_camera::TraceScope trace("service is_acquiring", "RosInterface");
     res.is_acquiring = PhoXiInterface::isAcquiring();
     return true;
 }
 bool RosInterface::isConnected(phoxi_camera::GetBool::Request &req, phoxi_camera::GetBool::Response &res){
+    phoxi_camera::TraceScope trace("service V2/is_connected", "RosInterface");
     res.value = PhoXiInterface::isConnected();
     res.message = OKRESPONSE; //todo tot este premysliet
     res.success = true;
     return true;
 }
 bool RosInterface::isAcquiring(phoxi_camera::GetBool::Request &req, phoxi_camera::GetBool::Response &res){
+    phoxi_camera::TraceScope trace("service V2/is_acquiring", "RosInterface");
     res.value = PhoXiInterface::isAcquiring();
     res.message = OKRESPONSE; //todo tot este premysliet
     res.success = true;
     return true;
 }
 bool RosInterface::startAcquisition(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service start_acquisition", "RosInterface");
     try {
         PhoXiInterface::startAcquisition();
         diagnosticUpdater.force_update();
@@ -149,6 +219,7 @@ bool RosInterface::startAcquisition(std_srvs::Empty::Request &req, std_srvs::Emp
     return true;
 }
 bool RosInterface::stopAcquisition(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service stop_acquisition", "RosInterface");
     try {
         PhoXiInterface::stopAcquisition();
         diagnosticUpdater.force_update();
@@ -158,6 +229,7 @@ bool RosInterface::stopAcquisition(std_srvs::Empty::Request &req, std_srvs::Empt
     return true;
 }
 bool RosInterface::startAcquisition(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service V2/start_acquisition", "RosInterface");
     try {
         //todo
         PhoXiInterface::startAcquisition();
@@ -170,6 +242,7 @@ bool RosInterface::startAcquisition(phoxi_camera::Empty::Request &req, phoxi_cam
     return true;
 }
 bool RosInterface::stopAcquisition(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service V2/stop_acquisition", "RosInterface");
     try {
         PhoXiInterface::stopAcquisition();
         res.message = OKRESPONSE;
@@ -181,6 +254,7 @@ bool RosInterface::stopAcquisition(phoxi_camera::Empty::Request &req, phoxi_came
     return true;
 }
 bool RosInterface::triggerImage(phoxi_camera::TriggerImage::Request &req, phoxi_camera::TriggerImage::Response &res){
+    phoxi_camera::TraceScope trace("service trigger_image", "RosInterface");
     try {
         res.id = RosInterface::triggerImage();
         res.success = true;
@@ -192,6 +266,7 @@ bool RosInterface::triggerImage(phoxi_camera::TriggerImage::Request &req, phoxi_
     return true;
 }
 bool RosInterface::getFrame(phoxi_camera::GetFrame::Request &req, phoxi_camera::GetFrame::Response &res){
+    phoxi_camera::TraceScope trace("service get_frame", "RosInterface");
     try {
         PFramePostProcessed frame = getPFrame(req.in);
         publishFrame(frame);
@@ -210,6 +285,7 @@ bool RosInterface::getFrame(phoxi_camera::GetFrame::Request &req, phoxi_camera::
     return true;
 }
 bool RosInterface::saveFrame(phoxi_camera::SaveFrame::Request &req, phoxi_camera::SaveFrame::Response &res){
+    phoxi_camera::TraceScope trace("service save_frame", "RosInterface");
     try {
         PFramePostProcessed frame = RosInterface::getPFrame(req.in);
         if(!frame || !frame->PFrame){
@@ -237,7 +313,154 @@ bool RosInterface::saveFrame(phoxi_camera::SaveFrame::Request &req, phoxi_camera
     }
     return true;
 }
+bool RosInterface::startTraceCapture(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res){
+    int eventsPerThread;
+    nh.param<int>("trace_events_per_thread", eventsPerThread, 65536);
+    phoxi_camera::TraceRecorder::instance().start(eventsPerThread);
+    res.message = OKRESPONSE;
+    res.success = true;
+    return true;
+}
+bool RosInterface::captureBackground(phoxi_camera::CaptureBackground::Request &req, phoxi_camera::CaptureBackground::Response &res){
+    phoxi_camera::TraceScope trace("service capture_background", "RosInterface");
+    try {
+        backgroundModel.reset();
+        for (uint32_t i = 0; i < std::max<uint32_t>(1, req.frames); ++i) {
+            PFramePostProcessed frame = getPFrame(-1);
+            if (!frame || !frame->PFrame || !frame->PFrame->Successful) {
+                throw CorruptedFrame("Corrupted frame!");
+            }
+            backgroundModel.addFrame(*frame->PFrame);
+        }
+        res.learned_frames = backgroundModel.getLearnedFrames();
+        res.success = true;
+        res.message = OKRESPONSE;
+    }catch (PhoXiInterfaceException &e){
+        res.learned_frames = backgroundModel.getLearnedFrames();
+        res.success = false;
+        res.message = e.what();
+    }
+    return true;
+}
+bool RosInterface::resetBackground(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service reset_background", "RosInterface");
+    backgroundModel.reset();
+    res.success = true;
+    res.message = OKRESPONSE;
+    return true;
+}
+bool RosInterface::extractTsdf(phoxi_camera::ExtractTsdf::Request &req, phoxi_camera::ExtractTsdf::Response &res){
+    phoxi_camera::TraceScope trace("service extract_tsdf", "RosInterface");
+    std::vector<Eigen::Vector3f> points;
+    std::vector<uint8_t> intensities;
+    tsdfVolume.extractSurface(points, intensities, req.min_weight, threadPool);
+    pcl::PointCloud<pcl::PointXYZI> cloud;
+    cloud.points.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        cloud.points[i].x = points[i].x();
+        cloud.points[i].y = points[i].y();
+        cloud.points[i].z = points[i].z();
+        cloud.points[i].intensity = intensities[i];
+    }
+    cloud.width = (uint32_t) cloud.points.size();
+    cloud.height = 1;
+    cloud.is_dense = true;
+    sensor_msgs::PointCloud2 output_cloud;
+    pcl::toROSMsg(cloud, output_cloud);
+    output_cloud.header.stamp = ros::Time::now();
+    output_cloud.header.frame_id = tsdfFrameId.empty() ? frameId : tsdfFrameId;
+    tsdfCloudPub.publish(output_cloud);
+    res.points = (uint32_t) points.size();
+    res.integrated_frames = tsdfVolume.getIntegratedFrames();
+    res.blocks = (uint32_t) tsdfVolume.getBlockCount();
+    res.memory = tsdfVolume.getMemoryUsage() / (1024.0 * 1024.0);
+    res.success = true;
+    res.message = OKRESPONSE;
+    return true;
+}
+bool RosInterface::resetTsdf(phoxi_camera::Empty::Request &req, phoxi_camera::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service reset_tsdf", "RosInterface");
+    tsdfVolume.reset();
+    res.success = true;
+    res.message = OKRESPONSE;
+    return true;
+}
+bool RosInterface::setCaptureProfile(phoxi_camera::SetCaptureProfile::Request &req, phoxi_camera::SetCaptureProfile::Response &res){
+    phoxi_camera::TraceScope trace("service set_capture_profile", "RosInterface");
+    std::map<std::string, CaptureProfile>::const_iterator profile = captureProfiles.find(req.name);
+    if (profile == captureProfiles.end()) {
+        res.success = false;
+        res.message = "Capture profile " + req.name + " not found!";
+        return true;
+    }
+    try {
+        //the settings of the scanner are mirrored in dynamic reconfigure, no need to read them from the device
+        CaptureProfile current;
+        current.resolution = dynamicReconfigureConfig.resolution;
+        current.scanMultiplier = dynamicReconfigureConfig.scan_multiplier;
+        current.shutterMultiplier = dynamicReconfigureConfig.shutter_multiplier;
+        current.confidence = dynamicReconfigureConfig.confidence;
+        //adaptive quality wins over the resolution of the profile, which is applied when the quality is restored
+        CaptureProfile deviceProfile = profile->second;
+        const bool resolutionDeferred = isResolutionReduced() && deviceProfile.resolution >= 0;
+        if (resolutionDeferred) {
+            deviceProfile.resolution = -1;
+        }
+
+        ros::WallTime start = ros::WallTime::now();
+        res.device_writes = PhoXiInterface::setCaptureProfile(deviceProfile, current);
+        res.latency = (ros::WallTime::now() - start).toSec();
+        if (resolutionDeferred) {
+            ROS_INFO("Capture profile %s resolution applied when adaptive quality restores the resolution", req.name.c_str());
+        }
+
+        if (profile->second.resolution >= 0) dynamicReconfigureConfig.resolution = profile->second.resolution;
+        if (profile->second.scanMultiplier > 0) dynamicReconfigureConfig.scan_multiplier = profile->second.scanMultiplier;
+        if (profile->second.shutterMultiplier > 0) dynamicReconfigureConfig.shutter_multiplier = profile->second.shutterMultiplier;
+        if (profile->second.confidence >= 0.0) dynamicReconfigureConfig.confidence = profile->second.confidence;
+        dynamicReconfigureServer.updateConfig(dynamicReconfigureConfig);
+        activeCaptureProfile = req.name;
+        captureProfileSwitchLatency = res.latency;
+        ROS_INFO("Capture profile %s set in %.1f ms with %u device writes", req.name.c_str(), res.latency * 1000.0, res.device_writes);
+        res.success = true;
+        res.message = OKRESPONSE;
+    }catch (PhoXiInterfaceException &e){
+        //the settings of the scanner are unknown after a partial switch
+        activeCaptureProfile.clear();
+        res.success = false;
+        res.message = e.what();
+    }
+    return true;
+}
+bool RosInterface::stopTraceCapture(phoxi_camera::SaveTrace::Request &req, phoxi_camera::SaveTrace::Response &res){
+    try {
+        if (!phoxi_camera::TraceRecorder::instance().isRecording()) {
+            res.success = false;
+            res.message = "Trace capture not started!";
+            return true;
+        }
+        size_t pos = req.path.find("~");
+        if(pos != std::string::npos){
+            char* home = std::getenv("HOME");
+            if(!home){
+                res.message = "'~' found in 'path' parameter but environment variable 'HOME' not found. Export' HOME' variable or pass absolute value to 'path' parameter.";
+                res.success = false;
+                return true;
+            }
+            req.path.replace(pos,1,home);
+        }
+        res.events = phoxi_camera::TraceRecorder::instance().stop(req.path);
+        ROS_INFO("Trace with %lu events saved to %s", (unsigned long) res.events, req.path.c_str());
+        res.message = OKRESPONSE;
+        res.success = true;
+    }catch (PhoXiInterfaceException &e){
+        res.success = false;
+        res.message = e.what();
+    }
+    return true;
+}
 bool RosInterface::disconnectCamera(std_srvs::Empty::Request &req, std_srvs::Empty::Response &res){
+    phoxi_camera::TraceScope trace("service disconnect_camera", "RosInterface");
     try {
         PhoXiInterface::disconnectCamera();
         diagnosticUpdater.force_update();
@@ -247,6 +470,7 @@ bool RosInterface::disconnectCamera(std_srvs::Empty::Request &req, std_srvs::Emp
     return true;
 }
 bool RosInterface::getHardwareIdentification(phoxi_camera::GetHardwareIdentification::Request &req, phoxi_camera::GetHardwareIdentification::Response &res){
+    phoxi_camera::TraceScope trace("service get_hardware_indentification", "RosInterface");
     try {
         res.hardware_identification = PhoXiInterface::getHardwareIdentification();
         res.success = true;
@@ -258,6 +482,7 @@ bool RosInterface::getHardwareIdentification(phoxi_camera::GetHardwareIdentifica
     return true;
 }
 bool RosInterface::getSupportedCapturingModes(phoxi_camera::GetSupportedCapturingModes::Request &req, phoxi_camera::GetSupportedCapturingModes::Response &res){
+    phoxi_camera::TraceScope trace("service get_supported_capturing_modes", "RosInterface");
     try {
         std::vector<pho::api::PhoXiCapturingMode> modes = PhoXiInterface::getSupportedCapturingModes();
         for(int i =0; i < modes.size(); i++){
@@ -280,6 +505,7 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
         ROS_WARN("NUll frame!");
         return;
     }
+    phoxi_camera::TraceScope trace("publishFrame", "RosInterface", frame->PFrame->Info.FrameIndex);
 
     ros::Time timeNow = ros::Time::now();
 
@@ -288,19 +514,106 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
     header.frame_id = frameId;
     header.seq = frame->PFrame->Info.FrameIndex;
 
-    if (scanner->OutputSettings->SendPointCloud) {
+    if (sharedMemoryFrameWriter) {
+        phoxi_camera::TraceScope trace("publish shared memory", "RosInterface", header.seq);
+        if (!sharedMemoryFrameWriter->write(*frame->PFrame, (int64_t) header.stamp.toNSec())) {
+            ROS_WARN_THROTTLE(10, "Frame is bigger than the shared memory slots, increase shared_memory_max_width and shared_memory_max_height.");
+        }
+    }
+
+    //outputs are mirrored in dynamic reconfigure, reading them from the scanner would cost a round trip per frame
+    const bool optionalMapsDropped = dynamicReconfigureConfig.adaptive_quality && adaptiveQualityController.getLevel() >= 1;
+    const bool sendNormalMap = dynamicReconfigureConfig.send_normal_map && !optionalMapsDropped;
+    const bool sendConfidenceMap = dynamicReconfigureConfig.send_confidence_map && (!optionalMapsDropped || dynamicReconfigureConfig.point_cloud_min_confidence > 0.0);
+
+    //point clouds of a static scene are not generated, the scene_change heartbeat is published instead
+    bool sceneChanged = true;
+    if (dynamicReconfigureConfig.scene_change_detection) {
+        phoxi_camera::SceneChange sceneChange;
+        {
+            phoxi_camera::TraceScope trace("scene change detection", "RosInterface", header.seq);
+            sceneChanged = sceneChangeDetector.update(*frame->PFrame);
+        }
+        sceneChange.header = header;
+        sceneChange.changed = sceneChanged;
+        sceneChange.changed_ratio = sceneChangeDetector.getChangedRatio();
+        sceneChange.unchanged_frames = sceneChangeDetector.getUnchangedFrames();
+        sceneChangePub.publish(sceneChange);
+    }
+
+    if (sceneChanged && dynamicReconfigureConfig.send_point_cloud) {
         if (frame->PFrame->PointCloud.Empty()){
             ROS_WARN("Empty point cloud!");
         } else {
-            auto cloud = PhoXiInterface::getPointCloudFromFrame(frame);
-            sensor_msgs::PointCloud2 output_cloud;
-            pcl::toROSMsg(*cloud,output_cloud);
-            output_cloud.header = header;
-            cloudPub.publish(output_cloud);
+            //the preview is published first so that low latency consumers do not wait for the full point cloud
+            if (dynamicReconfigureConfig.preview_point_cloud_downsampling > 1) {
+                sensor_msgs::PointCloud2 preview_cloud;
+                getPreviewPointCloudMsgFromFrame(frame, preview_cloud);
+                preview_cloud.header = header;
+                phoxi_camera::TraceScope trace("publish pointcloud_preview", "RosInterface", header.seq);
+                previewCloudPub.publish(preview_cloud);
+                frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloudPreview, preview_cloud.data.size());
+            }
+            //the plane is estimated before the conversions which discard its points, only the conversions of this frame
+            bool planeRemoval = false;
+            if (dynamicReconfigureConfig.plane_detection > 0) {
+                publishDominantPlane(frame, header);
+                planeRemoval = planeDetector.hasPlane() && dynamicReconfigureConfig.plane_detection == 2;
+            }
+            ScopedPointCloudPlaneRemoval planeRemovalScope(*this, planeRemoval, planeDetector.getPlane(), (float) dynamicReconfigureConfig.plane_distance_threshold);
+            //the voxel grid is small, it is published before the full resolution point cloud
+            if (dynamicReconfigureConfig.voxel_grid_leaf_size > 0.0) {
+                publishVoxelGridPointCloud(frame, header);
+            }
+            //statistics are accumulated by the conversion of the full resolution point cloud, only when someone listens
+            PointCloudStatistics statistics;
+            PointCloudStatistics* statisticsOutput = cloudStatisticsPub.getNumSubscribers() > 0 ? &statistics : nullptr;
+            //consumers of the voxel grid only can skip the conversion of the full resolution point cloud
+            if (dynamicReconfigureConfig.publish_full_point_cloud) {
+                if (dynamicReconfigureConfig.point_cloud_band_rows > 0) {
+                    publishPointCloudBands(frame, header, statisticsOutput);
+                } else {
+                    sensor_msgs::PointCloud2 output_cloud;
+                    if (isPointCloudDecimated()) {
+                        dispatchPointCloudType([&](auto point) {
+                            typedef decltype(point) PointT;
+                            pcl::toROSMsg(*PhoXiInterface::getPreviewPointCloudFromFrame<PointT>(frame, 2, PreviewPooling::MinDepth), output_cloud);
+                        });
+                    } else {
+                        getPointCloudMsgFromFrame(frame, output_cloud, Eigen::Affine3f::Identity(), statisticsOutput);
+                    }
+                    output_cloud.header = header;
+                    phoxi_camera::TraceScope trace("publish pointcloud", "RosInterface", header.seq);
+                    cloudPub.publish(output_cloud);
+                    frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloud, output_cloud.data.size());
+                }
+                //the target frames are full resolution point clouds as well
+                publishPointCloudTargetFrames(frame, header);
+            }
+            //the full resolution point cloud is not converted at adaptive level 3 or for voxel grid only consumers,
+            //the statistics then take a pass of their own
+            if (statisticsOutput && statistics.totalPoints == 0) {
+                PhoXiInterface::getPointCloudStatisticsFromFrame(frame, statistics);
+            }
+            if (statisticsOutput && statistics.totalPoints > 0) {
+                publishPointCloudStatistics(frame, header, statistics);
+            }
+            if (dynamicReconfigureConfig.publish_foreground_point_cloud) {
+                publishForegroundPointCloud(frame, header);
+            }
+            if (dynamicReconfigureConfig.publish_mesh) {
+                publishMesh(frame, header);
+            }
+            if (dynamicReconfigureConfig.publish_height_map) {
+                publishHeightMap(frame, header);
+            }
+            if (dynamicReconfigureConfig.tsdf_fusion) {
+                integrateTsdf(frame, header);
+            }
         }
     }
 
-    if (scanner->OutputSettings->SendDepthMap) {
+    if (dynamicReconfigureConfig.send_deapth_map) {
         if(frame->PFrame->DepthMap.Empty()){
             ROS_WARN("Empty depth map!");
         } else {
@@ -313,11 +626,14 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
                                    frame->PFrame->DepthMap.Size.Width, // width
                                    frame->PFrame->DepthMap.Size.Width * sizeof(float), // stepSize
                                    frame->PFrame->DepthMap.operator[](0));
+            phoxi_camera::TraceScope trace("publish depth_map", "RosInterface", header.seq);
             depthMapPub.publish(depth_map);
+            depthCameraInfoPub.publish(getCameraInfo(frame->PFrame->DepthMap.Size, header));
+            frameStatistics.outputPublished(phoxi_camera::OutputChannel::DepthMap, depth_map.data.size());
         }
     }
 
-    if (scanner->OutputSettings->SendTexture) {
+    if (dynamicReconfigureConfig.send_texture) {
         if (frame->PFrame->Texture.Empty()) {
             ROS_WARN("Empty texture!");
         } else {
@@ -329,17 +645,32 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
                                    frame->PFrame->Texture.Size.Width, // width
                                    frame->PFrame->Texture.Size.Width * sizeof(float), // stepSize
                                    frame->PFrame->Texture.operator[](0));
-            rawTexturePub.publish(texture);
+            {
+                phoxi_camera::TraceScope textureTrace("publish texture", "RosInterface", header.seq);
+                rawTexturePub.publish(texture);
+                textureCameraInfoPub.publish(getCameraInfo(frame->PFrame->Texture.Size, header));
+                frameStatistics.outputPublished(phoxi_camera::OutputChannel::Texture, texture.data.size());
+            }
 
             cv_bridge::CvImage mono8Texture(header, sensor_msgs::image_encodings::MONO8, frame->TextureAfterPostProcessing);
             sensor_msgs::ImagePtr mono8_image_msg = mono8Texture.toImageMsg();
-            sensor_msgs::CameraInfo camera_info = mono8CameraInfoManager.getCameraInfo();
-            camera_info.header = mono8_image_msg->header;
-            mono8CameraPublisher.publish(*mono8_image_msg, camera_info);
+            sensor_msgs::CameraInfo camera_info = getCameraInfo(frame->PFrame->Texture.Size, mono8_image_msg->header);
+            {
+                phoxi_camera::TraceScope mono8Trace("publish image_raw", "RosInterface", header.seq);
+                mono8CameraPublisher.publish(*mono8_image_msg, camera_info);
+                frameStatistics.outputPublished(phoxi_camera::OutputChannel::Image, mono8_image_msg->data.size());
+            }
+            if (!frame->TextureRectified.empty()) {
+                cv_bridge::CvImage rectifiedTexture(header, sensor_msgs::image_encodings::MONO8, frame->TextureRectified);
+                sensor_msgs::ImagePtr image_rect_msg = rectifiedTexture.toImageMsg();
+                phoxi_camera::TraceScope rectifiedTrace("publish image_rect", "RosInterface", header.seq);
+                rectifiedImagePub.publish(image_rect_msg);
+                frameStatistics.outputPublished(phoxi_camera::OutputChannel::ImageRect, image_rect_msg->data.size());
+            }
         }
     }
 
-    if (scanner->OutputSettings->SendConfidenceMap) {
+    if (sendConfidenceMap) {
         if (frame->PFrame->ConfidenceMap.Empty()){
             ROS_WARN("Empty confidence map!");
         } else {
@@ -352,11 +683,13 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
                                    frame->PFrame->ConfidenceMap.Size.Width, // width
                                    frame->PFrame->ConfidenceMap.Size.Width * sizeof(float), // stepSize
                                    frame->PFrame->ConfidenceMap.operator[](0));
+            phoxi_camera::TraceScope trace("publish confidence_map", "RosInterface", header.seq);
             confidenceMapPub.publish(confidence_map);
+            frameStatistics.outputPublished(phoxi_camera::OutputChannel::ConfidenceMap, confidence_map.data.size());
         }
     }
 
-    if (scanner->OutputSettings->SendNormalMap) {
+    if (sendNormalMap) {
         if (frame->PFrame->NormalMap.Empty()){
             ROS_WARN("Empty normal map!");
         } else {
@@ -369,12 +702,379 @@ void RosInterface::publishFrame(PFramePostProcessed frame) {
                                    frame->PFrame->NormalMap.Size.Width, // width
                                    frame->PFrame->NormalMap.Size.Width * sizeof(float) * 3, // stepSize
                                    frame->PFrame->NormalMap.operator[](0));
+            phoxi_camera::TraceScope trace("publish normal_map", "RosInterface", header.seq);
             normalMapPub.publish(normal_map);
+            frameStatistics.outputPublished(phoxi_camera::OutputChannel::NormalMap, normal_map.data.size());
         }
     }
+
+    lastFrameLatency = std::chrono::duration<double>(std::chrono::steady_clock::now() - frame->TriggerTime).count();
+    frameStatistics.framePublished(lastFrameLatency);
+    if (dynamicReconfigureConfig.adaptive_quality) {
+        int previousLevel = adaptiveQualityController.getLevel();
+        if (adaptiveQualityController.update(lastFrameLatency)) {
+            ROS_INFO("Adaptive quality %s", adaptiveQualityController.getLastDecision().c_str());
+            try {
+                applyAdaptiveQualityLevel(adaptiveQualityController.getLevel(), previousLevel);
+            }catch (PhoXiInterfaceException &e){
+                ROS_WARN("%s",e.what());
+            }
+        }
+    }
+}
+
+void RosInterface::applyAdaptiveQualityLevel(int level, int previousLevel) {
+    //level 1 drops the optional output channels, level 2 reduces the resolution and level 3 decimates the point cloud
+    this->isOk();
+    if ((level >= 1) != (previousLevel >= 1)) {
+        pho::api::PhoXiOutputSettings outputs = scanner->OutputSettings;
+        outputs.SendNormalMap = dynamicReconfigureConfig.send_normal_map && level < 1;
+        //the confidence map is kept when it is needed by the point cloud filter
+        outputs.SendConfidenceMap = dynamicReconfigureConfig.send_confidence_map && (level < 1 || dynamicReconfigureConfig.point_cloud_min_confidence > 0.0);
+        scanner->OutputSettings = outputs;
+    }
+    if ((level >= 2) != (previousLevel >= 2)) {
+        if (level >= 2 || dynamicReconfigureConfig.resolution == 0) {
+            PhoXiInterface::setLowResolution();
+        } else {
+            PhoXiInterface::setHighResolution();
+        }
+    }
+}
+
+void RosInterface::getPointCloudMsgFromFrame(PFramePostProcessed frame, sensor_msgs::PointCloud2& output, const Eigen::Affine3f& transform, PointCloudStatistics* statistics) {
+    dispatchPointCloudType([&](auto point) {
+        typedef decltype(point) PointT;
+        pcl::toROSMsg(*PhoXiInterface::getPointCloudFromFrame<PointT>(frame, transform, statistics), output);
+    });
+}
+
+void RosInterface::getPreviewPointCloudMsgFromFrame(PFramePostProcessed frame, sensor_msgs::PointCloud2& output) {
+    PreviewPooling pooling = dynamicReconfigureConfig.preview_point_cloud_pooling == 1 ? PreviewPooling::MedianDepth : PreviewPooling::MinDepth;
+    dispatchPointCloudType([&](auto point) {
+        typedef decltype(point) PointT;
+        pcl::toROSMsg(*PhoXiInterface::getPreviewPointCloudFromFrame<PointT>(frame, dynamicReconfigureConfig.preview_point_cloud_downsampling, pooling), output);
+    });
+}
+
+void RosInterface::publishPointCloudBands(PFramePostProcessed frame, const std_msgs::Header& header, PointCloudStatistics* statistics) {
+    phoxi_camera::PointCloudBand band;
+    band.frame_index = frame->PFrame->Info.FrameIndex;
+    auto publishBand = [&]() {
+        band.cloud.header = header;
+        phoxi_camera::TraceScope trace("publish pointcloud band", "RosInterface", header.seq);
+        cloudBandsPub.publish(band);
+        frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloudBands, band.cloud.data.size());
+    };
+    if (isPointCloudDecimated()) {
+        //the bands are cut from the decimated point cloud, rows and frame height are those of the decimated cloud
+        dispatchPointCloudType([&](auto point) {
+            typedef decltype(point) PointT;
+            std::shared_ptr<pcl::PointCloud<PointT>> cloud = PhoXiInterface::getPreviewPointCloudFromFrame<PointT>(frame, 2, PreviewPooling::MinDepth);
+            const int height = cloud->height;
+            const int bandRows = std::max(1, dynamicReconfigureConfig.point_cloud_band_rows / 2);
+            band.band_count = (uint32_t) ((height + bandRows - 1) / bandRows);
+            band.frame_height = height;
+            for (uint32_t b = 0; b < band.band_count; ++b) {
+                const int rowBegin = b * bandRows;
+                const int rowEnd = std::min(height, rowBegin + bandRows);
+                pcl::PointCloud<PointT> bandCloud;
+                bandCloud.points.assign(cloud->points.begin() + (size_t) rowBegin * cloud->width, cloud->points.begin() + (size_t) rowEnd * cloud->width);
+                bandCloud.width = cloud->width;
+                bandCloud.height = rowEnd - rowBegin;
+                bandCloud.is_dense = cloud->is_dense;
+                pcl::toROSMsg(bandCloud, band.cloud);
+                band.band_index = b;
+                band.row_offset = rowBegin;
+                publishBand();
+            }
+        });
+        return;
+    }
+    const int height = frame->PFrame->PointCloud.Size.Height;
+    const int bandRows = dynamicReconfigureConfig.point_cloud_band_rows;
+    band.band_count = (uint32_t) ((height + bandRows - 1) / bandRows);
+    band.frame_height = height;
+    for (uint32_t b = 0; b < band.band_count; ++b) {
+        const int rowBegin = b * bandRows;
+        const int rowEnd = std::min(height, rowBegin + bandRows);
+        band.band_index = b;
+        band.row_offset = rowBegin;
+        dispatchPointCloudType([&](auto point) {
+            typedef decltype(point) PointT;
+            pcl::toROSMsg(*PhoXiInterface::getPointCloudBandFromFrame<PointT>(frame, rowBegin, rowEnd, Eigen::Affine3f::Identity(), statistics), band.cloud);
+        });
+        publishBand();
+    }
+}
+
+void RosInterface::publishVoxelGridPointCloud(PFramePostProcessed frame, const std_msgs::Header& header) {
+    sensor_msgs::PointCloud2 voxel_grid_cloud;
+    dispatchPointCloudType([&](auto point) {
+        typedef decltype(point) PointT;
+        pcl::toROSMsg(*PhoXiInterface::getVoxelGridPointCloudFromFrame<PointT>(frame, (float) dynamicReconfigureConfig.voxel_grid_leaf_size), voxel_grid_cloud);
+    });
+    voxel_grid_cloud.header = header;
+    phoxi_camera::TraceScope trace("publish pointcloud_voxel_grid", "RosInterface", header.seq);
+    voxelGridCloudPub.publish(voxel_grid_cloud);
+    frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloudVoxelGrid, voxel_grid_cloud.data.size());
+}
+
+void RosInterface::publishMesh(PFramePostProcessed frame, const std_msgs::Header& header) {
+    PhoXiInterface::getMeshFromFrame(frame, mesh, (float) dynamicReconfigureConfig.mesh_max_edge_length, dynamicReconfigureConfig.mesh_decimation);
+    phoxi_camera::PointCloudMesh msg;
+    msg.header = header;
+    msg.grid_width = mesh.width;
+    msg.grid_height = mesh.height;
+    msg.grid_step = mesh.step;
+    msg.vertices = mesh.vertices;
+    msg.triangles = mesh.triangles;
+    phoxi_camera::TraceScope trace("publish mesh", "RosInterface", header.seq);
+    meshPub.publish(msg);
+    frameStatistics.outputPublished(phoxi_camera::OutputChannel::Mesh, (msg.vertices.size() + msg.triangles.size()) * 4);
+}
+
+void RosInterface::publishPointCloudStatistics(PFramePostProcessed frame, const std_msgs::Header& header, const PointCloudStatistics& statistics) {
+    phoxi_camera::PointCloudStatistics msg;
+    msg.header = header;
+    msg.width = frame->PFrame->PointCloud.Size.Width;
+    msg.height = frame->PFrame->PointCloud.Size.Height;
+    msg.valid_points = (uint32_t) statistics.validPoints;
+    msg.valid_ratio = (float) statistics.validPoints / statistics.totalPoints;
+    if (statistics.validPoints > 0) {
+        msg.bounding_box_min.x = statistics.boundingBoxMin.x();
+        msg.bounding_box_min.y = statistics.boundingBoxMin.y();
+        msg.bounding_box_min.z = statistics.boundingBoxMin.z();
+        msg.bounding_box_max.x = statistics.boundingBoxMax.x();
+        msg.bounding_box_max.y = statistics.boundingBoxMax.y();
+        msg.bounding_box_max.z = statistics.boundingBoxMax.z();
+        msg.depth_min = statistics.depthMin;
+        msg.depth_max = statistics.depthMax;
+        msg.depth_mean = (float) (statistics.depthSum / statistics.validPoints);
+    }
+    if (statistics.confidencePoints > 0) {
+        msg.confidence_mean = (float) (statistics.confidenceSum / statistics.confidencePoints);
+    }
+    if (!frame->TextureAfterPostProcessing.empty()) {
+        msg.texture_histogram.assign(statistics.textureHistogram, statistics.textureHistogram + PointCloudStatistics::TextureHistogramBins);
+    }
+    cloudStatisticsPub.publish(msg);
+}
+
+void RosInterface::publishForegroundPointCloud(PFramePostProcessed frame, const std_msgs::Header& header) {
+    if (!backgroundModel.isLearned()) {
+        ROS_WARN_THROTTLE(10, "Background not captured, call capture_background service to publish the foreground point cloud.");
+        return;
+    }
+    {
+        phoxi_camera::TraceScope trace("foreground mask", "RosInterface", header.seq);
+        backgroundModel.computeForegroundMask(*frame->PFrame, dynamicReconfigureConfig.background_depth_threshold, foregroundMask);
+    }
+    sensor_msgs::PointCloud2 foreground_cloud;
+    dispatchPointCloudType([&](auto point) {
+        typedef decltype(point) PointT;
+        pcl::toROSMsg(*PhoXiInterface::getMaskedPointCloudFromFrame<PointT>(frame, foregroundMask), foreground_cloud);
+    });
+    foreground_cloud.header = header;
+    phoxi_camera::TraceScope trace("publish pointcloud_foreground", "RosInterface", header.seq);
+    foregroundCloudPub.publish(foreground_cloud);
+    frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloudForeground, foreground_cloud.data.size());
+}
+
+void RosInterface::publishPointCloudTargetFrames(PFramePostProcessed frame, const std_msgs::Header& header) {
+    std::vector<PointCloudTargetFrame*> targets;
+    std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f>> transforms;
+    for (size_t i = 0; i < pointCloudTargetFrames.size(); ++i) {
+        PointCloudTargetFrame& target = pointCloudTargetFrames[i];
+        Eigen::Affine3d transform = target.staticTransform;
+        if (!target.useStaticTransform) {
+            try {
+                geometry_msgs::TransformStamped transformStamped = tfBuffer.lookupTransform(target.frameId, header.frame_id, header.stamp, ros::Duration(pointCloudTargetFramesTfTimeout));
+                tf::transformMsgToEigen(transformStamped.transform, transform);
+            } catch (tf2::TransformException &e) {
+                ROS_WARN("Point cloud not published in frame %s. %s", target.frameId.c_str(), e.what());
+                continue;
+            }
+        }
+        targets.push_back(&target);
+        transforms.push_back(transform.cast<float>());
+    }
+    if (targets.empty()) {
+        return;
+    }
+    //each target is converted from the frame with its transformation fused into the conversion kernel
+    dispatchPointCloudType([&](auto point) {
+        typedef decltype(point) PointT;
+        for (size_t i = 0; i < targets.size(); ++i) {
+            sensor_msgs::PointCloud2 output_cloud;
+            if (isPointCloudDecimated()) {
+                pcl::toROSMsg(*PhoXiInterface::getPreviewPointCloudFromFrame<PointT>(frame, 2, PreviewPooling::MinDepth, transforms[i]), output_cloud);
+            } else {
+                pcl::toROSMsg(*PhoXiInterface::getPointCloudFromFrame<PointT>(frame, transforms[i]), output_cloud);
+            }
+            output_cloud.header = header;
+            output_cloud.header.frame_id = targets[i]->frameId;
+            phoxi_camera::TraceScope trace("publish pointcloud target frame", "RosInterface", header.seq);
+            targets[i]->publisher.publish(output_cloud);
+            frameStatistics.outputPublished(phoxi_camera::OutputChannel::PointCloudTargetFrames, output_cloud.data.size());
+        }
+    });
+}
+
+sensor_msgs::CameraInfo RosInterface::getCameraInfo(const pho::api::PhoXiSize& size, const std_msgs::Header& header) {
+    if (cameraInfoFromScanner && (scannerCameraInfo.width != (uint32_t) size.Width || scannerCameraInfo.height != (uint32_t) size.Height)) {
+        updateScannerCameraInfo(size);
+        updateTextureRectification();
+    }
+    sensor_msgs::CameraInfo cameraInfo = cameraInfoFromScanner && scannerCameraInfo.K[0] > 0.0 ? scannerCameraInfo : mono8CameraInfoManager.getCameraInfo();
+    cameraInfo.header = header;
+    return cameraInfo;
+}
+
+void RosInterface::updateScannerCameraInfo(const pho::api::PhoXiSize& size) {
+    //failures are cached for the resolution as well, camera_info_url is used until the resolution changes
+    scannerCameraInfo = sensor_msgs::CameraInfo();
+    scannerCameraInfo.width = size.Width;
+    scannerCameraInfo.height = size.Height;
+    ScannerIntrinsics intrinsics;
+    try {
+        intrinsics = PhoXiInterface::getScannerIntrinsics();
+    } catch (PhoXiInterfaceException &e) {
+        ROS_WARN("Camera info not read from the scanner. %s", e.what());
+        return;
+    }
+    if (intrinsics.width <= 0 || intrinsics.height <= 0 || intrinsics.cameraMatrix[0] <= 0.0) {
+        ROS_WARN("Scanner has no calibration for resolution %d x %d.", size.Width, size.Height);
+        return;
+    }
+    //frames captured before a change of capturing mode have another resolution than the calibration
+    const double scaleX = (double) size.Width / intrinsics.width;
+    const double scaleY = (double) size.Height / intrinsics.height;
+    scannerCameraInfo.K[0] = intrinsics.cameraMatrix[0] * scaleX;
+    scannerCameraInfo.K[1] = intrinsics.cameraMatrix[1] * scaleX;
+    scannerCameraInfo.K[2] = (intrinsics.cameraMatrix[2] + 0.5) * scaleX - 0.5;
+    scannerCameraInfo.K[4] = intrinsics.cameraMatrix[4] * scaleY;
+    scannerCameraInfo.K[5] = (intrinsics.cameraMatrix[5] + 0.5) * scaleY - 0.5;
+    scannerCameraInfo.K[8] = 1.0;
+    const std::vector<double>& distortion = intrinsics.distortionCoefficients;
+    scannerCameraInfo.distortion_model = distortion.size() > 5 ? "rational_polynomial" : "plumb_bob";
+    scannerCameraInfo.D.assign(distortion.size() > 5 ? 8 : 5, 0.0);
+    std::copy(distortion.begin(), distortion.begin() + std::min(distortion.size(), scannerCameraInfo.D.size()), scannerCameraInfo.D.begin());
+    scannerCameraInfo.R[0] = scannerCameraInfo.R[4] = scannerCameraInfo.R[8] = 1.0;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            scannerCameraInfo.P[r * 4 + c] = scannerCameraInfo.K[r * 3 + c];
+        }
+    }
+    ROS_INFO("Camera info of resolution %d x %d read from the scanner", size.Width, size.Height);
+}
+
+void RosInterface::updateTextureRectification() {
+    const sensor_msgs::CameraInfo cameraInfo = cameraInfoFromScanner && scannerCameraInfo.K[0] > 0.0 ? scannerCameraInfo : mono8CameraInfoManager.getCameraInfo();
+    ScannerIntrinsics intrinsics;
+    intrinsics.width = cameraInfo.width;
+    intrinsics.height = cameraInfo.height;
+    std::copy(cameraInfo.K.begin(), cameraInfo.K.end(), intrinsics.cameraMatrix);
+    intrinsics.distortionCoefficients = cameraInfo.D;
+    PhoXiInterface::setTextureRectification(dynamicReconfigureConfig.publish_rectified_image, intrinsics);
+}
+
+void RosInterface::publishDominantPlane(PFramePostProcessed frame, const std_msgs::Header& header) {
+    bool found;
+    {
+        phoxi_camera::TraceScope trace("dominant plane detection", "RosInterface", header.seq);
+        PhoXiInterface::getSubsampledPointsFromFrame(frame, dynamicReconfigureConfig.plane_subsampling, planeSamples);
+        found = planeDetector.detect(planeSamples, threadPool);
+    }
+    const Eigen::Vector4f plane = planeDetector.getPlane();
+    const float distance = (float) dynamicReconfigureConfig.plane_distance_threshold;
+
+    phoxi_camera::DominantPlane msg;
+    msg.header = header;
+    msg.found = found;
+    for (int i = 0; i < 4; ++i) {
+        msg.coefficients[i] = plane[i];
+    }
+    msg.inlier_ratio = planeDetector.getInlierRatio();
+    msg.prior_reused = planeDetector.isPriorReused();
+    planePub.publish(msg);
+    frameStatistics.outputPublished(phoxi_camera::OutputChannel::Plane, sizeof(msg.coefficients));
+
+    if (found && dynamicReconfigureConfig.plane_detection == 3) {
+        PhoXiInterface::getPlaneMaskFromFrame(frame, plane, distance, planeMask);
+        sensor_msgs::Image plane_mask;
+        plane_mask.header = header;
+        plane_mask.encoding = sensor_msgs::image_encodings::MONO8;
+        sensor_msgs::fillImage(plane_mask,
+                               sensor_msgs::image_encodings::MONO8,
+                               frame->PFrame->PointCloud.Size.Height, // height
+                               frame->PFrame->PointCloud.Size.Width, // width
+                               frame->PFrame->PointCloud.Size.Width, // stepSize
+                               planeMask.data());
+        phoxi_camera::TraceScope trace("publish plane_mask", "RosInterface", header.seq);
+        planeMaskPub.publish(plane_mask);
+        frameStatistics.outputPublished(phoxi_camera::OutputChannel::PlaneMask, plane_mask.data.size());
+    }
+}
+
+void RosInterface::integrateTsdf(PFramePostProcessed frame, const std_msgs::Header& header) {
+    //the translation of the pose is the origin of the rays, which is the scanner only for points in camera space
+    if (dynamicReconfigureConfig.coordination_space != pho::api::PhoXiCoordinateSpace::CameraSpace) {
+        ROS_WARN_THROTTLE(10, "Frame not integrated into the fusion volume, tsdf_fusion needs the CameraSpace coordination_space");
+        return;
+    }
+    Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+    if (!tsdfFrameId.empty()) {
+        try {
+            geometry_msgs::TransformStamped transformStamped = tfBuffer.lookupTransform(tsdfFrameId, header.frame_id, header.stamp, ros::Duration(pointCloudTargetFramesTfTimeout));
+            tf::transformMsgToEigen(transformStamped.transform, pose);
+        } catch (tf2::TransformException &e) {
+            ROS_WARN("Frame not integrated into the fusion volume in frame %s. %s", tsdfFrameId.c_str(), e.what());
+            return;
+        }
+    }
+    phoxi_camera::TraceScope trace("tsdf integration", "RosInterface", header.seq);
+    PhoXiInterface::getSubsampledPointsFromFrame(frame, dynamicReconfigureConfig.tsdf_subsampling, tsdfPoints, &tsdfIntensities);
+    tsdfVolume.integrate(tsdfPoints, tsdfIntensities, pose.cast<float>(), threadPool);
+}
+
+void RosInterface::publishHeightMap(PFramePostProcessed frame, const std_msgs::Header& header) {
+    Eigen::Affine3d transform = heightMapFrame.staticTransform;
+    if (!heightMapFrame.useStaticTransform) {
+        try {
+            geometry_msgs::TransformStamped transformStamped = tfBuffer.lookupTransform(heightMapFrame.frameId, header.frame_id, header.stamp, ros::Duration(pointCloudTargetFramesTfTimeout));
+            tf::transformMsgToEigen(transformStamped.transform, transform);
+        } catch (tf2::TransformException &e) {
+            ROS_WARN("Height map not published in frame %s. %s", heightMapFrame.frameId.c_str(), e.what());
+            return;
+        }
+    }
+    heightMap.resolution = (float) dynamicReconfigureConfig.height_map_resolution;
+    heightMap.originX = (float) dynamicReconfigureConfig.height_map_origin_x;
+    heightMap.originY = (float) dynamicReconfigureConfig.height_map_origin_y;
+    heightMap.width = dynamicReconfigureConfig.height_map_width;
+    heightMap.height = dynamicReconfigureConfig.height_map_height;
+    heightMap.minPoints = dynamicReconfigureConfig.height_map_min_points;
+    PhoXiInterface::getHeightMapFromFrame(frame, heightMap, transform.cast<float>());
+    sensor_msgs::Image height_map;
+    height_map.header = header;
+    if (!heightMapFrame.frameId.empty()) {
+        height_map.header.frame_id = heightMapFrame.frameId;
+    }
+    height_map.encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+    sensor_msgs::fillImage(height_map,
+                           sensor_msgs::image_encodings::TYPE_32FC1,
+                           heightMap.height, // height
+                           heightMap.width, // width
+                           heightMap.width * sizeof(float), // stepSize
+                           heightMap.heights.data());
+    phoxi_camera::TraceScope trace("publish height_map", "RosInterface", header.seq);
+    heightMapFrame.publisher.publish(height_map);
+    frameStatistics.outputPublished(phoxi_camera::OutputChannel::HeightMap, height_map.data.size());
 }
 
 bool RosInterface::setCoordianteSpace(phoxi_camera::SetCoordinatesSpace::Request &req, phoxi_camera::SetCoordinatesSpace::Response &res){
+    phoxi_camera::TraceScope trace("service V2/set_coordination_space", "RosInterface");
     try {
         PhoXiInterface::setCoordinateSpace(req.coordinates_space);
         //update dynamic reconfigure
@@ -390,6 +1090,7 @@ bool RosInterface::setCoordianteSpace(phoxi_camera::SetCoordinatesSpace::Request
 }
 
 bool RosInterface::setTransformation(phoxi_camera::SetTransformationMatrix::Request &req, phoxi_camera::SetTransformationMatrix::Response &res){
+    phoxi_camera::TraceScope trace("service V2/set_transformation", "RosInterface");
     try {
         Eigen::Affine3d transform;
         tf::transformMsgToEigen(req.transform,transform);
@@ -411,20 +1112,30 @@ void RosInterface::dynamicReconfigureCallback(phoxi_camera::phoxi_cameraConfig &
         config = this->dynamicReconfigureConfig;
         return;
     }
+    //settings of capture profiles changed individually
+    if (level & ((1 << 1) | (1 << 2) | (1 << 3) | (1 << 6))) {
+        activeCaptureProfile.clear();
+    }
     if (level & (1 << 1)) {
         try {
-            switch (config.resolution){
-                case 0:
-                    PhoXiInterface::setLowResolution();
-                    this->dynamicReconfigureConfig.resolution = config.resolution;
-                    break;
-                case 1:
-                    PhoXiInterface::setHighResolution();
-                    this->dynamicReconfigureConfig.resolution = config.resolution;
-                    break;
-                default:
-                    ROS_WARN("Resolution not supported!");
-                    break;
+            if (isResolutionReduced() && (config.resolution == 0 || config.resolution == 1)) {
+                //adaptive quality holds the low resolution, the configured one is applied when the quality is restored
+                ROS_INFO("Resolution applied when adaptive quality restores the resolution");
+                this->dynamicReconfigureConfig.resolution = config.resolution;
+            } else {
+                switch (config.resolution){
+                    case 0:
+                        PhoXiInterface::setLowResolution();
+                        this->dynamicReconfigureConfig.resolution = config.resolution;
+                        break;
+                    case 1:
+                        PhoXiInterface::setHighResolution();
+                        this->dynamicReconfigureConfig.resolution = config.resolution;
+                        break;
+                    default:
+                        ROS_WARN("Resolution not supported!");
+                        break;
+                }
             }
         }catch(PhoXiInterfaceException &e){
             ROS_WARN("%s",e.what());
@@ -600,10 +1311,248 @@ void RosInterface::dynamicReconfigureCallback(phoxi_camera::phoxi_cameraConfig &
             ROS_WARN("%s",e.what());
         }
     }
+
+    if (level & (1 << 19)) {
+        try{
+            this->isOk();
+            PhoXiInterface::setPointCloudMinConfidence((float) config.point_cloud_min_confidence);
+            PhoXiInterface::setPointCloudJumpEdgeMaxDepthRatio((float) config.point_cloud_jump_edge_max_depth_ratio);
+            PhoXiInterface::setPointCloudMinValidNeighbours(config.point_cloud_min_valid_neighbours);
+            this->dynamicReconfigureConfig.point_cloud_min_confidence = config.point_cloud_min_confidence;
+            this->dynamicReconfigureConfig.point_cloud_jump_edge_max_depth_ratio = config.point_cloud_jump_edge_max_depth_ratio;
+            this->dynamicReconfigureConfig.point_cloud_min_valid_neighbours = config.point_cloud_min_valid_neighbours;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 20)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.point_cloud_type = config.point_cloud_type;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if ((level & (1 << 21)) && config.preview_point_cloud_downsampling == 3) {
+        ROS_WARN("preview_point_cloud_downsampling supports 1, 2 and 4. Preview is downsampled 2x.");
+        config.preview_point_cloud_downsampling = 2;
+    }
+    if (level & (1 << 21)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.preview_point_cloud_downsampling = config.preview_point_cloud_downsampling;
+            this->dynamicReconfigureConfig.preview_point_cloud_pooling = config.preview_point_cloud_pooling;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 22)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.point_cloud_band_rows = config.point_cloud_band_rows;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 23)) {
+        try{
+            this->isOk();
+            sceneChangeDetector.setParameters(config.scene_change_subsampling, config.scene_change_depth_threshold,
+                                              config.scene_change_min_changed_ratio, config.scene_change_max_unchanged_frames);
+            this->dynamicReconfigureConfig.scene_change_detection = config.scene_change_detection;
+            this->dynamicReconfigureConfig.scene_change_subsampling = config.scene_change_subsampling;
+            this->dynamicReconfigureConfig.scene_change_depth_threshold = config.scene_change_depth_threshold;
+            this->dynamicReconfigureConfig.scene_change_min_changed_ratio = config.scene_change_min_changed_ratio;
+            this->dynamicReconfigureConfig.scene_change_max_unchanged_frames = config.scene_change_max_unchanged_frames;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 24)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.publish_foreground_point_cloud = config.publish_foreground_point_cloud;
+            this->dynamicReconfigureConfig.background_depth_threshold = config.background_depth_threshold;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 25)) {
+        try{
+            this->isOk();
+            int previousLevel = adaptiveQualityController.getLevel();
+            if (config.adaptive_quality) {
+                adaptiveQualityController.setParameters(config.adaptive_quality_deadline, config.adaptive_quality_headroom,
+                                                        config.adaptive_quality_max_level, config.adaptive_quality_hold_frames);
+            } else {
+                adaptiveQualityController.reset();
+            }
+            //the configured quality is restored when the controller is disabled or its max level decreased
+            applyAdaptiveQualityLevel(adaptiveQualityController.getLevel(), previousLevel);
+            this->dynamicReconfigureConfig.adaptive_quality = config.adaptive_quality;
+            this->dynamicReconfigureConfig.adaptive_quality_deadline = config.adaptive_quality_deadline;
+            this->dynamicReconfigureConfig.adaptive_quality_headroom = config.adaptive_quality_headroom;
+            this->dynamicReconfigureConfig.adaptive_quality_max_level = config.adaptive_quality_max_level;
+            this->dynamicReconfigureConfig.adaptive_quality_hold_frames = config.adaptive_quality_hold_frames;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 26)) {
+        try{
+            this->isOk();
+            PhoXiInterface::setFrameCacheLimits(config.frame_cache_size, (size_t) config.frame_cache_max_memory * 1024 * 1024);
+            this->dynamicReconfigureConfig.frame_cache_size = config.frame_cache_size;
+            this->dynamicReconfigureConfig.frame_cache_max_memory = config.frame_cache_max_memory;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 27)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.publish_mesh = config.publish_mesh;
+            this->dynamicReconfigureConfig.mesh_max_edge_length = config.mesh_max_edge_length;
+            this->dynamicReconfigureConfig.mesh_decimation = config.mesh_decimation;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 28)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.publish_height_map = config.publish_height_map;
+            this->dynamicReconfigureConfig.height_map_resolution = config.height_map_resolution;
+            this->dynamicReconfigureConfig.height_map_width = config.height_map_width;
+            this->dynamicReconfigureConfig.height_map_height = config.height_map_height;
+            this->dynamicReconfigureConfig.height_map_origin_x = config.height_map_origin_x;
+            this->dynamicReconfigureConfig.height_map_origin_y = config.height_map_origin_y;
+            this->dynamicReconfigureConfig.height_map_min_points = config.height_map_min_points;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 29)) {
+        try{
+            this->isOk();
+            planeDetector.setParameters(config.plane_distance_threshold, config.plane_ransac_iterations,
+                                        config.plane_min_inlier_ratio, config.plane_prior_keep_ratio);
+            this->dynamicReconfigureConfig.plane_detection = config.plane_detection;
+            this->dynamicReconfigureConfig.plane_distance_threshold = config.plane_distance_threshold;
+            this->dynamicReconfigureConfig.plane_subsampling = config.plane_subsampling;
+            this->dynamicReconfigureConfig.plane_ransac_iterations = config.plane_ransac_iterations;
+            this->dynamicReconfigureConfig.plane_min_inlier_ratio = config.plane_min_inlier_ratio;
+            this->dynamicReconfigureConfig.plane_prior_keep_ratio = config.plane_prior_keep_ratio;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    //depth only mode overrides the outputs enabled individually, level 30 is shared with publish_rectified_image
+    const bool outputsChanged = level & ((1 << 7) | (1 << 8) | (1 << 9) | (1 << 10) | (1 << 11));
+    const bool depthOnlyChanged = (level & (1 << 30)) && config.depth_only != this->dynamicReconfigureConfig.depth_only;
+    if (depthOnlyChanged || (outputsChanged && config.depth_only)) {
+        try{
+            this->isOk();
+            if (config.depth_only) {
+                pho::api::PhoXiOutputSettings outputs = scanner->OutputSettings;
+                //outputs enabled before depth only are restored when it is disabled
+                if (depthOnlyChanged) {
+                    depthOnlyPreviousOutputs = outputs;
+                }
+                outputs.SendPointCloud = false;
+                outputs.SendNormalMap = false;
+                outputs.SendConfidenceMap = false;
+                outputs.SendTexture = false;
+                outputs.SendDepthMap = true;
+                scanner->OutputSettings = outputs;
+                config.send_point_cloud = this->dynamicReconfigureConfig.send_point_cloud = false;
+                config.send_normal_map = this->dynamicReconfigureConfig.send_normal_map = false;
+                config.send_confidence_map = this->dynamicReconfigureConfig.send_confidence_map = false;
+                config.send_texture = this->dynamicReconfigureConfig.send_texture = false;
+                config.send_deapth_map = this->dynamicReconfigureConfig.send_deapth_map = true;
+            } else {
+                const pho::api::PhoXiOutputSettings& outputs = depthOnlyPreviousOutputs;
+                scanner->OutputSettings = outputs;
+                config.send_point_cloud = this->dynamicReconfigureConfig.send_point_cloud = outputs.SendPointCloud;
+                config.send_normal_map = this->dynamicReconfigureConfig.send_normal_map = outputs.SendNormalMap;
+                config.send_confidence_map = this->dynamicReconfigureConfig.send_confidence_map = outputs.SendConfidenceMap;
+                config.send_texture = this->dynamicReconfigureConfig.send_texture = outputs.SendTexture;
+                config.send_deapth_map = this->dynamicReconfigureConfig.send_deapth_map = outputs.SendDepthMap;
+            }
+            this->dynamicReconfigureConfig.depth_only = config.depth_only;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if ((level & (1 << 30)) && config.publish_rectified_image && config.depth_only) {
+        ROS_WARN("publish_rectified_image needs the texture, which is disabled by depth_only. Rectified image is not published.");
+        config.publish_rectified_image = false;
+    }
+    if ((level & (1 << 30)) && config.publish_rectified_image != this->dynamicReconfigureConfig.publish_rectified_image) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.publish_rectified_image = config.publish_rectified_image;
+            //the maps of the first frames need the calibration before the first camera_info is published
+            if (config.publish_rectified_image && cameraInfoFromScanner && scannerCameraInfo.K[0] <= 0.0) {
+                pho::api::PhoXiCapturingMode mode = scanner->CapturingMode;
+                updateScannerCameraInfo(mode.Resolution);
+            }
+            updateTextureRectification();
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1u << 31)) {
+        try{
+            this->isOk();
+            tsdfVolume.setParameters(config.tsdf_voxel_size, config.tsdf_truncation_distance, config.tsdf_max_weight);
+            this->dynamicReconfigureConfig.tsdf_fusion = config.tsdf_fusion;
+            this->dynamicReconfigureConfig.tsdf_voxel_size = config.tsdf_voxel_size;
+            this->dynamicReconfigureConfig.tsdf_truncation_distance = config.tsdf_truncation_distance;
+            this->dynamicReconfigureConfig.tsdf_max_weight = config.tsdf_max_weight;
+            this->dynamicReconfigureConfig.tsdf_subsampling = config.tsdf_subsampling;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
+
+    if (level & (1 << 0)) {
+        try{
+            this->isOk();
+            this->dynamicReconfigureConfig.voxel_grid_leaf_size = config.voxel_grid_leaf_size;
+            this->dynamicReconfigureConfig.publish_full_point_cloud = config.publish_full_point_cloud;
+        }catch (PhoXiInterfaceException &e){
+            ROS_WARN("%s",e.what());
+        }
+    }
 }
 
 PFramePostProcessed RosInterface::getPFrame(int id){
-    PFramePostProcessed frame = PhoXiInterface::getPFrame(id);
+    PFramePostProcessed frame;
+    try {
+        frame = PhoXiInterface::getPFrame(id);
+    }catch (PhoXiInterfaceException &e){
+        frameStatistics.frameDropped();
+        throw;
+    }
+    if (frame && frame->PFrame && frame->PFrame->Successful) {
+        frameStatistics.frameReceived(*frame->PFrame);
+    } else {
+        frameStatistics.frameDropped();
+    }
     //update dynamic reconfigure
     dynamicReconfigureConfig.trigger_mode = pho::api::PhoXiTriggerMode::Software;
     dynamicReconfigureServer.updateConfig(dynamicReconfigureConfig);
@@ -620,6 +1569,7 @@ int RosInterface::triggerImage(){
 
 void RosInterface::connectCamera(std::string HWIdentification, pho::api::PhoXiTriggerMode mode, bool startAcquisition){
     PhoXiInterface::connectCamera(HWIdentification,mode,startAcquisition);
+    scannerCameraInfo = sensor_msgs::CameraInfo();
     bool initFromConfig = false;
     nh.getParam("init_from_config",initFromConfig);
     if(initFromConfig){
@@ -643,6 +1593,23 @@ void RosInterface::diagnosticCallback(diagnostic_updater::DiagnosticStatusWrappe
         }
         status.add("HardwareIdentification",std::string(scanner->HardwareIdentification));
         status.add("Trigger mode",getTriggerMode(scanner->TriggerMode));
+        if (!activeCaptureProfile.empty()) {
+            status.add("Capture profile", activeCaptureProfile);
+            status.add("Capture profile switch latency [ms]", captureProfileSwitchLatency * 1000.0);
+        }
+        status.add("Last frame latency [s]", lastFrameLatency);
+        status.add("Cached frames", frameCache.size());
+        status.add("Cached frames memory [MB]", frameCache.memory() / (1024.0 * 1024.0));
+        if (dynamicReconfigureConfig.adaptive_quality) {
+            static const char* qualityLevels[] = {"Configured quality", "Without normal and confidence maps", "Low resolution", "Low resolution, decimated point cloud"};
+            status.add("Adaptive quality level", qualityLevels[std::min(adaptiveQualityController.getLevel(), 3)]);
+            status.add("Adaptive quality deadline [s]", adaptiveQualityController.getDeadline());
+            status.add("Adaptive quality filtered latency [s]", adaptiveQualityController.getFilteredLatency());
+            status.add("Adaptive quality last decision", adaptiveQualityController.getLastDecision());
+            if (adaptiveQualityController.getFilteredLatency() > adaptiveQualityController.getDeadline()) {
+                status.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Deadline exceeded");
+            }
+        }
 
     }
     else{
@@ -650,6 +1617,82 @@ void RosInterface::diagnosticCallback(diagnostic_updater::DiagnosticStatusWrappe
     }
 }
 
+void RosInterface::frameStatisticsDiagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status){
+    phoxi_camera::FrameStatistics::Snapshot current = frameStatistics.snapshot();
+    const double elapsed = std::max(1e-6, std::chrono::duration<double>(current.time - previousFrameStatistics.time).count());
+    const uint64_t received = current.framesReceived - previousFrameStatistics.framesReceived;
+    const uint64_t published = current.framesPublished - previousFrameStatistics.framesPublished;
+    const uint64_t dropped = current.framesDropped - previousFrameStatistics.framesDropped;
+    const uint64_t gaps = current.frameIndexGaps - previousFrameStatistics.frameIndexGaps;
+    const double dropRatio = received + dropped > 0 ? (double) dropped / (received + dropped) : 0.0;
+    const double publishedRate = published / elapsed;
+
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, "Frames published");
+    status.add("Frames received", current.framesReceived);
+    status.add("Frames published", current.framesPublished);
+    status.add("Frames dropped", current.framesDropped);
+    status.add("Frame index gaps", current.frameIndexGaps);
+    status.add("Frame rate received [Hz]", received / elapsed);
+    status.add("Frame rate published [Hz]", publishedRate);
+    status.add("Frame index gaps in period", gaps);
+    status.add("Drop ratio in period", dropRatio);
+    status.add("Valid points ratio", current.validPointsRatio);
+    status.add("Latency samples", current.latencySamples);
+    status.add("Latency p50 [s]", current.latencyP50);
+    status.add("Latency p90 [s]", current.latencyP90);
+    status.add("Latency p99 [s]", current.latencyP99);
+    status.add("Latency max [s]", current.latencyMax);
+    for (int i = 0; i < (int) phoxi_camera::OutputChannel::Count; ++i) {
+        const uint64_t messages = current.messages[i] - previousFrameStatistics.messages[i];
+        if (current.messages[i] == 0) {
+            continue;
+        }
+        const std::string name = phoxi_camera::outputChannelName((phoxi_camera::OutputChannel) i);
+        status.add(name + " rate [Hz]", messages / elapsed);
+        status.add(name + " throughput [MB/s]", (current.bytes[i] - previousFrameStatistics.bytes[i]) / elapsed / (1024.0 * 1024.0));
+    }
+
+    //thresholds equal to 0 are disabled
+    if (diagnosticsMinFrameRate > 0.0 && publishedRate < diagnosticsMinFrameRate) {
+        status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::WARN, "Frame rate %.2f Hz below %.2f Hz", publishedRate, diagnosticsMinFrameRate);
+    }
+    if (diagnosticsMaxFrameAge > 0.0) {
+        const double frameAge = current.lastPublishTime > 0 ? (phoxi_camera::FrameStatistics::now() - current.lastPublishTime) * 1e-6 : std::numeric_limits<double>::infinity();
+        if (frameAge > diagnosticsMaxFrameAge) {
+            status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::WARN, "No frame published for more than %.1f s", diagnosticsMaxFrameAge);
+        }
+    }
+    if (diagnosticsLatencyError > 0.0 && current.latencyP99 > diagnosticsLatencyError) {
+        status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::ERROR, "Latency p99 %.3f s above %.3f s", current.latencyP99, diagnosticsLatencyError);
+    } else if (diagnosticsLatencyWarn > 0.0 && current.latencyP99 > diagnosticsLatencyWarn) {
+        status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::WARN, "Latency p99 %.3f s above %.3f s", current.latencyP99, diagnosticsLatencyWarn);
+    }
+    if (diagnosticsDropRatioError > 0.0 && dropRatio > diagnosticsDropRatioError) {
+        status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::ERROR, "%.0f %% of frames dropped", dropRatio * 100.0);
+    } else if (diagnosticsDropRatioWarn > 0.0 && dropRatio > diagnosticsDropRatioWarn) {
+        status.mergeSummaryf(diagnostic_msgs::DiagnosticStatus::WARN, "%.0f %% of frames dropped", dropRatio * 100.0);
+    }
+    previousFrameStatistics = current;
+}
+
+void RosInterface::schedulingDiagnosticCallback(diagnostic_updater::DiagnosticStatusWrapper& status){
+    status.summary(diagnostic_msgs::DiagnosticStatus::OK, "Scheduling applied");
+    for (std::map<std::string, std::string>::const_iterator it = threadSchedulingStates.begin(); it != threadSchedulingStates.end(); ++it) {
+        status.add("Thread " + it->first, it->second);
+    }
+    status.add("Memory", memoryLockState);
+    if (schedulingJitterProbe.isRunning()) {
+        phoxi_camera::SchedulingJitterProbe::Snapshot jitter = schedulingJitterProbe.snapshot();
+        status.add("Wake-up jitter samples", jitter.samples);
+        status.add("Wake-up jitter p50 [s]", jitter.jitterP50);
+        status.add("Wake-up jitter p99 [s]", jitter.jitterP99);
+        status.add("Wake-up jitter max [s]", jitter.jitterMax);
+    }
+    if (threadSchedulingFailed) {
+        status.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Scheduling of some threads could not be applied");
+    }
+}
+
 void RosInterface::diagnosticTimerCallback(const ros::TimerEvent&){
     diagnosticUpdater.force_update();
 }
@@ -669,6 +1712,199 @@ std::string RosInterface::getTriggerMode(pho::api::PhoXiTriggerMode mode){
     }
 }
 
+void RosInterface::initPointCloudTargetFrames(bool latchTopics){
+    nh.param<double>("point_cloud_target_frames_tf_timeout", pointCloudTargetFramesTfTimeout, 0.1);
+    XmlRpc::XmlRpcValue targetFrames;
+    if (!nh.getParam("point_cloud_target_frames", targetFrames)) {
+        return;
+    }
+    if (targetFrames.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+        ROS_WARN("Parameter point_cloud_target_frames must be a list.");
+        return;
+    }
+    for (int i = 0; i < targetFrames.size(); ++i) {
+        XmlRpc::XmlRpcValue& entry = targetFrames[i];
+        if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("frame_id")) {
+            ROS_WARN("Entry %d of point_cloud_target_frames has no frame_id.", i);
+            continue;
+        }
+        PointCloudTargetFrame target;
+        target.frameId = static_cast<std::string>(entry["frame_id"]);
+        target.useStaticTransform = false;
+        target.staticTransform = Eigen::Affine3d::Identity();
+        if (entry.hasMember("transform")) {
+            XmlRpc::XmlRpcValue& matrix = entry["transform"];
+            if (matrix.getType() != XmlRpc::XmlRpcValue::TypeArray || matrix.size() != 16) {
+                ROS_WARN("Transform of point cloud target frame %s must be a row major 4x4 matrix.", target.frameId.c_str());
+                continue;
+            }
+            for (int j = 0; j < 16; ++j) {
+                double value = matrix[j].getType() == XmlRpc::XmlRpcValue::TypeInt ? (double) static_cast<int>(matrix[j]) : static_cast<double>(matrix[j]);
+                target.staticTransform.matrix()(j / 4, j % 4) = value;
+            }
+            target.useStaticTransform = true;
+        }
+        std::string topic;
+        if (entry.hasMember("topic")) {
+            topic = static_cast<std::string>(entry["topic"]);
+        } else {
+            topic = "pointcloud_" + target.frameId;
+            std::replace(topic.begin(), topic.end(), '/', '_');
+        }
+        target.publisher = nh.advertise < sensor_msgs::PointCloud2 > (topic, 1, latchTopics);
+        pointCloudTargetFrames.push_back(target);
+        ROS_INFO("Point cloud will also be published in frame %s on topic %s", target.frameId.c_str(), topic.c_str());
+    }
+}
+
+void RosInterface::initHeightMap(bool latchTopics){
+    //without frame id the height map is in the frame of the point cloud, with z along the optical axis
+    nh.param<std::string>("height_map_frame_id", heightMapFrame.frameId, "");
+    heightMapFrame.useStaticTransform = true;
+    heightMapFrame.staticTransform = Eigen::Affine3d::Identity();
+    std::vector<double> matrix;
+    if (nh.getParam("height_map_transform", matrix)) {
+        if (matrix.size() == 16) {
+            for (int j = 0; j < 16; ++j) {
+                heightMapFrame.staticTransform.matrix()(j / 4, j % 4) = matrix[j];
+            }
+        } else {
+            ROS_WARN("Parameter height_map_transform must be a row major 4x4 matrix.");
+        }
+    } else if (!heightMapFrame.frameId.empty()) {
+        heightMapFrame.useStaticTransform = false;
+    }
+    heightMapFrame.publisher = nh.advertise < sensor_msgs::Image > ("height_map", 1, latchTopics);
+}
+
+void RosInterface::initThreadScheduling(){
+    threadSchedulingFailed = false;
+    if (nh.getParam("thread_scheduling", threadSchedulingParameters) && threadSchedulingParameters.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+        ROS_WARN("Parameter thread_scheduling must be a map of thread names to scheduling.");
+        threadSchedulingParameters = XmlRpc::XmlRpcValue();
+    }
+
+    bool memory_huge_pages, memory_lock;
+    nh.param<bool>("memory_huge_pages", memory_huge_pages, false);
+    nh.param<bool>("memory_lock", memory_lock, false);
+    std::string hugePagesState;
+    if (memory_huge_pages) {
+        //the buffers of the frames are allocated by the PhoXi API, they use huge pages only when transparent huge pages are enabled system wide
+        const bool advised = sharedMemoryFrameWriter && sharedMemoryFrameWriter->adviseHugePages();
+        ROS_INFO("Huge pages %s for the shared memory frames", advised ? "advised" : "not available");
+        hugePagesState = advised ? "shared memory in huge pages" : "huge pages not available";
+    }
+    bool memoryLocked = false;
+    if (memory_lock) {
+        try {
+            phoxi_camera::lockProcessMemory();
+            memoryLocked = true;
+        } catch (PhoXiInterfaceException &e) {
+            ROS_WARN("%s", e.what());
+            threadSchedulingFailed = true;
+        }
+    }
+    memoryLockState = memoryLocked ? "locked" : "not locked";
+    if (!hugePagesState.empty()) {
+        memoryLockState += ", " + hugePagesState;
+    }
+
+    //the ROS callback thread acquires, post-processes, converts and publishes the frames
+    applyThreadScheduling("callback");
+
+    //worker threads of the parallel conversions, started after the callback thread scheduling which they would inherit
+    int worker_threads;
+    nh.param<int>("worker_threads", worker_threads, 0);
+    const phoxi_camera::ThreadSchedulingConfig workersScheduling = getThreadSchedulingConfig("workers");
+    std::mutex workersStateMutex;
+    std::string workersState;
+    bool workersFailed = false;
+    PhoXiInterface::setWorkerThreads(worker_threads, [&]() {
+        std::string state;
+        bool failed = false;
+        try {
+            state = phoxi_camera::applyThreadScheduling(workersScheduling);
+        } catch (PhoXiInterfaceException &e) {
+            state = e.what();
+            failed = true;
+        }
+        std::lock_guard<std::mutex> lock(workersStateMutex);
+        workersState = state;
+        workersFailed |= failed;
+    });
+    //setWorkerThreads returns when all workers were initialized
+    threadSchedulingFailed |= workersFailed;
+    threadSchedulingStates["workers"] = std::to_string(threadPool.getThreadCount() - 1) + " threads, " + workersState;
+    ROS_INFO("Scheduling of thread workers: %s", threadSchedulingStates["workers"].c_str());
+
+    double scheduling_jitter_probe_period;
+    nh.param<double>("scheduling_jitter_probe_period", scheduling_jitter_probe_period, 0.0);
+    if (scheduling_jitter_probe_period > 0.0) {
+        schedulingJitterProbe.start(scheduling_jitter_probe_period, getThreadSchedulingConfig("callback"));
+    }
+}
+
+phoxi_camera::ThreadSchedulingConfig RosInterface::getThreadSchedulingConfig(const std::string& thread){
+    phoxi_camera::ThreadSchedulingConfig config;
+    if (threadSchedulingParameters.getType() != XmlRpc::XmlRpcValue::TypeStruct || !threadSchedulingParameters.hasMember(thread)) {
+        return config;
+    }
+    XmlRpc::XmlRpcValue& entry = threadSchedulingParameters[thread];
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+        ROS_WARN("Scheduling of thread %s must be a map.", thread.c_str());
+        return config;
+    }
+    if (entry.hasMember("policy")) config.policy = static_cast<std::string>(entry["policy"]);
+    if (entry.hasMember("priority")) config.priority = static_cast<int>(entry["priority"]);
+    if (entry.hasMember("numa_node")) config.numaNode = static_cast<int>(entry["numa_node"]);
+    if (entry.hasMember("cpus") && entry["cpus"].getType() == XmlRpc::XmlRpcValue::TypeArray) {
+        for (int i = 0; i < entry["cpus"].size(); ++i) {
+            config.cpus.push_back(static_cast<int>(entry["cpus"][i]));
+        }
+    }
+    return config;
+}
+
+void RosInterface::applyThreadScheduling(const std::string& thread){
+    try {
+        threadSchedulingStates[thread] = phoxi_camera::applyThreadScheduling(getThreadSchedulingConfig(thread));
+        ROS_INFO("Scheduling of thread %s: %s", thread.c_str(), threadSchedulingStates[thread].c_str());
+    } catch (PhoXiInterfaceException &e) {
+        ROS_WARN("Scheduling of thread %s: %s", thread.c_str(), e.what());
+        threadSchedulingStates[thread] = e.what();
+        threadSchedulingFailed = true;
+    }
+}
+
+void RosInterface::initCaptureProfiles(){
+    captureProfileSwitchLatency = 0.0;
+    XmlRpc::XmlRpcValue profiles;
+    if (!nh.getParam("capture_profiles", profiles)) {
+        return;
+    }
+    if (profiles.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+        ROS_WARN("Parameter capture_profiles must be a map of profile names to settings.");
+        return;
+    }
+    for (XmlRpc::XmlRpcValue::iterator it = profiles.begin(); it != profiles.end(); ++it) {
+        XmlRpc::XmlRpcValue& entry = it->second;
+        if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct) {
+            ROS_WARN("Capture profile %s must be a map of settings.", it->first.c_str());
+            continue;
+        }
+        CaptureProfile profile;
+        if (entry.hasMember("resolution")) profile.resolution = static_cast<int>(entry["resolution"]);
+        if (entry.hasMember("scan_multiplier")) profile.scanMultiplier = static_cast<int>(entry["scan_multiplier"]);
+        if (entry.hasMember("shutter_multiplier")) profile.shutterMultiplier = static_cast<int>(entry["shutter_multiplier"]);
+        if (entry.hasMember("confidence")) {
+            XmlRpc::XmlRpcValue& confidence = entry["confidence"];
+            profile.confidence = confidence.getType() == XmlRpc::XmlRpcValue::TypeInt ? (double) static_cast<int>(confidence) : static_cast<double>(confidence);
+        }
+        captureProfiles[it->first] = profile;
+        ROS_INFO("Capture profile %s loaded", it->first.c_str());
+    }
+}
+
 void RosInterface::initFromPhoXi(){
     dynamicReconfigureServer.getConfigDefault(dynamicReconfigureConfig);
     if(!scanner->isConnected()){
@@ -0,0 +1,85 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/SceneChangeDetector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace phoxi_camera {
+
+    SceneChangeDetector::SceneChangeDetector() : subsampling(4), depthThreshold(5.0f), minChangedRatio(0.005f), maxUnchangedFrames(0),
+                                                 referenceWidth(0), referenceHeight(0), changedRatio(1.0f), unchangedFrames(0) {
+    }
+
+    void SceneChangeDetector::setParameters(int subsampling, float depthThreshold, float minChangedRatio, int maxUnchangedFrames) {
+        this->subsampling = std::max(1, subsampling);
+        this->depthThreshold = std::max(0.0f, depthThreshold);
+        this->minChangedRatio = std::max(0.0f, minChangedRatio);
+        this->maxUnchangedFrames = std::max(0, maxUnchangedFrames);
+        reset();
+    }
+
+    void SceneChangeDetector::reset() {
+        reference.clear();
+        referenceWidth = 0;
+        referenceHeight = 0;
+        unchangedFrames = 0;
+    }
+
+    void SceneChangeDetector::gatherSamples(const pho::api::Frame& frame, std::vector<float>& samples) {
+        samples.clear();
+        if (!frame.DepthMap.Empty()) {
+            const int width = frame.DepthMap.Size.Width;
+            const int height = frame.DepthMap.Size.Height;
+            for (int r = 0; r < height; r += subsampling) {
+                const float* row = frame.DepthMap[r];
+                for (int c = 0; c < width; c += subsampling) {
+                    samples.push_back(row[c]);
+                }
+            }
+        } else {
+            const int width = frame.PointCloud.Size.Width;
+            const int height = frame.PointCloud.Size.Height;
+            for (int r = 0; r < height; r += subsampling) {
+                const pho::api::Point3_32f* row = frame.PointCloud[r];
+                for (int c = 0; c < width; c += subsampling) {
+                    samples.push_back(row[c].z);
+                }
+            }
+        }
+    }
+
+    bool SceneChangeDetector::update(const pho::api::Frame& frame) {
+        const pho::api::PhoXiSize& size = frame.DepthMap.Empty() ? frame.PointCloud.Size : frame.DepthMap.Size;
+        gatherSamples(frame, current);
+
+        bool changed;
+        if (size.Width != referenceWidth || size.Height != referenceHeight || current.size() != reference.size() || current.empty()) {
+            changedRatio = 1.0f;
+            changed = true;
+        } else {
+            const float* currentData = current.data();
+            const float* referenceData = reference.data();
+            const size_t count = current.size();
+            const float threshold = depthThreshold;
+            uint32_t changedSamples = 0;
+            for (size_t i = 0; i < count; ++i) {
+                changedSamples += std::fabs(currentData[i] - referenceData[i]) > threshold;
+            }
+            changedRatio = (float) changedSamples / count;
+            changed = changedRatio > minChangedRatio ||
+                      (maxUnchangedFrames > 0 && unchangedFrames >= (uint32_t) maxUnchangedFrames);
+        }
+
+        if (changed) {
+            reference.swap(current);
+            referenceWidth = size.Width;
+            referenceHeight = size.Height;
+            unchangedFrames = 0;
+        } else {
+            ++unchangedFrames;
+        }
+        return changed;
+    }
+}
@@ -0,0 +1,111 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/SharedMemoryFrameWriter.h"
+#include "phoxi_camera/ThreadScheduling.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace phoxi_camera {
+
+    namespace {
+        template <typename T>
+        void copyChannel(const pho::api::Mat2D<T>& map, uint8_t* slot, SharedMemoryFrameRing::ChannelInfo& info) {
+            info.bytes = map.Empty() ? 0 : (uint64_t) map.Size.Width * map.Size.Height * sizeof(T);
+            if (info.bytes) {
+                std::memcpy(slot + info.offset, map.operator[](0), info.bytes);
+            }
+        }
+    }
+
+    SharedMemoryFrameWriter::SharedMemoryFrameWriter(const std::string& name, uint32_t slotCount, uint32_t maxWidth, uint32_t maxHeight) :
+            name(name), ring(nullptr), ringBytes(SharedMemoryFrameRing::ringSize(std::max<uint32_t>(1, slotCount), maxWidth, maxHeight)) {
+        slotCount = std::max<uint32_t>(1, slotCount);
+        //readers of a previous ring keep their mapping, new readers map the new one
+        shm_unlink(name.c_str());
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) {
+            throw SharedMemoryError("Unable to create shared memory " + name + "!");
+        }
+        if (ftruncate(fd, (off_t) ringBytes) != 0) {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw SharedMemoryError("Unable to allocate shared memory " + name + "!");
+        }
+        void* memory = mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            shm_unlink(name.c_str());
+            throw SharedMemoryError("Unable to map shared memory " + name + "!");
+        }
+        ring = static_cast<uint8_t*>(memory);
+
+        const size_t slotSize = SharedMemoryFrameRing::slotSize(maxWidth, maxHeight);
+        uint8_t* slots = ring + SharedMemoryFrameRing::align(sizeof(SharedMemoryFrameRing::RingHeader));
+        for (uint32_t s = 0; s < slotCount; ++s) {
+            SharedMemoryFrameRing::SlotHeader* slot = new (slots + s * slotSize) SharedMemoryFrameRing::SlotHeader();
+            slot->lock.store(0, std::memory_order_relaxed);
+            //offsets of the maps are fixed, only their sizes change with the resolution of the frames
+            size_t offset = SharedMemoryFrameRing::align(sizeof(SharedMemoryFrameRing::SlotHeader));
+            for (int channel = 0; channel < SharedMemoryFrameRing::ChannelCount; ++channel) {
+                slot->channels[channel].offset = offset;
+                slot->channels[channel].bytes = 0;
+                offset += SharedMemoryFrameRing::align((size_t) maxWidth * maxHeight * SharedMemoryFrameRing::channelPixelSize(channel));
+            }
+        }
+        SharedMemoryFrameRing::RingHeader* header = new (ring) SharedMemoryFrameRing::RingHeader();
+        header->version = SharedMemoryFrameRing::Version;
+        header->slotCount = slotCount;
+        header->maxWidth = maxWidth;
+        header->maxHeight = maxHeight;
+        header->slotSize = slotSize;
+        header->lastSequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        //readers check the magic first, it is written when the layout is complete
+        header->magic = SharedMemoryFrameRing::Magic;
+    }
+
+    SharedMemoryFrameWriter::~SharedMemoryFrameWriter() {
+        munmap(ring, ringBytes);
+        shm_unlink(name.c_str());
+    }
+
+    bool SharedMemoryFrameWriter::write(const pho::api::Frame& frame, int64_t stamp) {
+        SharedMemoryFrameRing::RingHeader* header = reinterpret_cast<SharedMemoryFrameRing::RingHeader*>(ring);
+        const pho::api::PhoXiSize& size = frame.PointCloud.Empty() ? frame.DepthMap.Size : frame.PointCloud.Size;
+        if ((uint32_t) size.Width > header->maxWidth || (uint32_t) size.Height > header->maxHeight) {
+            return false;
+        }
+        const uint64_t sequence = header->lastSequence.load(std::memory_order_relaxed) + 1;
+        uint8_t* slot = ring + SharedMemoryFrameRing::align(sizeof(SharedMemoryFrameRing::RingHeader)) +
+                        (sequence % header->slotCount) * header->slotSize;
+        SharedMemoryFrameRing::SlotHeader* slotHeader = reinterpret_cast<SharedMemoryFrameRing::SlotHeader*>(slot);
+
+        //odd lock invalidates views of the previous frame in the slot before its maps are overwritten
+        slotHeader->lock.store(2 * sequence - 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slotHeader->frameIndex = frame.Info.FrameIndex;
+        slotHeader->stamp = stamp;
+        slotHeader->width = size.Width;
+        slotHeader->height = size.Height;
+        copyChannel(frame.PointCloud, slot, slotHeader->channels[SharedMemoryFrameRing::PointCloud]);
+        copyChannel(frame.NormalMap, slot, slotHeader->channels[SharedMemoryFrameRing::NormalMap]);
+        copyChannel(frame.DepthMap, slot, slotHeader->channels[SharedMemoryFrameRing::DepthMap]);
+        copyChannel(frame.ConfidenceMap, slot, slotHeader->channels[SharedMemoryFrameRing::ConfidenceMap]);
+        copyChannel(frame.Texture, slot, slotHeader->channels[SharedMemoryFrameRing::Texture]);
+        slotHeader->lock.store(2 * sequence, std::memory_order_release);
+        header->lastSequence.store(sequence, std::memory_order_release);
+        return true;
+    }
+
+    bool SharedMemoryFrameWriter::adviseHugePages() {
+        return phoxi_camera::adviseHugePages(ring, ringBytes);
+    }
+
+    const std::string& SharedMemoryFrameWriter::getName() const {
+        return name;
+    }
+}
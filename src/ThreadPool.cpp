@@ -0,0 +1,132 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/ThreadPool.h"
+#include <algorithm>
+
+namespace phoxi_camera {
+
+    ThreadPool::ThreadPool() : stopping(false), generation(0), initializedWorkers(0), activeWorkers(0),
+                               body(nullptr), begin(0), end(0), chunkSize(1), chunkCount(0), nextChunk(0) {
+    }
+
+    ThreadPool::~ThreadPool() {
+        stop();
+    }
+
+    void ThreadPool::start(int threads, const std::function<void()>& initializer) {
+        stop();
+        if (threads <= 0) {
+            threads = std::max(1, (int) std::thread::hardware_concurrency());
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = false;
+        initializedWorkers = 0;
+        for (int i = 1; i < threads; ++i) {
+            workers.push_back(std::thread(&ThreadPool::run, this, initializer));
+        }
+        workDone.wait(lock, [&] { return initializedWorkers == (int) workers.size(); });
+    }
+
+    void ThreadPool::stop() {
+        std::lock_guard<std::mutex> loopLock(loopMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    int ThreadPool::getThreadCount() const {
+        return (int) workers.size() + 1;
+    }
+
+    void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& body, int minChunk) {
+        if (end <= begin) {
+            return;
+        }
+        std::lock_guard<std::mutex> loopLock(loopMutex);
+        const int iterations = end - begin;
+        //a few chunks per thread balance rows of different cost
+        const int chunks = std::min(iterations, getThreadCount() * 4);
+        const int size = std::max(std::max(1, minChunk), (iterations + chunks - 1) / chunks);
+        if (workers.empty() || size >= iterations) {
+            body(begin, end);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->body = &body;
+            this->begin = begin;
+            this->end = end;
+            chunkSize = size;
+            chunkCount = (iterations + size - 1) / size;
+            nextChunk.store(0);
+            activeWorkers = (int) workers.size();
+            ++generation;
+        }
+        workAvailable.notify_all();
+        runChunks();
+        std::exception_ptr exception;
+        {
+            //the body and the range stay referenced by the workers until all of them are done, even after an exception
+            std::unique_lock<std::mutex> lock(mutex);
+            workDone.wait(lock, [&] { return activeWorkers == 0; });
+            this->body = nullptr;
+            std::swap(exception, firstException);
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void ThreadPool::run(std::function<void()> initializer) {
+        if (initializer) {
+            initializer();
+        }
+        uint64_t lastGeneration;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lastGeneration = generation;
+            ++initializedWorkers;
+        }
+        workDone.notify_all();
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&] { return stopping || generation != lastGeneration; });
+                if (stopping) {
+                    return;
+                }
+                lastGeneration = generation;
+            }
+            runChunks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --activeWorkers;
+            }
+            workDone.notify_all();
+        }
+    }
+
+    void ThreadPool::runChunks() {
+        try {
+            for (int chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)) {
+                const int chunkBegin = begin + chunk * chunkSize;
+                (*body)(chunkBegin, std::min(end, chunkBegin + chunkSize));
+            }
+        } catch (...) {
+            //the remaining chunks are skipped, the first exception is rethrown on the calling thread
+            nextChunk.store(chunkCount);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstException) {
+                firstException = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,237 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/ThreadScheduling.h"
+#include "phoxi_camera/PhoXiException.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+namespace phoxi_camera {
+
+    namespace {
+        //buckets grow by 2^(1/4) from 1 us, the last one ends after 65 ms
+        const double jitterFirstBucket = 1e-6;
+        const double jitterBucketsPerOctave = 4.0;
+
+        int schedulingPolicy(const std::string& policy) {
+            if (policy == "other") {
+                return SCHED_OTHER;
+            } else if (policy == "fifo") {
+                return SCHED_FIFO;
+            } else if (policy == "rr") {
+                return SCHED_RR;
+            }
+            throw ThreadSchedulingError("Unknown scheduling policy " + policy + "!");
+        }
+
+        int64_t monotonicNanoseconds() {
+            struct timespec time;
+            clock_gettime(CLOCK_MONOTONIC, &time);
+            return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+        }
+    }
+
+    std::string applyThreadScheduling(const ThreadSchedulingConfig& config) {
+        std::ostringstream description;
+        const int policy = schedulingPolicy(config.policy);
+        struct sched_param param;
+        param.sched_priority = policy == SCHED_OTHER ? 0 : config.priority;
+        int error = pthread_setschedparam(pthread_self(), policy, &param);
+        if (error != 0) {
+            throw ThreadSchedulingError("Unable to set scheduling policy " + config.policy + ": " + std::strerror(error));
+        }
+        description << config.policy;
+        if (policy != SCHED_OTHER) {
+            description << " " << config.priority;
+        }
+
+        std::vector<int> cpus = config.cpus;
+        if (config.numaNode >= 0) {
+            std::vector<int> nodeCpus = numaNodeCpus(config.numaNode);
+            if (nodeCpus.empty()) {
+                throw ThreadSchedulingError("NUMA node " + std::to_string(config.numaNode) + " not found!");
+            }
+            if (cpus.empty()) {
+                cpus = nodeCpus;
+            } else {
+                cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](int cpu) {
+                    return std::find(nodeCpus.begin(), nodeCpus.end(), cpu) == nodeCpus.end();
+                }), cpus.end());
+            }
+            description << ", NUMA node " << config.numaNode;
+        }
+        if (!cpus.empty()) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (int cpu : cpus) {
+                if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &cpuSet);
+                }
+            }
+            error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+            if (error != 0) {
+                throw ThreadSchedulingError(std::string("Unable to set CPU affinity: ") + std::strerror(error));
+            }
+            description << ", CPUs";
+            for (int cpu : cpus) {
+                description << " " << cpu;
+            }
+        } else if (config.numaNode >= 0 || !config.cpus.empty()) {
+            throw ThreadSchedulingError("No CPU of the CPU list is on NUMA node " + std::to_string(config.numaNode) + "!");
+        }
+        return description.str();
+    }
+
+    std::vector<int> numaNodeCpus(int node) {
+        std::vector<int> cpus;
+        std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!std::getline(file, list)) {
+            return cpus;
+        }
+        //ranges separated by commas, for example 0-3,8-11
+        std::istringstream ranges(list);
+        std::string range;
+        while (std::getline(ranges, range, ',')) {
+            int first = 0, last = 0;
+            const int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields < 1) {
+                continue;
+            }
+            if (fields == 1) {
+                last = first;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    void lockProcessMemory() {
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+            throw ThreadSchedulingError(std::string("Unable to lock memory: ") + std::strerror(errno));
+        }
+        //frame sized buffers are allocated from the heap instead of fresh mappings and the heap is never trimmed
+        mallopt(M_MMAP_MAX, 0);
+        mallopt(M_TRIM_THRESHOLD, -1);
+    }
+
+    bool adviseHugePages(void* memory, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+        return madvise(memory, bytes, MADV_HUGEPAGE) == 0;
+#else
+        return false;
+#endif
+    }
+
+    SchedulingJitterProbe::SchedulingJitterProbe() : running(false), jitterMaxNanoseconds(0) {
+        for (int i = 0; i < JitterBuckets; ++i) {
+            jitterHistogram[i].store(0);
+        }
+    }
+
+    SchedulingJitterProbe::~SchedulingJitterProbe() {
+        stop();
+    }
+
+    void SchedulingJitterProbe::start(double period, const ThreadSchedulingConfig& config) {
+        stop();
+        running.store(true);
+        thread = std::thread(&SchedulingJitterProbe::run, this, std::max<int64_t>(10000, (int64_t) (period * 1e9)), config);
+    }
+
+    void SchedulingJitterProbe::stop() {
+        running.store(false);
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    bool SchedulingJitterProbe::isRunning() const {
+        return running.load();
+    }
+
+    void SchedulingJitterProbe::run(int64_t periodNanoseconds, ThreadSchedulingConfig config) {
+        try {
+            applyThreadScheduling(config);
+        } catch (ThreadSchedulingError&) {
+            //measures the inherited scheduling, the failure is reported by the driver thread with the same config
+        }
+        int64_t wakeUp = monotonicNanoseconds();
+        while (running.load(std::memory_order_relaxed)) {
+            wakeUp += periodNanoseconds;
+            struct timespec time;
+            time.tv_sec = wakeUp / 1000000000;
+            time.tv_nsec = wakeUp % 1000000000;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr);
+            const int64_t jitter = std::max<int64_t>(0, monotonicNanoseconds() - wakeUp);
+            jitterHistogram[jitterBucket(jitter)].fetch_add(1, std::memory_order_relaxed);
+            int64_t maxJitter = jitterMaxNanoseconds.load(std::memory_order_relaxed);
+            while (jitter > maxJitter &&
+                   !jitterMaxNanoseconds.compare_exchange_weak(maxJitter, jitter, std::memory_order_relaxed)) {
+            }
+            //after a long preemption the missed periods are skipped instead of measured as a burst
+            if (jitter > periodNanoseconds) {
+                wakeUp += jitter / periodNanoseconds * periodNanoseconds;
+            }
+        }
+    }
+
+    int SchedulingJitterProbe::jitterBucket(int64_t nanoseconds) {
+        const double jitter = nanoseconds * 1e-9;
+        if (jitter <= jitterFirstBucket) {
+            return 0;
+        }
+        int bucket = 1 + (int) (std::log2(jitter / jitterFirstBucket) * jitterBucketsPerOctave);
+        return std::min(bucket, JitterBuckets - 1);
+    }
+
+    double SchedulingJitterProbe::bucketUpperBound(int bucket) {
+        return jitterFirstBucket * std::exp2(bucket / jitterBucketsPerOctave);
+    }
+
+    SchedulingJitterProbe::Snapshot SchedulingJitterProbe::snapshot() {
+        Snapshot snapshot;
+        snapshot.jitterMax = jitterMaxNanoseconds.exchange(0, std::memory_order_relaxed) * 1e-9;
+        uint64_t histogram[JitterBuckets];
+        uint64_t samples = 0;
+        for (int i = 0; i < JitterBuckets; ++i) {
+            histogram[i] = jitterHistogram[i].exchange(0, std::memory_order_relaxed);
+            samples += histogram[i];
+        }
+        snapshot.samples = samples;
+        double* percentiles[] = {&snapshot.jitterP50, &snapshot.jitterP99};
+        const double ranks[] = {0.5, 0.99};
+        for (int p = 0; p < 2; ++p) {
+            *percentiles[p] = 0.0;
+            if (samples == 0) {
+                continue;
+            }
+            const uint64_t rank = (uint64_t) std::ceil(ranks[p] * samples);
+            uint64_t accumulated = 0;
+            for (int i = 0; i < JitterBuckets; ++i) {
+                accumulated += histogram[i];
+                if (accumulated >= rank) {
+                    //bucket upper bound, never above the measured maximum
+                    *percentiles[p] = std::min(bucketUpperBound(i), std::max(snapshot.jitterMax, bucketUpperBound(0)));
+                    break;
+                }
+            }
+        }
+        return snapshot;
+    }
+}
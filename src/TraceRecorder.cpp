@@ -0,0 +1,153 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/TraceRecorder.h"
+#include "phoxi_camera/PhoXiException.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace phoxi_camera {
+
+    TraceRecorder& TraceRecorder::instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    TraceRecorder::TraceRecorder() : recording(false), session(0), eventsPerThread(65536) {
+    }
+
+    void TraceRecorder::start(size_t eventsPerThread) {
+        this->eventsPerThread.store(eventsPerThread);
+        {
+            //events of exited threads belong to the previous capture
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            removeExitedBuffers();
+        }
+        //threads reset their own buffer when they notice the new session
+        session.fetch_add(1);
+        recording.store(true);
+    }
+
+    size_t TraceRecorder::stop(const std::string& path) {
+        recording.store(false);
+        uint64_t currentSession = session.load();
+
+        std::ofstream file(path.c_str());
+        if (!file) {
+            throw UnableToWriteTrace("Unable to open trace file " + path);
+        }
+        pid_t pid = getpid();
+        size_t written = 0;
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (size_t b = 0; b < buffers.size(); ++b) {
+            ThreadBuffer& buffer = *buffers[b];
+            if (buffer.session.load(std::memory_order_acquire) != currentSession) {
+                continue;
+            }
+            size_t size = buffer.size.load(std::memory_order_acquire);
+            for (size_t i = 0; i < size; ++i) {
+                const TraceEvent& event = buffer.events[i];
+                file << (written == 0 ? "\n" : ",\n");
+                file << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\"";
+                if (event.instant) {
+                    file << ",\"ph\":\"i\",\"s\":\"t\"";
+                } else {
+                    file << ",\"ph\":\"X\",\"dur\":" << event.duration;
+                }
+                file << ",\"ts\":" << event.timestamp << ",\"pid\":" << pid << ",\"tid\":" << buffer.threadId;
+                if (event.frameIndex >= 0) {
+                    file << ",\"args\":{\"frame_index\":" << event.frameIndex << "}";
+                }
+                file << "}";
+                ++written;
+            }
+        }
+        file << "\n]}\n";
+        removeExitedBuffers();
+        file.close();
+        if (!file) {
+            throw UnableToWriteTrace("Unable to write trace file " + path);
+        }
+        return written;
+    }
+
+    void TraceRecorder::record(const char* name, const char* category, int64_t timestamp, int64_t duration, int64_t frameIndex) {
+        TraceEvent event = {name, category, timestamp, duration, frameIndex, false};
+        append(event);
+    }
+
+    void TraceRecorder::recordInstant(const char* name, const char* category, int64_t frameIndex) {
+        if (!isRecording()) {
+            return;
+        }
+        TraceEvent event = {name, category, now(), 0, frameIndex, true};
+        append(event);
+    }
+
+    int64_t TraceRecorder::now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    TraceRecorder::ThreadBuffer* TraceRecorder::threadBuffer() {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer) {
+            //registration happens once per thread, it is the only place where a lock is taken
+            std::shared_ptr<ThreadBuffer> newBuffer(new ThreadBuffer());
+            newBuffer->capacity = eventsPerThread.load();
+            newBuffer->events.reset(new TraceEvent[newBuffer->capacity]);
+            newBuffer->size.store(0);
+            newBuffer->session.store(session.load());
+            newBuffer->threadId = (int) syscall(SYS_gettid);
+            newBuffer->exited = false;
+            {
+                std::lock_guard<std::mutex> lock(buffersMutex);
+                buffers.push_back(newBuffer);
+            }
+            buffer = newBuffer.get();
+            thread_local ThreadBufferOwner owner = {buffer};
+        }
+        return buffer;
+    }
+
+    TraceRecorder::ThreadBufferOwner::~ThreadBufferOwner() {
+        TraceRecorder::instance().releaseThreadBuffer(buffer);
+    }
+
+    void TraceRecorder::releaseThreadBuffer(ThreadBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffer->exited = true;
+        //events of the running capture are kept until stop writes them
+        if (recording.load() && buffer->session.load() == session.load() && buffer->size.load() > 0) {
+            return;
+        }
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [&](const std::shared_ptr<ThreadBuffer>& b) {
+            return b.get() == buffer;
+        }), buffers.end());
+    }
+
+    void TraceRecorder::removeExitedBuffers() {
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const std::shared_ptr<ThreadBuffer>& b) {
+            return b->exited;
+        }), buffers.end());
+    }
+
+    void TraceRecorder::append(const TraceEvent& event) {
+        ThreadBuffer* buffer = threadBuffer();
+        uint64_t currentSession = session.load(std::memory_order_relaxed);
+        if (buffer->session.load(std::memory_order_relaxed) != currentSession) {
+            buffer->size.store(0, std::memory_order_relaxed);
+            buffer->session.store(currentSession, std::memory_order_release);
+        }
+        size_t size = buffer->size.load(std::memory_order_relaxed);
+        if (size >= buffer->capacity) {
+            return;
+        }
+        buffer->events[size] = event;
+        buffer->size.store(size + 1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,247 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include "phoxi_camera/TsdfVolume.h"
+#include <algorithm>
+#include <cmath>
+
+namespace phoxi_camera {
+
+    const int TsdfVolume::BlockSize;
+    const int TsdfVolume::BlockVoxels;
+    const int TsdfVolume::LockStripes;
+
+    namespace {
+        //offset of the block coordinates so that they fit in 21 unsigned bits
+        const int64_t BlockKeyOffset = 1 << 20;
+        const uint64_t BlockKeyMask = (1u << 21) - 1;
+
+        inline int floorDivide(int value, int divisor) {
+            return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+        }
+
+        inline int voxelIndex(int x, int y, int z) {
+            return (z * TsdfVolume::BlockSize + y) * TsdfVolume::BlockSize + x;
+        }
+
+        //calls voxelUpdate(voxel, distance) for each voxel along the ray from origin to point within truncationDistance of the point
+        template <typename VoxelUpdate>
+        inline void traverseTruncatedRay(const Eigen::Vector3f& origin, const Eigen::Vector3f& point, float voxelSize,
+                                         float truncationDistance, VoxelUpdate voxelUpdate) {
+            Eigen::Vector3f direction = point - origin;
+            const float depth = direction.norm();
+            if (depth < 1e-6f) {
+                return;
+            }
+            direction /= depth;
+            const float inverseVoxelSize = 1.0f / voxelSize;
+            const float step = 0.5f * voxelSize;
+            Eigen::Vector3i previous(INT32_MIN, INT32_MIN, INT32_MIN);
+            for (float t = std::max(0.0f, depth - truncationDistance); t <= depth + truncationDistance; t += step) {
+                const Eigen::Vector3f sample = origin + direction * t;
+                const Eigen::Vector3i voxel((int) std::floor(sample.x() * inverseVoxelSize),
+                                            (int) std::floor(sample.y() * inverseVoxelSize),
+                                            (int) std::floor(sample.z() * inverseVoxelSize));
+                if (voxel == previous) {
+                    continue;
+                }
+                previous = voxel;
+                const Eigen::Vector3f center = (voxel.cast<float>() + Eigen::Vector3f::Constant(0.5f)) * voxelSize;
+                const float distance = depth - direction.dot(center - origin);
+                if (distance >= -truncationDistance) {
+                    voxelUpdate(voxel, std::min(distance, truncationDistance));
+                }
+            }
+        }
+    }
+
+    TsdfVolume::TsdfVolume() : voxelSize(0.002f), truncationDistance(0.008f), maxWeight(64.0f), integratedFrames(0),
+                               blockLocks(new std::mutex[LockStripes]) {
+    }
+
+    void TsdfVolume::setParameters(float voxelSize, float truncationDistance, float maxWeight) {
+        voxelSize = std::max(1e-4f, voxelSize);
+        truncationDistance = std::max(voxelSize, truncationDistance);
+        if (voxelSize != this->voxelSize || truncationDistance != this->truncationDistance) {
+            reset();
+        }
+        this->voxelSize = voxelSize;
+        this->truncationDistance = truncationDistance;
+        this->maxWeight = std::max(1.0f, maxWeight);
+    }
+
+    void TsdfVolume::reset() {
+        blocks.clear();
+        integratedFrames = 0;
+    }
+
+    uint64_t TsdfVolume::blockKey(int x, int y, int z) {
+        return (((uint64_t) (x + BlockKeyOffset) & BlockKeyMask) << 42) |
+               (((uint64_t) (y + BlockKeyOffset) & BlockKeyMask) << 21) |
+               ((uint64_t) (z + BlockKeyOffset) & BlockKeyMask);
+    }
+
+    Eigen::Vector3i TsdfVolume::blockCoordinates(uint64_t key) {
+        return Eigen::Vector3i((int) ((int64_t) ((key >> 42) & BlockKeyMask) - BlockKeyOffset),
+                               (int) ((int64_t) ((key >> 21) & BlockKeyMask) - BlockKeyOffset),
+                               (int) ((int64_t) (key & BlockKeyMask) - BlockKeyOffset));
+    }
+
+    const TsdfVolume::Voxel* TsdfVolume::findVoxel(const Eigen::Vector3i& voxel) const {
+        const int bx = floorDivide(voxel.x(), BlockSize), by = floorDivide(voxel.y(), BlockSize), bz = floorDivide(voxel.z(), BlockSize);
+        auto block = blocks.find(blockKey(bx, by, bz));
+        if (block == blocks.end()) {
+            return nullptr;
+        }
+        return &block->second->voxels[voxelIndex(voxel.x() - bx * BlockSize, voxel.y() - by * BlockSize, voxel.z() - bz * BlockSize)];
+    }
+
+    size_t TsdfVolume::getMemoryUsage() const {
+        //each node of the map holds the key, the block pointer and the next node pointer
+        const size_t nodeSize = sizeof(uint64_t) + sizeof(std::unique_ptr<Block>) + sizeof(void*);
+        return blocks.size() * (sizeof(Block) + nodeSize) + blocks.bucket_count() * sizeof(void*);
+    }
+
+    void TsdfVolume::integrate(const std::vector<Eigen::Vector3f>& points, const std::vector<uint8_t>& intensities,
+                               const Eigen::Affine3f& pose, ThreadPool& threadPool) {
+        if (points.empty()) {
+            return;
+        }
+        const Eigen::Vector3f origin = pose.translation();
+        const bool hasIntensities = intensities.size() == points.size();
+
+        //blocks crossed by the truncated rays, the map is only modified by the calling thread
+        std::mutex touchedBlocksMutex;
+        std::vector<uint64_t> touchedBlocks;
+        threadPool.parallelFor(0, (int) points.size(), [&](int begin, int end) {
+            std::vector<uint64_t> chunkBlocks;
+            uint64_t previousKey = ~(uint64_t) 0;
+            for (int i = begin; i < end; ++i) {
+                traverseTruncatedRay(origin, pose * points[i], voxelSize, truncationDistance, [&](const Eigen::Vector3i& voxel, float) {
+                    const uint64_t key = blockKey(floorDivide(voxel.x(), BlockSize), floorDivide(voxel.y(), BlockSize), floorDivide(voxel.z(), BlockSize));
+                    if (key != previousKey) {
+                        chunkBlocks.push_back(key);
+                        previousKey = key;
+                    }
+                });
+            }
+            std::sort(chunkBlocks.begin(), chunkBlocks.end());
+            chunkBlocks.erase(std::unique(chunkBlocks.begin(), chunkBlocks.end()), chunkBlocks.end());
+            std::lock_guard<std::mutex> lock(touchedBlocksMutex);
+            touchedBlocks.insert(touchedBlocks.end(), chunkBlocks.begin(), chunkBlocks.end());
+        }, 4096);
+        for (uint64_t key : touchedBlocks) {
+            std::unique_ptr<Block>& block = blocks[key];
+            if (!block) {
+                block.reset(new Block());
+                for (Voxel& voxel : block->voxels) {
+                    voxel.distance = truncationDistance;
+                    voxel.weight = 0.0f;
+                    voxel.intensity = 0.0f;
+                }
+            }
+        }
+
+        //running weighted means, the lock of the current block is held while consecutive voxels stay in it
+        threadPool.parallelFor(0, (int) points.size(), [&](int begin, int end) {
+            std::unique_lock<std::mutex> blockLock;
+            uint64_t blockKeyLocked = ~(uint64_t) 0;
+            Block* block = nullptr;
+            Eigen::Vector3i blockOrigin = Eigen::Vector3i::Zero();
+            for (int i = begin; i < end; ++i) {
+                const float intensity = hasIntensities ? (float) intensities[i] : 0.0f;
+                traverseTruncatedRay(origin, pose * points[i], voxelSize, truncationDistance, [&](const Eigen::Vector3i& voxel, float distance) {
+                    const int bx = floorDivide(voxel.x(), BlockSize), by = floorDivide(voxel.y(), BlockSize), bz = floorDivide(voxel.z(), BlockSize);
+                    const uint64_t key = blockKey(bx, by, bz);
+                    if (key != blockKeyLocked) {
+                        if (blockLock.owns_lock()) {
+                            blockLock.unlock();
+                        }
+                        block = blocks.find(key)->second.get();
+                        blockLock = std::unique_lock<std::mutex>(blockLocks[key % LockStripes]);
+                        blockKeyLocked = key;
+                        blockOrigin = Eigen::Vector3i(bx, by, bz) * BlockSize;
+                    }
+                    Voxel& v = block->voxels[voxelIndex(voxel.x() - blockOrigin.x(), voxel.y() - blockOrigin.y(), voxel.z() - blockOrigin.z())];
+                    const float weight = v.weight + 1.0f;
+                    v.distance += (distance - v.distance) / weight;
+                    v.intensity += (intensity - v.intensity) / weight;
+                    v.weight = std::min(weight, maxWeight);
+                });
+            }
+        }, 4096);
+        ++integratedFrames;
+    }
+
+    void TsdfVolume::extractSurface(std::vector<Eigen::Vector3f>& points, std::vector<uint8_t>& intensities,
+                                    float minWeight, ThreadPool& threadPool) const {
+        points.clear();
+        intensities.clear();
+        minWeight = std::max(minWeight, 1e-6f);
+
+        //blocks are visited in key order so that the output does not depend on the hash map or the number of threads
+        std::vector<std::pair<uint64_t, const Block*>> sortedBlocks;
+        sortedBlocks.reserve(blocks.size());
+        for (const auto& block : blocks) {
+            sortedBlocks.push_back(std::make_pair(block.first, block.second.get()));
+        }
+        std::sort(sortedBlocks.begin(), sortedBlocks.end(), [](const std::pair<uint64_t, const Block*>& a, const std::pair<uint64_t, const Block*>& b) {
+            return a.first < b.first;
+        });
+
+        std::vector<std::vector<Eigen::Vector3f>> blockPoints(sortedBlocks.size());
+        std::vector<std::vector<uint8_t>> blockIntensities(sortedBlocks.size());
+        threadPool.parallelFor(0, (int) sortedBlocks.size(), [&](int begin, int end) {
+            for (int b = begin; b < end; ++b) {
+                const Block& block = *sortedBlocks[b].second;
+                const Eigen::Vector3i blockOrigin = blockCoordinates(sortedBlocks[b].first) * BlockSize;
+                for (int z = 0; z < BlockSize; ++z) {
+                    for (int y = 0; y < BlockSize; ++y) {
+                        for (int x = 0; x < BlockSize; ++x) {
+                            const Voxel& voxel = block.voxels[voxelIndex(x, y, z)];
+                            if (voxel.weight < minWeight) {
+                                continue;
+                            }
+                            const Eigen::Vector3i coordinates = blockOrigin + Eigen::Vector3i(x, y, z);
+                            for (int axis = 0; axis < 3; ++axis) {
+                                Eigen::Vector3i neighbourCoordinates = coordinates;
+                                ++neighbourCoordinates[axis];
+                                const Voxel* neighbour;
+                                if ((axis == 0 ? x : axis == 1 ? y : z) + 1 < BlockSize) {
+                                    neighbour = &block.voxels[voxelIndex(neighbourCoordinates.x() - blockOrigin.x(), neighbourCoordinates.y() - blockOrigin.y(), neighbourCoordinates.z() - blockOrigin.z())];
+                                } else {
+                                    neighbour = findVoxel(neighbourCoordinates);
+                                }
+                                if (!neighbour || neighbour->weight < minWeight || (voxel.distance >= 0.0f) == (neighbour->distance >= 0.0f)) {
+                                    continue;
+                                }
+                                //jumps between truncated distances are occlusion boundaries, not surfaces
+                                if (std::abs(voxel.distance - neighbour->distance) > 2.0f * voxelSize) {
+                                    continue;
+                                }
+                                const float t = voxel.distance / (voxel.distance - neighbour->distance);
+                                Eigen::Vector3f point = (coordinates.cast<float>() + Eigen::Vector3f::Constant(0.5f)) * voxelSize;
+                                point[axis] += t * voxelSize;
+                                const float intensity = voxel.intensity + t * (neighbour->intensity - voxel.intensity);
+                                blockPoints[b].push_back(point);
+                                blockIntensities[b].push_back((uint8_t) std::min(255.0f, std::max(0.0f, intensity + 0.5f)));
+                            }
+                        }
+                    }
+                }
+            }
+        }, 16);
+
+        size_t count = 0;
+        for (const auto& block : blockPoints) {
+            count += block.size();
+        }
+        points.reserve(count);
+        intensities.reserve(count);
+        for (size_t b = 0; b < blockPoints.size(); ++b) {
+            points.insert(points.end(), blockPoints[b].begin(), blockPoints[b].end());
+            intensities.insert(intensities.end(), blockIntensities[b].begin(), blockIntensities[b].end());
+        }
+    }
+}
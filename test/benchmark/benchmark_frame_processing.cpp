@@ -0,0 +1,287 @@
+//
+// Benchmarks of the frame processing hot paths, they run on synthetic frames without a scanner or PhoXi Control.
+//
+// Results are written as JSON to phoxi_camera_benchmarks.json (override with --benchmark_out=<file>) so that they can
+// be compared between releases, for example with tools/compare.py of Google Benchmark.
+//
+
+#include <benchmark/benchmark.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "phoxi_camera/TsdfVolume.h"
+#include "synthetic_frame.h"
+
+#include <pcl_conversions/pcl_conversions.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/fill_image.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cv_bridge/cv_bridge.h>
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace phoxi_camera_test;
+
+static const double InvalidPointsRatio = 0.25;
+
+static PFramePostProcessed getPostProcessedFrame(int width, int height) {
+    //frames are cached to keep their generation out of the measurements
+    static std::map<std::pair<int, int>, PFramePostProcessed> frames;
+    auto it = frames.find(std::make_pair(width, height));
+    if (it != frames.end()) {
+        return it->second;
+    }
+    PhoXiInterface phoxiInterface;
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(createSyntheticFrame(width, height, InvalidPointsRatio));
+    frames[std::make_pair(width, height)] = frame;
+    return frame;
+}
+
+static void setFrameCounters(benchmark::State& state, int width, int height) {
+    state.SetItemsProcessed(state.iterations() * (int64_t) width * height);
+    state.counters["width"] = width;
+    state.counters["height"] = height;
+}
+
+static void ResolutionArguments(benchmark::internal::Benchmark* benchmark) {
+    benchmark->Args({LowResolutionWidth, LowResolutionHeight});
+    benchmark->Args({HighResolutionWidth, HighResolutionHeight});
+    benchmark->Unit(benchmark::kMillisecond);
+}
+
+static void BM_PostProcessFrame(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PhoXiInterface phoxiInterface;
+    pho::api::PFrame frame = createSyntheticFrame(width, height, InvalidPointsRatio);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(phoxiInterface.postProcessFrame(frame));
+    }
+    setFrameCounters(state, width, height);
+}
+BENCHMARK(BM_PostProcessFrame)->Apply(ResolutionArguments);
+
+template <typename PointT, bool OnlyValidPoints>
+static void BM_GetPointCloudFromFrame(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setGeneratePointCloudWithOnlyValidPoints(OnlyValidPoints);
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(phoxiInterface.getPointCloudFromFrame<PointT>(frame));
+    }
+    setFrameCounters(state, width, height);
+}
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZ, false)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZ, true)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZI, false)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZRGB, false)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZRGBNormal, false)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_GetPointCloudFromFrame, pcl::PointXYZRGBNormal, true)->Apply(ResolutionArguments);
+
+static void BM_GetPointCloudFromFrameWithFilters(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setPointCloudMinConfidence(2.0f);
+    phoxiInterface.setPointCloudJumpEdgeMaxDepthRatio(1.05f);
+    phoxiInterface.setPointCloudMinValidNeighbours(6);
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(phoxiInterface.getPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame));
+    }
+    setFrameCounters(state, width, height);
+}
+BENCHMARK(BM_GetPointCloudFromFrameWithFilters)->Apply(ResolutionArguments);
+
+static void BM_GetPointCloudFromFrameWithTransform(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PhoXiInterface phoxiInterface;
+    Eigen::Affine3f transform = Eigen::Translation3f(0.5f, -0.2f, 1.2f) * Eigen::AngleAxisf(M_PI, Eigen::Vector3f::UnitX());
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(phoxiInterface.getPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, transform));
+    }
+    setFrameCounters(state, width, height);
+}
+BENCHMARK(BM_GetPointCloudFromFrameWithTransform)->Apply(ResolutionArguments);
+
+static void BM_GetPreviewPointCloudFromFrame(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    const int factor = state.range(2);
+    const PreviewPooling pooling = state.range(3) ? PreviewPooling::MedianDepth : PreviewPooling::MinDepth;
+    PhoXiInterface phoxiInterface;
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(phoxiInterface.getPreviewPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, factor, pooling));
+    }
+    setFrameCounters(state, width, height);
+}
+BENCHMARK(BM_GetPreviewPointCloudFromFrame)
+        ->Args({HighResolutionWidth, HighResolutionHeight, 2, 0})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 4, 0})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 4, 1})
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_GetVoxelGridPointCloudFromFrame(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    const float leafSize = state.range(2) * 0.001f;
+    PhoXiInterface phoxiInterface;
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    size_t voxels = 0;
+    for (auto _ : state) {
+        voxels = phoxiInterface.getVoxelGridPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, leafSize)->size();
+    }
+    setFrameCounters(state, width, height);
+    state.counters["voxels"] = voxels;
+}
+BENCHMARK(BM_GetVoxelGridPointCloudFromFrame)
+        ->Args({HighResolutionWidth, HighResolutionHeight, 2})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 5})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 10})
+        ->Unit(benchmark::kMillisecond);
+
+template <typename PointT>
+static void BM_PointCloud2Serialization(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PhoXiInterface phoxiInterface;
+    auto cloud = phoxiInterface.getPointCloudFromFrame<PointT>(getPostProcessedFrame(width, height));
+    size_t bytes = 0;
+    for (auto _ : state) {
+        sensor_msgs::PointCloud2 output;
+        pcl::toROSMsg(*cloud, output);
+        bytes = ros::serialization::serializationLength(output);
+        std::vector<uint8_t> buffer(bytes);
+        ros::serialization::OStream stream(buffer.data(), (uint32_t) buffer.size());
+        ros::serialization::serialize(stream, output);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    setFrameCounters(state, width, height);
+    state.SetBytesProcessed(state.iterations() * (int64_t) bytes);
+}
+BENCHMARK_TEMPLATE(BM_PointCloud2Serialization, pcl::PointXYZ)->Apply(ResolutionArguments);
+BENCHMARK_TEMPLATE(BM_PointCloud2Serialization, pcl::PointXYZRGBNormal)->Apply(ResolutionArguments);
+
+static void BM_FillImageMessages(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    PFramePostProcessed frame = getPostProcessedFrame(width, height);
+    std_msgs::Header header;
+    header.frame_id = "PhoXi3Dscanner_sensor";
+    for (auto _ : state) {
+        sensor_msgs::Image depth_map;
+        sensor_msgs::fillImage(depth_map, sensor_msgs::image_encodings::TYPE_32FC1, height, width, width * sizeof(float), frame->PFrame->DepthMap.operator[](0));
+        sensor_msgs::Image confidence_map;
+        sensor_msgs::fillImage(confidence_map, sensor_msgs::image_encodings::TYPE_32FC1, height, width, width * sizeof(float), frame->PFrame->ConfidenceMap.operator[](0));
+        sensor_msgs::Image texture;
+        sensor_msgs::fillImage(texture, sensor_msgs::image_encodings::TYPE_32FC1, height, width, width * sizeof(float), frame->PFrame->Texture.operator[](0));
+        sensor_msgs::Image normal_map;
+        sensor_msgs::fillImage(normal_map, sensor_msgs::image_encodings::TYPE_32FC3, height, width, width * sizeof(float) * 3, frame->PFrame->NormalMap.operator[](0));
+        cv_bridge::CvImage mono8Texture(header, sensor_msgs::image_encodings::MONO8, frame->TextureAfterPostProcessing);
+        sensor_msgs::ImagePtr mono8_image_msg = mono8Texture.toImageMsg();
+        benchmark::DoNotOptimize(mono8_image_msg);
+    }
+    setFrameCounters(state, width, height);
+    state.SetBytesProcessed(state.iterations() * (int64_t) width * height * (sizeof(float) * 6 + 1));
+}
+BENCHMARK(BM_FillImageMessages)->Apply(ResolutionArguments);
+
+static const int TsdfViews = 8;
+
+//views of the synthetic scene from scanner poses on an arc around it, as recorded by a scanner on a robot wrist
+static void getTsdfView(int width, int height, int view, std::vector<Eigen::Vector3f>& points, std::vector<uint8_t>& intensities, Eigen::Affine3f& pose) {
+    static std::map<std::pair<int, int>, std::vector<std::pair<std::vector<Eigen::Vector3f>, std::vector<uint8_t>>>> views;
+    auto& sequence = views[std::make_pair(width, height)];
+    if (sequence.empty()) {
+        PhoXiInterface phoxiInterface;
+        for (int v = 0; v < TsdfViews; ++v) {
+            PFramePostProcessed frame = phoxiInterface.postProcessFrame(createSyntheticFrame(width, height, InvalidPointsRatio, v, v));
+            sequence.emplace_back();
+            phoxiInterface.getSubsampledPointsFromFrame(frame, 1, sequence.back().first, &sequence.back().second);
+        }
+    }
+    points = sequence[view % TsdfViews].first;
+    intensities = sequence[view % TsdfViews].second;
+    const Eigen::Vector3f center(0.0f, 0.0f, 1.0f);
+    pose = Eigen::Translation3f(center) * Eigen::AngleAxisf(0.05f * (view % TsdfViews), Eigen::Vector3f::UnitY()) * Eigen::Translation3f(-center);
+}
+
+static void BM_TsdfIntegrate(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    const float voxelSize = state.range(2) * 0.001f;
+    phoxi_camera::ThreadPool threadPool;
+    threadPool.start(0);
+    phoxi_camera::TsdfVolume volume;
+    volume.setParameters(voxelSize, 4.0f * voxelSize, 64.0f);
+    std::vector<Eigen::Vector3f> points;
+    std::vector<uint8_t> intensities;
+    Eigen::Affine3f pose;
+    int view = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        getTsdfView(width, height, view++, points, intensities, pose);
+        state.ResumeTiming();
+        volume.integrate(points, intensities, pose, threadPool);
+    }
+    setFrameCounters(state, width, height);
+    state.counters["voxels"] = volume.getVoxelCount();
+    state.counters["bytes_per_million_voxels"] = volume.getMemoryUsage() / (volume.getVoxelCount() * 1e-6);
+}
+BENCHMARK(BM_TsdfIntegrate)
+        ->Args({LowResolutionWidth, LowResolutionHeight, 2})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 2})
+        ->Args({HighResolutionWidth, HighResolutionHeight, 4})
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_TsdfExtractSurface(benchmark::State& state) {
+    const int width = state.range(0);
+    const int height = state.range(1);
+    phoxi_camera::ThreadPool threadPool;
+    threadPool.start(0);
+    phoxi_camera::TsdfVolume volume;
+    volume.setParameters(0.002f, 0.008f, 64.0f);
+    std::vector<Eigen::Vector3f> points;
+    std::vector<uint8_t> intensities;
+    Eigen::Affine3f pose;
+    for (int view = 0; view < TsdfViews; ++view) {
+        getTsdfView(width, height, view, points, intensities, pose);
+        volume.integrate(points, intensities, pose, threadPool);
+    }
+    for (auto _ : state) {
+        volume.extractSurface(points, intensities, 0.0f, threadPool);
+        benchmark::DoNotOptimize(points.data());
+    }
+    state.counters["voxels"] = volume.getVoxelCount();
+    state.counters["surface_points"] = points.size();
+}
+BENCHMARK(BM_TsdfExtractSurface)->Apply(ResolutionArguments);
+
+int main(int argc, char** argv) {
+    //write JSON results by default, explicit --benchmark_out arguments take precedence
+    std::vector<char*> arguments(argv, argv + argc);
+    std::string out = "--benchmark_out=phoxi_camera_benchmarks.json";
+    std::string outFormat = "--benchmark_out_format=json";
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i) {
+        hasOut = hasOut || std::string(argv[i]).find("--benchmark_out=") == 0;
+    }
+    if (!hasOut) {
+        arguments.push_back(&out[0]);
+        arguments.push_back(&outFormat[0]);
+    }
+    int argumentsCount = (int) arguments.size();
+    benchmark::Initialize(&argumentsCount, arguments.data());
+    if (benchmark::ReportUnrecognizedArguments(argumentsCount, arguments.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
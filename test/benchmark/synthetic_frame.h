@@ -0,0 +1,104 @@
+//
+// Synthetic PhoXi frames for benchmarks and soak tests that run without a scanner or PhoXi Control
+//
+
+#ifndef PROJECT_SYNTHETIC_FRAME_H
+#define PROJECT_SYNTHETIC_FRAME_H
+
+#include <PhoXi.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace phoxi_camera_test {
+
+    const int LowResolutionWidth = 1032;
+    const int LowResolutionHeight = 772;
+    const int HighResolutionWidth = 2064;
+    const int HighResolutionHeight = 1544;
+
+    /**
+     * Create a frame with all the outputs of the scanner filled with a synthetic bin scene: a tilted floor at about
+     * one meter with a few box shaped objects on top of it, using the intrinsics of a PhoXi M scanner.
+     *
+     * \param invalidRatio - approximate ratio of invalid points, half of them in clustered holes (shadows and
+     * reflections) and half of them scattered
+     * \param seed - seed of the pseudo random generator, frames with the same parameters and seed are identical
+     */
+    inline pho::api::PFrame createSyntheticFrame(int width, int height, double invalidRatio = 0.2, uint64_t frameIndex = 0, unsigned int seed = 0) {
+        pho::api::PFrame frame(new pho::api::Frame());
+        pho::api::PhoXiSize size(width, height);
+        frame->PointCloud.Resize(size);
+        frame->NormalMap.Resize(size);
+        frame->DepthMap.Resize(size);
+        frame->ConfidenceMap.Resize(size);
+        frame->Texture.Resize(size);
+        frame->Info.FrameIndex = frameIndex;
+        frame->Successful = true;
+
+        const float scale = width / (float) HighResolutionWidth;
+        const float fx = 2282.8f * scale;
+        const float fy = 2281.4f * scale;
+        const float cx = 1019.4f * scale;
+        const float cy = 776.6f * scale;
+
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        std::normal_distribution<float> noise(0.0f, 0.3f);
+
+        //clustered holes covering half of the invalid points
+        const int holes = 24;
+        const float holeRadius = std::sqrt((float) (invalidRatio * 0.5 * width * height / (holes * M_PI)));
+        float holeCenters[holes][2];
+        for (int i = 0; i < holes; ++i) {
+            holeCenters[i][0] = uniform(generator) * width;
+            holeCenters[i][1] = uniform(generator) * height;
+        }
+
+        for (int r = 0; r < height; ++r) {
+            pho::api::Point3_32f* points = frame->PointCloud[r];
+            pho::api::Point3_32f* normals = frame->NormalMap[r];
+            float* depth = frame->DepthMap[r];
+            float* confidence = frame->ConfidenceMap[r];
+            float* texture = frame->Texture[r];
+            for (int c = 0; c < width; ++c) {
+                float u = c / (float) width;
+                float v = r / (float) height;
+                //floor tilted along the rows, boxes raise the surface towards the scanner
+                float z = 1000.0f + 150.0f * v;
+                pho::api::Point3_32f normal(0.0f, -0.15f, -0.99f);
+                bool box = (u > 0.2f && u < 0.4f && v > 0.3f && v < 0.5f) ||
+                           (u > 0.55f && u < 0.8f && v > 0.6f && v < 0.85f) ||
+                           (u > 0.6f && u < 0.7f && v > 0.1f && v < 0.3f);
+                if (box) {
+                    z -= 120.0f + 60.0f * u;
+                    normal = pho::api::Point3_32f(0.0f, 0.0f, -1.0f);
+                }
+                z += noise(generator);
+
+                bool invalid = uniform(generator) < invalidRatio * 0.5;
+                for (int i = 0; i < holes && !invalid; ++i) {
+                    float dc = c - holeCenters[i][0];
+                    float dr = r - holeCenters[i][1];
+                    invalid = dc * dc + dr * dr < holeRadius * holeRadius;
+                }
+
+                if (invalid) {
+                    points[c] = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+                    normals[c] = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+                    depth[c] = 0.0f;
+                    confidence[c] = 0.0f;
+                } else {
+                    points[c] = pho::api::Point3_32f((c - cx) * z / fx, (r - cy) * z / fy, z);
+                    normals[c] = normal;
+                    depth[c] = z;
+                    confidence[c] = 1.0f + 4.0f * uniform(generator);
+                }
+                texture[c] = (box ? 900.0f : 300.0f) + 200.0f * uniform(generator);
+            }
+        }
+        return frame;
+    }
+}
+
+#endif //PROJECT_SYNTHETIC_FRAME_H
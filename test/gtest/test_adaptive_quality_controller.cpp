@@ -0,0 +1,100 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/AdaptiveQualityController.h"
+
+using namespace phoxi_camera;
+
+TEST (AdaptiveQualityController, degradeOnMissedDeadline) {
+    AdaptiveQualityController controller;
+    controller.setParameters(0.1, 0.5, 3, 3);
+    EXPECT_FALSE(controller.update(0.05));
+    EXPECT_EQ(0, controller.getLevel());
+    //each missed deadline degrades by one level, up to maxLevel
+    for (int level = 1; level <= 3; ++level) {
+        EXPECT_TRUE(controller.update(0.2));
+        EXPECT_EQ(level, controller.getLevel());
+        EXPECT_EQ(0u, controller.getLastDecision().find("decreased quality to level " + std::to_string(level)));
+    }
+    EXPECT_FALSE(controller.update(0.2));
+    EXPECT_EQ(3, controller.getLevel());
+}
+
+TEST (AdaptiveQualityController, recoverAfterHoldFrames) {
+    AdaptiveQualityController controller;
+    controller.setParameters(0.1, 0.5, 3, 3);
+    EXPECT_TRUE(controller.update(0.2));
+    EXPECT_TRUE(controller.update(0.2));
+    EXPECT_EQ(2, controller.getLevel());
+    //one level up every holdFrames frames below headroom * deadline
+    for (int level = 1; level >= 0; --level) {
+        EXPECT_FALSE(controller.update(0.01));
+        EXPECT_FALSE(controller.update(0.01));
+        EXPECT_TRUE(controller.update(0.01));
+        EXPECT_EQ(level, controller.getLevel());
+        EXPECT_EQ(0u, controller.getLastDecision().find("increased quality to level " + std::to_string(level)));
+    }
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(controller.update(0.01));
+    }
+    EXPECT_EQ(0, controller.getLevel());
+}
+
+TEST (AdaptiveQualityController, recoverOnFilteredLatency) {
+    AdaptiveQualityController controller;
+    controller.setParameters(0.1, 0.5, 3, 3);
+    EXPECT_TRUE(controller.update(0.2));
+    //below the deadline but above the headroom
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(controller.update(0.09));
+    }
+    EXPECT_NEAR(0.09, controller.getFilteredLatency(), 1e-9);
+    //one fast frame is not enough, the filtered latency is 0.3 * 0.01 + 0.7 * 0.09
+    EXPECT_FALSE(controller.update(0.01));
+    EXPECT_NEAR(0.066, controller.getFilteredLatency(), 1e-9);
+    EXPECT_TRUE(controller.update(0.01));
+    EXPECT_NEAR(0.0492, controller.getFilteredLatency(), 1e-9);
+    EXPECT_EQ(0, controller.getLevel());
+}
+
+TEST (AdaptiveQualityController, filterRestartedOnChange) {
+    AdaptiveQualityController controller;
+    controller.setParameters(0.1, 0.5, 3, 1);
+    EXPECT_FALSE(controller.update(0.08));
+    EXPECT_FALSE(controller.update(0.08));
+    EXPECT_TRUE(controller.update(0.3));
+    EXPECT_EQ(1, controller.getLevel());
+    //the first latency after a change is not blended with the latencies of the previous level
+    EXPECT_TRUE(controller.update(0.02));
+    EXPECT_DOUBLE_EQ(0.02, controller.getFilteredLatency());
+    EXPECT_EQ(0, controller.getLevel());
+    EXPECT_FALSE(controller.update(0.06));
+    EXPECT_DOUBLE_EQ(0.06, controller.getFilteredLatency());
+}
+
+TEST (AdaptiveQualityController, maxLevelDecreased) {
+    AdaptiveQualityController controller;
+    controller.setParameters(0.1, 0.5, 3, 3);
+    EXPECT_TRUE(controller.update(0.2));
+    EXPECT_TRUE(controller.update(0.2));
+    EXPECT_TRUE(controller.update(0.2));
+    EXPECT_EQ(3, controller.getLevel());
+
+    controller.setParameters(0.1, 0.5, 1, 3);
+    EXPECT_EQ(1, controller.getLevel());
+    EXPECT_EQ("increased quality to level 1: max level decreased", controller.getLastDecision());
+    EXPECT_FALSE(controller.update(0.2));
+    EXPECT_EQ(1, controller.getLevel());
+
+    controller.setParameters(0.1, 0.5, 0, 3);
+    EXPECT_EQ(0, controller.getLevel());
+    EXPECT_FALSE(controller.update(0.2));
+
+    controller.setParameters(0.1, 0.5, 3, 3);
+    EXPECT_TRUE(controller.update(0.2));
+    controller.reset();
+    EXPECT_EQ(0, controller.getLevel());
+    EXPECT_TRUE(controller.getLastDecision().empty());
+}
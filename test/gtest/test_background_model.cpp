@@ -0,0 +1,133 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/BackgroundModel.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace phoxi_camera;
+
+//all the points at distance mm on the optical axis, except the last point of the frame which is invalid
+static pho::api::PFrame createFlatFrame(int width, int height, float distance) {
+    pho::api::PFrame frame(new pho::api::Frame());
+    frame->PointCloud.Resize(pho::api::PhoXiSize(width, height));
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            frame->PointCloud[r][c] = pho::api::Point3_32f(0.0f, 0.0f, distance);
+        }
+    }
+    frame->PointCloud[height - 1][width - 1] = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+    frame->Successful = true;
+    return frame;
+}
+
+TEST (BackgroundModel, learnedMean) {
+    BackgroundModel backgroundModel;
+    EXPECT_FALSE(backgroundModel.isLearned());
+    pho::api::PFrame first = createFlatFrame(4, 3, 1000.0f);
+    //the first point is invalid in the second frame, its mean is over the first frame only
+    pho::api::PFrame second = createFlatFrame(4, 3, 1010.0f);
+    second->PointCloud[0][0] = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+    backgroundModel.addFrame(*first);
+    backgroundModel.addFrame(*second);
+    EXPECT_TRUE(backgroundModel.isLearned());
+    EXPECT_EQ(2u, backgroundModel.getLearnedFrames());
+
+    //background at 1005 mm, 1000 mm for the first point
+    pho::api::PFrame frame = createFlatFrame(4, 3, 1009.0f);
+    frame->PointCloud[0][0] = pho::api::Point3_32f(0.0f, 0.0f, 1004.0f);
+    frame->PointCloud[0][1] = pho::api::Point3_32f(0.0f, 0.0f, 1011.0f);
+    //the distance to the scanner is compared, not the depth
+    frame->PointCloud[0][2] = pho::api::Point3_32f(0.0f, 200.0f, 1005.0f);
+    frame->PointCloud[0][3] = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+    std::vector<uint8_t> mask;
+    EXPECT_EQ(2u, backgroundModel.computeForegroundMask(*frame, 5.0f, mask));
+    ASSERT_EQ(12u, mask.size());
+    const std::vector<uint8_t> expected = {0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    EXPECT_EQ(expected, mask);
+}
+
+TEST (BackgroundModel, neverValidBackground) {
+    BackgroundModel backgroundModel;
+    backgroundModel.addFrame(*createFlatFrame(4, 3, 1000.0f));
+    backgroundModel.addFrame(*createFlatFrame(4, 3, 1000.0f));
+    //the last pixel keeps a background distance of 0, any valid point there is foreground
+    pho::api::PFrame frame = createFlatFrame(4, 3, 1000.0f);
+    frame->PointCloud[2][3] = pho::api::Point3_32f(0.0f, 0.0f, 1000.0f);
+    std::vector<uint8_t> mask;
+    EXPECT_EQ(1u, backgroundModel.computeForegroundMask(*frame, 5.0f, mask));
+    EXPECT_EQ(1, mask[11]);
+}
+
+TEST (BackgroundModel, resolutionChangeAndReset) {
+    BackgroundModel backgroundModel;
+    std::vector<uint8_t> mask;
+    //without background all the valid points are foreground
+    EXPECT_EQ(11u, backgroundModel.computeForegroundMask(*createFlatFrame(4, 3, 1000.0f), 5.0f, mask));
+
+    backgroundModel.addFrame(*createFlatFrame(4, 3, 1000.0f));
+    EXPECT_EQ(0u, backgroundModel.computeForegroundMask(*createFlatFrame(4, 3, 1000.0f), 5.0f, mask));
+    EXPECT_EQ(5u, backgroundModel.computeForegroundMask(*createFlatFrame(3, 2, 1000.0f), 5.0f, mask));
+    EXPECT_EQ(6u, mask.size());
+
+    //another resolution restarts the learning
+    backgroundModel.addFrame(*createFlatFrame(3, 2, 1100.0f));
+    EXPECT_EQ(1u, backgroundModel.getLearnedFrames());
+    EXPECT_EQ(0u, backgroundModel.computeForegroundMask(*createFlatFrame(3, 2, 1100.0f), 5.0f, mask));
+    EXPECT_EQ(11u, backgroundModel.computeForegroundMask(*createFlatFrame(4, 3, 1000.0f), 5.0f, mask));
+
+    backgroundModel.reset();
+    EXPECT_FALSE(backgroundModel.isLearned());
+    EXPECT_EQ(5u, backgroundModel.computeForegroundMask(*createFlatFrame(3, 2, 1100.0f), 5.0f, mask));
+}
+
+TEST (BackgroundModel, counterSaturation) {
+    BackgroundModel backgroundModel;
+    pho::api::PFrame frame = createFlatFrame(2, 2, 1000.0f);
+    const uint32_t maxFrames = std::numeric_limits<uint16_t>::max();
+    for (uint32_t i = 0; i < maxFrames; ++i) {
+        backgroundModel.addFrame(*frame);
+    }
+    EXPECT_EQ(maxFrames, backgroundModel.getLearnedFrames());
+    //frames past the capacity of the per pixel counters are ignored instead of wrapping the counters around
+    pho::api::PFrame farFrame = createFlatFrame(2, 2, 2000.0f);
+    for (int i = 0; i < 10; ++i) {
+        backgroundModel.addFrame(*farFrame);
+    }
+    EXPECT_EQ(maxFrames, backgroundModel.getLearnedFrames());
+    std::vector<uint8_t> mask;
+    EXPECT_EQ(0u, backgroundModel.computeForegroundMask(*frame, 5.0f, mask));
+    EXPECT_EQ(3u, backgroundModel.computeForegroundMask(*farFrame, 5.0f, mask));
+}
+
+TEST (BackgroundModel, syntheticScene) {
+    BackgroundModel backgroundModel;
+    //the frames of a static scene, with the same seed
+    for (uint64_t frameIndex = 0; frameIndex < 4; ++frameIndex) {
+        backgroundModel.addFrame(*phoxi_camera_test::createSyntheticFrame(160, 120, 0.05, frameIndex, 7));
+    }
+    //the same scene with an object in front of the floor
+    pho::api::PFrame frame = phoxi_camera_test::createSyntheticFrame(160, 120, 0.05, 4, 7);
+    size_t objectPoints = 0;
+    for (int r = 100; r < 110; ++r) {
+        for (int c = 10; c < 30; ++c) {
+            pho::api::Point3_32f& point = frame->PointCloud[r][c];
+            if (point.z > 0.0f) {
+                point = pho::api::Point3_32f(point.x * 0.9f, point.y * 0.9f, point.z * 0.9f);
+                ++objectPoints;
+            }
+        }
+    }
+    std::vector<uint8_t> mask;
+    EXPECT_EQ(objectPoints, backgroundModel.computeForegroundMask(*frame, 10.0f, mask));
+    for (int r = 100; r < 110; ++r) {
+        for (int c = 10; c < 30; ++c) {
+            EXPECT_EQ(frame->PointCloud[r][c].z > 0.0f, (bool) mask[r * 160 + c]);
+        }
+    }
+}
@@ -0,0 +1,143 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/DepthBackProjection.h"
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace phoxi_camera;
+
+static const int width = 160;
+static const int height = 120;
+static const double cameraMatrix[9] = {150.0, 0.0, 79.5, 0.0, 152.0, 61.25, 0.0, 0.0, 1.0};
+static const std::vector<double> plumbBob = {-0.12, 0.04, 0.0015, -0.001, 0.008};
+static const std::vector<double> rationalPolynomial = {0.25, -0.06, 0.0015, -0.001, 0.01, 0.3, -0.05, 0.012};
+
+//forward projection of the plumb_bob and rational_polynomial models, as cv::projectPoints
+static void project(const double* K, const std::vector<double>& D, double X, double Y, double Z, double& u, double& v) {
+    double k[8] = {0.0};
+    for (size_t i = 0; i < D.size() && i < 8; ++i) {
+        k[i] = D[i];
+    }
+    const double x = X / Z, y = Y / Z;
+    const double r2 = x * x + y * y;
+    const double radial = (1.0 + ((k[4] * r2 + k[1]) * r2 + k[0]) * r2) / (1.0 + ((k[7] * r2 + k[6]) * r2 + k[5]) * r2);
+    const double xd = x * radial + 2.0 * k[2] * x * y + k[3] * (r2 + 2.0 * x * x);
+    const double yd = y * radial + k[2] * (r2 + 2.0 * y * y) + 2.0 * k[3] * x * y;
+    u = K[0] * xd + K[2];
+    v = K[4] * yd + K[5];
+}
+
+//known points in millimeters are projected, the principal point is shifted so that they fall on a pixel center
+static void expectKnownPointsBackProjected(const std::vector<double>& distortion) {
+    const double points[][3] = {{0.0, 0.0, 800.0}, {120.0, -45.0, 1000.0}, {-230.0, 160.0, 950.0},
+                                {310.0, 240.0, 1200.0}, {-400.0, -290.0, 1100.0}};
+    DepthBackProjection backProjection;
+    for (const double* point : points) {
+        double u, v;
+        project(cameraMatrix, distortion, point[0], point[1], point[2], u, v);
+        double K[9];
+        std::copy(cameraMatrix, cameraMatrix + 9, K);
+        K[2] += std::round(u) - u;
+        K[5] += std::round(v) - v;
+        const int column = (int) std::round(u), row = (int) std::round(v);
+        ASSERT_TRUE(column >= 0 && column < width && row >= 0 && row < height);
+        backProjection.setIntrinsics(width, height, K, distortion);
+
+        std::vector<float> depth((size_t) width * height, 0.0f);
+        depth[(size_t) row * width + column] = (float) point[2];
+        std::vector<float> cloud;
+        backProjection.backProject(depth, cloud);
+        const float* backProjected = &cloud[3 * ((size_t) row * width + column)];
+        EXPECT_NEAR(point[0] * 0.001, backProjected[0], 1e-5);
+        EXPECT_NEAR(point[1] * 0.001, backProjected[1], 1e-5);
+        EXPECT_NEAR(point[2] * 0.001, backProjected[2], 1e-6);
+    }
+}
+
+//every pixel is back-projected and projected again onto itself
+static void expectRoundTrip(const std::vector<double>& distortion) {
+    DepthBackProjection backProjection;
+    backProjection.setIntrinsics(width, height, cameraMatrix, distortion);
+    std::vector<float> depth((size_t) width * height);
+    for (size_t i = 0; i < depth.size(); ++i) {
+        depth[i] = 500.0f + (float) (i % 997);
+    }
+    std::vector<float> cloud;
+    backProjection.backProject(depth, cloud, 1.0f);
+    ASSERT_EQ(depth.size() * 3, cloud.size());
+    for (int row = 0; row < height; ++row) {
+        for (int column = 0; column < width; ++column) {
+            const float* point = &cloud[3 * ((size_t) row * width + column)];
+            ASSERT_FLOAT_EQ(depth[(size_t) row * width + column], point[2]);
+            double u, v;
+            project(cameraMatrix, distortion, point[0], point[1], point[2], u, v);
+            EXPECT_NEAR(column, u, 1e-3) << "row " << row;
+            EXPECT_NEAR(row, v, 1e-3) << "column " << column;
+        }
+    }
+}
+
+TEST (DepthBackProjection, pinhole) {
+    expectKnownPointsBackProjected(std::vector<double>());
+    expectRoundTrip(std::vector<double>(5, 0.0));
+}
+
+TEST (DepthBackProjection, plumbBob) {
+    expectKnownPointsBackProjected(plumbBob);
+    expectRoundTrip(plumbBob);
+}
+
+TEST (DepthBackProjection, rationalPolynomial) {
+    expectKnownPointsBackProjected(rationalPolynomial);
+    expectRoundTrip(rationalPolynomial);
+}
+
+TEST (DepthBackProjection, invalidDepth) {
+    DepthBackProjection backProjection;
+    backProjection.setIntrinsics(width, height, cameraMatrix, plumbBob);
+    std::vector<float> depth((size_t) width * height, 1000.0f);
+    depth[0] = 0.0f;
+    depth[width + 7] = 0.0f;
+    depth[depth.size() - 1] = -5.0f;
+    std::vector<float> cloud;
+    backProjection.backProject(depth, cloud);
+    for (size_t i : {(size_t) 0, (size_t) width + 7, depth.size() - 1}) {
+        EXPECT_TRUE(std::isnan(cloud[3 * i]));
+        EXPECT_TRUE(std::isnan(cloud[3 * i + 1]));
+        EXPECT_TRUE(std::isnan(cloud[3 * i + 2]));
+    }
+    EXPECT_FLOAT_EQ(1.0f, cloud[5]);
+
+    //a depth map smaller than the intrinsics is not read
+    backProjection.backProject(std::vector<float>(10, 1000.0f), cloud);
+    EXPECT_EQ((size_t) width * height * 3, cloud.size());
+}
+
+struct CameraInfo {
+    uint32_t width;
+    uint32_t height;
+    std::vector<double> D;
+    std::array<double, 9> K;
+};
+
+TEST (DepthBackProjection, cameraInfo) {
+    CameraInfo cameraInfo;
+    cameraInfo.width = width;
+    cameraInfo.height = height;
+    cameraInfo.D = rationalPolynomial;
+    std::copy(cameraMatrix, cameraMatrix + 9, cameraInfo.K.begin());
+    DepthBackProjection backProjection;
+    backProjection.setCameraInfo(cameraInfo);
+    EXPECT_EQ(width, backProjection.getWidth());
+    EXPECT_EQ(height, backProjection.getHeight());
+
+    DepthBackProjection expected;
+    expected.setIntrinsics(width, height, cameraMatrix, rationalPolynomial);
+    EXPECT_EQ(expected.getRaysX(), backProjection.getRaysX());
+    EXPECT_EQ(expected.getRaysY(), backProjection.getRaysY());
+}
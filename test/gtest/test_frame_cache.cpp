@@ -0,0 +1,124 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/FrameCache.h"
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+using namespace phoxi_camera;
+
+static PFramePostProcessed createFrame(uint64_t frameIndex, int width = 32, int height = 24) {
+    PFramePostProcessed frame(new FramePostProcessed());
+    frame->PFrame = phoxi_camera_test::createSyntheticFrame(width, height, 0.2, frameIndex);
+    return frame;
+}
+
+TEST (FrameCache, leastRecentlyUsedEviction) {
+    FrameCache cache;
+    cache.setLimits(3, 1 << 30);
+    PFramePostProcessed frames[4] = {createFrame(0), createFrame(1), createFrame(2), createFrame(3)};
+    for (int i = 0; i < 3; ++i) {
+        cache.insert(frames[i]);
+    }
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(3 * FrameCache::frameMemory(*frames[0]), cache.memory());
+    //frame 0 becomes the most recently used, frame 1 is evicted instead
+    EXPECT_EQ(frames[0], cache.find(0));
+    cache.insert(frames[3]);
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_FALSE(cache.find(1));
+    EXPECT_EQ(frames[0], cache.find(0));
+    EXPECT_EQ(frames[2], cache.find(2));
+    EXPECT_EQ(frames[3], cache.find(3));
+
+    //a frame with the same index replaces the cached one
+    PFramePostProcessed replacement = createFrame(2);
+    cache.insert(replacement);
+    EXPECT_EQ(3u, cache.size());
+    EXPECT_EQ(replacement, cache.find(2));
+
+    //lower limits evict the least recently used frames immediately
+    cache.setLimits(1, 1 << 30);
+    EXPECT_EQ(1u, cache.size());
+    EXPECT_EQ(replacement, cache.find(2));
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+    EXPECT_EQ(0u, cache.memory());
+}
+
+TEST (FrameCache, memoryLimit) {
+    FrameCache cache;
+    const size_t frameBytes = FrameCache::frameMemory(*createFrame(0));
+    EXPECT_EQ((size_t) 32 * 24 * (3 * sizeof(float) * 2 + 3 * sizeof(float)), frameBytes);
+    cache.setLimits(10, 2 * frameBytes + frameBytes / 2);
+    for (uint64_t i = 0; i < 5; ++i) {
+        cache.insert(createFrame(i));
+        EXPECT_LE(cache.memory(), 2 * frameBytes + frameBytes / 2);
+    }
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_TRUE(cache.find(3));
+    EXPECT_TRUE(cache.find(4));
+
+    //a frame bigger than the memory limit is not cached and does not evict the others
+    cache.insert(createFrame(5, 64, 48));
+    EXPECT_FALSE(cache.find(5));
+    EXPECT_EQ(2u, cache.size());
+    EXPECT_EQ(2 * frameBytes, cache.memory());
+}
+
+TEST (FrameCache, disabled) {
+    FrameCache cache;
+    cache.insert(createFrame(0));
+    EXPECT_EQ(0u, cache.size());
+    cache.setLimits(0, 1 << 30);
+    cache.insert(createFrame(0));
+    EXPECT_FALSE(cache.find(0));
+    cache.insert(PFramePostProcessed());
+    EXPECT_EQ(0u, cache.size());
+}
+
+class CachingPhoXiInterface : public PhoXiInterface {
+public:
+    void cacheFrame(PFramePostProcessed frame) {
+        frameCache.insert(frame);
+    }
+    PFramePostProcessed cachedFrame(uint64_t frameIndex) {
+        return frameCache.find(frameIndex);
+    }
+};
+
+TEST (FrameCache, textureProcessedAgainAfterSettingsChange) {
+    CachingPhoXiInterface phoxiInterface;
+    phoxiInterface.setFrameCacheLimits(4, 1 << 30);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(32, 24, 0.2, 7));
+    phoxiInterface.cacheFrame(frame);
+
+    //cache hits without a connected scanner, the cached frame is reused while the texture settings do not change
+    PFramePostProcessed republished = phoxiInterface.getPFrame(7);
+    EXPECT_NE(frame, republished);
+    EXPECT_EQ(frame->PFrame, republished->PFrame);
+    phoxiInterface.setTextureMinIntensity(phoxiInterface.getTextureMinIntensity());
+    phoxiInterface.getPFrame(7);
+    EXPECT_EQ(frame, phoxiInterface.cachedFrame(7));
+
+    phoxiInterface.setTextureMinIntensity(10.0f);
+    republished = phoxiInterface.getPFrame(7);
+    PFramePostProcessed reprocessed = phoxiInterface.cachedFrame(7);
+    EXPECT_NE(frame, reprocessed);
+    EXPECT_EQ(frame->PFrame, reprocessed->PFrame);
+    EXPECT_EQ(reprocessed->TextureSettingsVersion, republished->TextureSettingsVersion);
+    EXPECT_NE(frame->TextureSettingsVersion, reprocessed->TextureSettingsVersion);
+    phoxiInterface.getPFrame(7);
+    EXPECT_EQ(reprocessed, phoxiInterface.cachedFrame(7));
+
+    phoxiInterface.setTextureContrastLimitedAdaptiveHistogramEqualizationClipLimit(2.0);
+    phoxiInterface.getPFrame(7);
+    EXPECT_NE(reprocessed, phoxiInterface.cachedFrame(7));
+    reprocessed = phoxiInterface.cachedFrame(7);
+
+    phoxiInterface.setTextureRectification(true);
+    phoxiInterface.getPFrame(7);
+    EXPECT_NE(reprocessed, phoxiInterface.cachedFrame(7));
+}
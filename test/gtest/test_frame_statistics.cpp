@@ -0,0 +1,103 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/FrameStatistics.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <cmath>
+
+using namespace phoxi_camera;
+
+//upper bound of the histogram bucket of latency, buckets grow by 2^(1/4)
+static void expectInBucketOf(double latency, double percentile) {
+    EXPECT_GE(percentile, latency);
+    EXPECT_LE(percentile, latency * std::pow(2.0, 0.25));
+}
+
+TEST (FrameStatistics, latencyPercentiles) {
+    FrameStatistics statistics;
+    for (int i = 0; i < 50; ++i) {
+        statistics.framePublished(0.010);
+    }
+    for (int i = 0; i < 40; ++i) {
+        statistics.framePublished(0.020);
+    }
+    for (int i = 0; i < 9; ++i) {
+        statistics.framePublished(0.100);
+    }
+    statistics.framePublished(0.500);
+
+    FrameStatistics::Snapshot snapshot = statistics.snapshot();
+    EXPECT_EQ(100u, snapshot.framesPublished);
+    EXPECT_EQ(100u, snapshot.latencySamples);
+    expectInBucketOf(0.010, snapshot.latencyP50);
+    expectInBucketOf(0.020, snapshot.latencyP90);
+    expectInBucketOf(0.100, snapshot.latencyP99);
+    EXPECT_NEAR(0.500, snapshot.latencyMax, 1e-6);
+
+    //the histogram and the maximum cover the period since the previous snapshot, the counters are cumulative
+    statistics.framePublished(0.040);
+    snapshot = statistics.snapshot();
+    EXPECT_EQ(101u, snapshot.framesPublished);
+    EXPECT_EQ(1u, snapshot.latencySamples);
+    EXPECT_NEAR(0.040, snapshot.latencyMax, 1e-6);
+    snapshot = statistics.snapshot();
+    EXPECT_EQ(0u, snapshot.latencySamples);
+    EXPECT_EQ(0.0, snapshot.latencyP50);
+    EXPECT_EQ(0.0, snapshot.latencyP99);
+    EXPECT_EQ(0.0, snapshot.latencyMax);
+}
+
+TEST (FrameStatistics, percentilesClampedToMaximum) {
+    FrameStatistics statistics;
+    //the upper bound of the bucket of 10.5 ms is above all the measured latencies
+    for (int i = 0; i < 10; ++i) {
+        statistics.framePublished(0.0100 + i * 0.0001);
+    }
+    FrameStatistics::Snapshot snapshot = statistics.snapshot();
+    EXPECT_NEAR(0.0109, snapshot.latencyMax, 1e-6);
+    EXPECT_LE(snapshot.latencyP50, snapshot.latencyMax);
+    EXPECT_DOUBLE_EQ(snapshot.latencyMax, snapshot.latencyP99);
+
+    //latencies below the first bucket are reported as the first bucket bound
+    statistics.framePublished(0.0002);
+    snapshot = statistics.snapshot();
+    EXPECT_DOUBLE_EQ(0.001, snapshot.latencyP50);
+}
+
+TEST (FrameStatistics, frameIndexGaps) {
+    FrameStatistics statistics;
+    for (uint64_t frameIndex : {0, 1, 2, 5, 6, 10}) {
+        statistics.frameReceived(*phoxi_camera_test::createSyntheticFrame(32, 24, 0.0, frameIndex));
+    }
+    FrameStatistics::Snapshot snapshot = statistics.snapshot();
+    EXPECT_EQ(6u, snapshot.framesReceived);
+    EXPECT_EQ(5u, snapshot.frameIndexGaps);
+
+    //a lower index, from the frame cache or a reconnected scanner, restarts the sequence without a gap, then 5 is missing
+    for (uint64_t frameIndex : {3, 4, 4, 6}) {
+        statistics.frameReceived(*phoxi_camera_test::createSyntheticFrame(32, 24, 0.0, frameIndex));
+    }
+    snapshot = statistics.snapshot();
+    EXPECT_EQ(10u, snapshot.framesReceived);
+    EXPECT_EQ(6u, snapshot.frameIndexGaps);
+    EXPECT_DOUBLE_EQ(1.0, snapshot.validPointsRatio);
+}
+
+TEST (FrameStatistics, droppedFramesAndOutputs) {
+    FrameStatistics statistics;
+    statistics.frameDropped();
+    statistics.frameDropped();
+    statistics.outputPublished(OutputChannel::PointCloud, 1000);
+    statistics.outputPublished(OutputChannel::PointCloud, 500);
+    statistics.outputPublished(OutputChannel::Mesh, 20);
+    FrameStatistics::Snapshot snapshot = statistics.snapshot();
+    EXPECT_EQ(2u, snapshot.framesDropped);
+    EXPECT_EQ(2u, snapshot.messages[(int) OutputChannel::PointCloud]);
+    EXPECT_EQ(1500u, snapshot.bytes[(int) OutputChannel::PointCloud]);
+    EXPECT_EQ(1u, snapshot.messages[(int) OutputChannel::Mesh]);
+    EXPECT_EQ(0u, snapshot.messages[(int) OutputChannel::Texture]);
+    EXPECT_EQ(0, snapshot.lastPublishTime);
+}
@@ -0,0 +1,88 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+//maximum height and number of the points in each cell, projected directly from the point cloud
+static void projectHeightMap(const pho::api::Frame& frame, const HeightMap& geometry, const Eigen::Affine3f& transform,
+                             std::vector<float>& heights, std::vector<uint32_t>& counts) {
+    heights.assign((size_t) geometry.width * geometry.height, -std::numeric_limits<float>::infinity());
+    counts.assign(heights.size(), 0);
+    //same arithmetic as getHeightMapFromFrame, so that points on the cell borders fall into the same cells
+    const Eigen::Matrix3f rotationAndScale = transform.linear() * 0.001f;
+    const Eigen::Vector3f translation = transform.translation() - Eigen::Vector3f(geometry.originX, geometry.originY, 0.0f);
+    const float cellsPerMeter = 1.0f / geometry.resolution;
+    for (int r = 0; r < frame.PointCloud.Size.Height; ++r) {
+        for (int c = 0; c < frame.PointCloud.Size.Width; ++c) {
+            const pho::api::Point3_32f& p = frame.PointCloud[r][c];
+            if (p.x == 0.0f && p.y == 0.0f && p.z == 0.0f) {
+                continue;
+            }
+            const Eigen::Vector3f point = rotationAndScale * Eigen::Vector3f(p.x, p.y, p.z) + translation;
+            const float column = std::floor(point.x() * cellsPerMeter);
+            const float row = std::floor(point.y() * cellsPerMeter);
+            if (column < 0.0f || row < 0.0f || column >= geometry.width || row >= geometry.height) {
+                continue;
+            }
+            const size_t cell = (size_t) row * geometry.width + (size_t) column;
+            heights[cell] = std::max(heights[cell], point.z());
+            ++counts[cell];
+        }
+    }
+}
+
+TEST (HeightMap, matchesDirectProjection) {
+    //z up, the scanner looks down from 1.2 m
+    Eigen::Affine3f transform = Eigen::Affine3f::Identity();
+    transform.translate(Eigen::Vector3f(0.0f, 0.0f, 1.2f));
+    transform.rotate(Eigen::AngleAxisf((float) M_PI, Eigen::Vector3f::UnitX()));
+    for (int threads : {1, 3, 8}) {
+        PhoXiInterface phoxiInterface;
+        phoxiInterface.setWorkerThreads(threads);
+        PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(320, 240, 0.2, 0, 3));
+        //grids with fewer rows than threads and with partial bands too
+        for (int gridHeight : {1, 2, 7, 101}) {
+            HeightMap heightMap;
+            heightMap.resolution = 0.008f;
+            heightMap.originX = -0.3f;
+            heightMap.originY = -0.25f;
+            heightMap.width = 75;
+            heightMap.height = gridHeight;
+            heightMap.minPoints = 2;
+            phoxiInterface.getHeightMapFromFrame(frame, heightMap, transform);
+            std::vector<float> heights;
+            std::vector<uint32_t> counts;
+            projectHeightMap(*frame->PFrame, heightMap, transform, heights, counts);
+            ASSERT_EQ(heights.size(), heightMap.heights.size());
+            ASSERT_EQ(counts, heightMap.counts);
+            uint32_t filledCells = 0;
+            for (size_t cell = 0; cell < heights.size(); ++cell) {
+                if (counts[cell] < 2) {
+                    ASSERT_TRUE(std::isnan(heightMap.heights[cell]));
+                } else {
+                    ASSERT_EQ(heights[cell], heightMap.heights[cell]);
+                    ++filledCells;
+                }
+            }
+            EXPECT_GT(filledCells, 0u);
+        }
+    }
+}
+
+TEST (HeightMap, emptyGrid) {
+    PhoXiInterface phoxiInterface;
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(64, 48));
+    HeightMap heightMap;
+    heightMap.width = 0;
+    heightMap.height = 10;
+    phoxiInterface.getHeightMapFromFrame(frame, heightMap);
+    EXPECT_TRUE(heightMap.heights.empty());
+    EXPECT_TRUE(heightMap.counts.empty());
+}
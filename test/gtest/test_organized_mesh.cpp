@@ -0,0 +1,72 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <cstdint>
+#include <vector>
+
+//quads of the decimated grid with 4 valid corners, counted directly on the point cloud
+static uint32_t countValidQuads(const pho::api::Frame& frame, int step, uint32_t& validPoints) {
+    const int width = (frame.PointCloud.Size.Width + step - 1) / step;
+    const int height = (frame.PointCloud.Size.Height + step - 1) / step;
+    std::vector<uint8_t> valid((size_t) width * height);
+    validPoints = 0;
+    for (int i = 0; i < height; ++i) {
+        for (int j = 0; j < width; ++j) {
+            const pho::api::Point3_32f& point = frame.PointCloud[i * step][j * step];
+            valid[i * width + j] = point.x != 0.0f || point.y != 0.0f || point.z != 0.0f;
+            validPoints += valid[i * width + j];
+        }
+    }
+    uint32_t quads = 0;
+    for (int i = 0; i + 1 < height; ++i) {
+        for (int j = 0; j + 1 < width; ++j) {
+            quads += valid[i * width + j] && valid[i * width + j + 1] && valid[(i + 1) * width + j] && valid[(i + 1) * width + j + 1];
+        }
+    }
+    return quads;
+}
+
+TEST (OrganizedMesh, triangleCountsWithHoles) {
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setWorkerThreads(4);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(257, 193, 0.3, 0, 1));
+    OrganizedMesh mesh;
+    for (int step : {1, 2, 3}) {
+        uint32_t validPoints;
+        const uint32_t quads = countValidQuads(*frame->PFrame, step, validPoints);
+        ASSERT_GT(quads, 0u);
+        phoxiInterface.getMeshFromFrame(frame, mesh, 0.0f, step);
+        EXPECT_EQ(step, mesh.step);
+        EXPECT_EQ((257 + step - 1) / step, mesh.width);
+        EXPECT_EQ((193 + step - 1) / step, mesh.height);
+        EXPECT_EQ(validPoints * 3, mesh.vertices.size());
+        EXPECT_EQ(quads * 2 * 3, mesh.triangles.size());
+        for (uint32_t index : mesh.triangles) {
+            ASSERT_LT(index, validPoints);
+        }
+    }
+
+    //the edges between neighbouring points are a few millimeters long
+    phoxiInterface.getMeshFromFrame(frame, mesh, 0.0001f);
+    EXPECT_FALSE(mesh.vertices.empty());
+    EXPECT_TRUE(mesh.triangles.empty());
+}
+
+TEST (OrganizedMesh, independentOfThreadCount) {
+    PFramePostProcessed frames[2];
+    OrganizedMesh meshes[2];
+    for (int t = 0; t < 2; ++t) {
+        PhoXiInterface phoxiInterface;
+        phoxiInterface.setWorkerThreads(t == 0 ? 1 : 4);
+        frames[t] = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(257, 193, 0.3, 0, 2));
+        phoxiInterface.getMeshFromFrame(frames[t], meshes[t], 0.01f);
+    }
+    EXPECT_FALSE(meshes[0].triangles.empty());
+    EXPECT_EQ(meshes[0].vertices, meshes[1].vertices);
+    EXPECT_EQ(meshes[0].triangles, meshes[1].triangles);
+}
@@ -386,6 +386,25 @@ TEST_F (PhoXiInterfaceTest, getPFrame) {
     ASSERT_THROW(phoxi_interface.getPFrame(-1), PhoXiScannerNotConnected);
 }
 
+TEST_F (PhoXiInterfaceTest, getPFrameCacheAfterReconnect) {
+    phoxi_interface.setFrameCacheLimits(16, 1024ull * 1024 * 1024);
+    PFramePostProcessed frame = phoxi_interface.getPFrame(-1);
+    ASSERT_NE(nullptr, frame);
+    const int frameID = (int) frame->PFrame->Info.FrameIndex;
+    // cached frame is served while connected
+    ASSERT_EQ(frame->PFrame, phoxi_interface.getPFrame(frameID)->PFrame);
+
+    // frame of the previous session is not served from the cache
+    phoxi_interface.disconnectCamera();
+    ASSERT_THROW(phoxi_interface.getPFrame(frameID), PhoXiScannerNotConnected);
+
+    // frame indices restart after reconnect, the reused id must come from the scanner
+    phoxi_interface.connectCamera(camera_ID);
+    PFramePostProcessed reconnectedFrame = phoxi_interface.getPFrame(frameID);
+    ASSERT_TRUE(reconnectedFrame == nullptr || reconnectedFrame->PFrame != frame->PFrame);
+    phoxi_interface.setFrameCacheLimits(0, 0);
+}
+
 TEST_F (PhoXiInterfaceTest, getPointCloudFromFrame) {
     ASSERT_THROW(phoxi_interface.getPointCloudFromFrame(nullptr), CorruptedFrame);
 
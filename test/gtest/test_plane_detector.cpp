@@ -0,0 +1,109 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PlaneDetector.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace phoxi_camera;
+
+//plane 0.2x - 0.1y - z + 1 = 0 seen from the origin, with uniform outliers above it
+static std::vector<Eigen::Vector3f> createPlanePoints(int planePoints, int outliers, unsigned int seed, Eigen::Vector4f& plane) {
+    const Eigen::Vector3f normal = Eigen::Vector3f(0.2f, -0.1f, -1.0f).normalized();
+    const float offset = 1.0f / Eigen::Vector3f(0.2f, -0.1f, -1.0f).norm();
+    plane = Eigen::Vector4f(normal.x(), normal.y(), normal.z(), offset);
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> coordinate(-0.4f, 0.4f);
+    std::normal_distribution<float> noise(0.0f, 0.0005f);
+    std::vector<Eigen::Vector3f> points;
+    for (int i = 0; i < planePoints; ++i) {
+        const float x = coordinate(generator), y = coordinate(generator);
+        points.push_back(Eigen::Vector3f(x, y, 0.2f * x - 0.1f * y + 1.0f + noise(generator)));
+    }
+    std::uniform_real_distribution<float> depth(0.5f, 0.9f);
+    for (int i = 0; i < outliers; ++i) {
+        points.push_back(Eigen::Vector3f(coordinate(generator), coordinate(generator), depth(generator)));
+    }
+    return points;
+}
+
+TEST (PlaneDetector, planeWithOutliers) {
+    Eigen::Vector4f expected;
+    const std::vector<Eigen::Vector3f> points = createPlanePoints(6000, 4000, 1, expected);
+    ThreadPool threadPool;
+    threadPool.start(2);
+    PlaneDetector detector;
+    detector.setParameters(0.005f, 200, 0.2f, 0.9f);
+
+    ASSERT_TRUE(detector.detect(points, threadPool));
+    ASSERT_TRUE(detector.hasPlane());
+    EXPECT_FALSE(detector.isPriorReused());
+    const Eigen::Vector4f plane = detector.getPlane();
+    EXPECT_NEAR(1.0f, plane.head<3>().norm(), 1e-4f);
+    //the normal points to the origin of the points, so d > 0
+    EXPECT_GT(plane[3], 0.0f);
+    EXPECT_GT(plane.head<3>().dot(expected.head<3>()), 0.9999f);
+    EXPECT_NEAR(expected[3], plane[3], 0.002f);
+    //all the plane points and a few outliers close to it are inliers
+    EXPECT_NEAR(0.6f, detector.getInlierRatio(), 0.02f);
+}
+
+TEST (PlaneDetector, priorReused) {
+    Eigen::Vector4f expected;
+    ThreadPool threadPool;
+    threadPool.start(2);
+    PlaneDetector detector;
+    detector.setParameters(0.005f, 200, 0.2f, 0.9f);
+    ASSERT_TRUE(detector.detect(createPlanePoints(6000, 4000, 1, expected), threadPool));
+    EXPECT_FALSE(detector.isPriorReused());
+
+    //same plane in the next frame, the prior is only refined
+    ASSERT_TRUE(detector.detect(createPlanePoints(6000, 4000, 2, expected), threadPool));
+    EXPECT_TRUE(detector.isPriorReused());
+    EXPECT_GT(detector.getPlane().head<3>().dot(expected.head<3>()), 0.9999f);
+
+    //the plane moved away, RANSAC runs again
+    std::vector<Eigen::Vector3f> moved = createPlanePoints(6000, 4000, 3, expected);
+    for (Eigen::Vector3f& point : moved) {
+        point.z() += 0.1f;
+    }
+    ASSERT_TRUE(detector.detect(moved, threadPool));
+    EXPECT_FALSE(detector.isPriorReused());
+    EXPECT_NEAR(expected[3] + 0.1f * std::abs(expected[2]), detector.getPlane()[3], 0.002f);
+
+    //reset drops the prior
+    detector.reset();
+    EXPECT_FALSE(detector.hasPlane());
+    ASSERT_TRUE(detector.detect(moved, threadPool));
+    EXPECT_FALSE(detector.isPriorReused());
+}
+
+TEST (PlaneDetector, noPlane) {
+    ThreadPool threadPool;
+    threadPool.start(1);
+    PlaneDetector detector;
+    detector.setParameters(0.001f, 100, 0.5f, 0.9f);
+    Eigen::Vector4f expected;
+    //outliers only, no plane holds half of them
+    EXPECT_FALSE(detector.detect(createPlanePoints(0, 2000, 4, expected), threadPool));
+    EXPECT_FALSE(detector.hasPlane());
+    EXPECT_FALSE(detector.detect(std::vector<Eigen::Vector3f>(2, Eigen::Vector3f::UnitZ()), threadPool));
+}
+
+TEST (PlaneDetector, independentOfThreadCount) {
+    Eigen::Vector4f expected;
+    const std::vector<Eigen::Vector3f> points = createPlanePoints(3000, 3000, 5, expected);
+    Eigen::Vector4f planes[2];
+    for (int t = 0; t < 2; ++t) {
+        ThreadPool threadPool;
+        threadPool.start(t == 0 ? 1 : 4);
+        PlaneDetector detector;
+        ASSERT_TRUE(detector.detect(points, threadPool));
+        planes[t] = detector.getPlane();
+    }
+    EXPECT_LT((planes[0] - planes[1]).norm(), 1e-4f);
+}
@@ -0,0 +1,185 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PointCloudBandAssembler.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace phoxi_camera;
+
+static const uint32_t width = 5;
+static const uint32_t height = 12;
+static const uint32_t pointStep = 4;
+
+//organized cloud of one uint32 field, each byte of a point identifies the frame and the point
+static sensor_msgs::PointCloud2 createCloud(uint64_t frameIndex) {
+    sensor_msgs::PointCloud2 cloud;
+    cloud.header.frame_id = "PhoXi3Dscanner_sensor";
+    cloud.fields.resize(1);
+    cloud.fields[0].name = "rgb";
+    cloud.fields[0].offset = 0;
+    cloud.fields[0].count = 1;
+    cloud.width = width;
+    cloud.height = height;
+    cloud.point_step = pointStep;
+    cloud.row_step = width * pointStep;
+    cloud.data.resize((size_t) cloud.row_step * height);
+    for (size_t i = 0; i < cloud.data.size(); ++i) {
+        cloud.data[i] = (uint8_t) (frameIndex * 31 + i);
+    }
+    return cloud;
+}
+
+//bands of rows rows, the last one is shorter when rows does not divide the height
+static std::vector<PointCloudBand> createBands(const sensor_msgs::PointCloud2& cloud, uint64_t frameIndex, uint32_t rows) {
+    const uint32_t bandCount = (cloud.height + rows - 1) / rows;
+    std::vector<PointCloudBand> bands(bandCount);
+    for (uint32_t i = 0; i < bandCount; ++i) {
+        PointCloudBand& band = bands[i];
+        band.frame_index = frameIndex;
+        band.band_index = i;
+        band.band_count = bandCount;
+        band.row_offset = i * rows;
+        band.frame_height = cloud.height;
+        band.cloud.header = cloud.header;
+        band.cloud.fields = cloud.fields;
+        band.cloud.width = cloud.width;
+        band.cloud.height = std::min(rows, cloud.height - band.row_offset);
+        band.cloud.point_step = cloud.point_step;
+        band.cloud.row_step = cloud.row_step;
+        band.cloud.data.assign(cloud.data.begin() + (size_t) band.row_offset * cloud.row_step,
+                               cloud.data.begin() + (size_t) (band.row_offset + band.cloud.height) * cloud.row_step);
+    }
+    return bands;
+}
+
+static void expectCloud(const sensor_msgs::PointCloud2& expected, const sensor_msgs::PointCloud2& cloud) {
+    EXPECT_EQ(expected.header.frame_id, cloud.header.frame_id);
+    ASSERT_EQ(1u, cloud.fields.size());
+    EXPECT_EQ(expected.fields[0].name, cloud.fields[0].name);
+    EXPECT_EQ(expected.width, cloud.width);
+    EXPECT_EQ(expected.height, cloud.height);
+    EXPECT_EQ(expected.point_step, cloud.point_step);
+    EXPECT_EQ(expected.row_step, cloud.row_step);
+    EXPECT_FALSE(cloud.is_dense);
+    EXPECT_EQ(expected.data, cloud.data);
+}
+
+TEST (PointCloudBandAssembler, outOfOrderBands) {
+    const sensor_msgs::PointCloud2 expected = createCloud(3);
+    std::vector<PointCloudBand> bands = createBands(expected, 3, 5);
+    ASSERT_EQ(3u, bands.size());
+    PointCloudBandAssembler assembler;
+    sensor_msgs::PointCloud2 cloud;
+    EXPECT_FALSE(assembler.addBand(bands[2], cloud));
+    EXPECT_FALSE(assembler.addBand(bands[0], cloud));
+    EXPECT_EQ(1u, assembler.pendingFramesCount());
+    EXPECT_TRUE(cloud.data.empty());
+    EXPECT_TRUE(assembler.addBand(bands[1], cloud));
+    expectCloud(expected, cloud);
+    EXPECT_EQ(0u, assembler.pendingFramesCount());
+}
+
+TEST (PointCloudBandAssembler, interleavedFrames) {
+    const sensor_msgs::PointCloud2 first = createCloud(1), second = createCloud(2);
+    std::vector<PointCloudBand> firstBands = createBands(first, 1, 4), secondBands = createBands(second, 2, 4);
+    PointCloudBandAssembler assembler;
+    sensor_msgs::PointCloud2 cloud;
+    EXPECT_FALSE(assembler.addBand(firstBands[0], cloud));
+    EXPECT_FALSE(assembler.addBand(secondBands[1], cloud));
+    EXPECT_FALSE(assembler.addBand(secondBands[0], cloud));
+    EXPECT_FALSE(assembler.addBand(firstBands[2], cloud));
+    EXPECT_EQ(2u, assembler.pendingFramesCount());
+    EXPECT_TRUE(assembler.addBand(secondBands[2], cloud));
+    expectCloud(second, cloud);
+    EXPECT_TRUE(assembler.addBand(firstBands[1], cloud));
+    expectCloud(first, cloud);
+}
+
+TEST (PointCloudBandAssembler, duplicateBands) {
+    const sensor_msgs::PointCloud2 expected = createCloud(4);
+    std::vector<PointCloudBand> bands = createBands(expected, 4, 6);
+    PointCloudBandAssembler assembler;
+    sensor_msgs::PointCloud2 cloud;
+    EXPECT_FALSE(assembler.addBand(bands[0], cloud));
+    //a duplicate neither completes the frame nor overwrites the received rows
+    PointCloudBand duplicate = bands[0];
+    std::fill(duplicate.cloud.data.begin(), duplicate.cloud.data.end(), 0);
+    EXPECT_FALSE(assembler.addBand(duplicate, cloud));
+    EXPECT_FALSE(assembler.addBand(bands[0], cloud));
+    EXPECT_TRUE(assembler.addBand(bands[1], cloud));
+    expectCloud(expected, cloud);
+
+    //a band of a completed frame starts a new frame
+    EXPECT_FALSE(assembler.addBand(bands[1], cloud));
+    EXPECT_EQ(1u, assembler.pendingFramesCount());
+    assembler.clear();
+    EXPECT_EQ(0u, assembler.pendingFramesCount());
+}
+
+TEST (PointCloudBandAssembler, maxPendingFramesDrop) {
+    std::vector<std::vector<PointCloudBand> > frames;
+    for (uint64_t frameIndex = 0; frameIndex < 4; ++frameIndex) {
+        frames.push_back(createBands(createCloud(frameIndex), frameIndex, 4));
+    }
+    PointCloudBandAssembler assembler(2);
+    sensor_msgs::PointCloud2 cloud;
+    for (uint64_t frameIndex = 0; frameIndex < 3; ++frameIndex) {
+        EXPECT_FALSE(assembler.addBand(frames[frameIndex][0], cloud));
+        EXPECT_FALSE(assembler.addBand(frames[frameIndex][1], cloud));
+    }
+    //frame 0, the oldest, was dropped when frame 2 started, its last band starts it again
+    EXPECT_EQ(2u, assembler.pendingFramesCount());
+    EXPECT_FALSE(assembler.addBand(frames[0][2], cloud));
+    EXPECT_EQ(2u, assembler.pendingFramesCount());
+    EXPECT_TRUE(assembler.addBand(frames[1][2], cloud));
+    expectCloud(createCloud(1), cloud);
+    EXPECT_TRUE(assembler.addBand(frames[2][2], cloud));
+    expectCloud(createCloud(2), cloud);
+
+    //the band of a frame older than all the pending ones is dropped right away
+    PointCloudBandAssembler singleFrameAssembler(1);
+    EXPECT_FALSE(singleFrameAssembler.addBand(frames[3][0], cloud));
+    EXPECT_FALSE(singleFrameAssembler.addBand(frames[1][0], cloud));
+    EXPECT_EQ(1u, singleFrameAssembler.pendingFramesCount());
+    EXPECT_FALSE(singleFrameAssembler.addBand(frames[3][1], cloud));
+    EXPECT_TRUE(singleFrameAssembler.addBand(frames[3][2], cloud));
+    expectCloud(createCloud(3), cloud);
+}
+
+TEST (PointCloudBandAssembler, rowStepMismatch) {
+    const sensor_msgs::PointCloud2 expected = createCloud(5);
+    std::vector<PointCloudBand> bands = createBands(expected, 5, 4);
+    PointCloudBandAssembler assembler;
+    sensor_msgs::PointCloud2 cloud;
+    EXPECT_FALSE(assembler.addBand(bands[0], cloud));
+
+    //a band of another point layout does not fit the rows of the frame
+    PointCloudBand mismatched = bands[1];
+    mismatched.cloud.point_step = 2 * pointStep;
+    mismatched.cloud.row_step = width * mismatched.cloud.point_step;
+    mismatched.cloud.data.resize((size_t) mismatched.cloud.row_step * mismatched.cloud.height);
+    EXPECT_FALSE(assembler.addBand(mismatched, cloud));
+    PointCloudBand otherBandCount = bands[1];
+    otherBandCount.band_count = 4;
+    EXPECT_FALSE(assembler.addBand(otherBandCount, cloud));
+
+    //nor are bands with less data than their rows or outside of the frame accepted
+    PointCloudBand truncated = bands[1];
+    truncated.cloud.data.pop_back();
+    EXPECT_FALSE(assembler.addBand(truncated, cloud));
+    PointCloudBand outside = bands[2];
+    outside.row_offset = height - 1;
+    EXPECT_FALSE(assembler.addBand(outside, cloud));
+    PointCloudBand invalidIndex = bands[2];
+    invalidIndex.band_index = invalidIndex.band_count;
+    EXPECT_FALSE(assembler.addBand(invalidIndex, cloud));
+    EXPECT_EQ(1u, assembler.pendingFramesCount());
+
+    EXPECT_FALSE(assembler.addBand(bands[1], cloud));
+    EXPECT_TRUE(assembler.addBand(bands[2], cloud));
+    expectCloud(expected, cloud);
+}
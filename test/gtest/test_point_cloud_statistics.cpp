@@ -0,0 +1,55 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+static void expectSameStatistics(const PointCloudStatistics& expected, const PointCloudStatistics& statistics) {
+    EXPECT_EQ(expected.totalPoints, statistics.totalPoints);
+    EXPECT_EQ(expected.validPoints, statistics.validPoints);
+    EXPECT_TRUE(expected.boundingBoxMin.isApprox(statistics.boundingBoxMin));
+    EXPECT_TRUE(expected.boundingBoxMax.isApprox(statistics.boundingBoxMax));
+    EXPECT_FLOAT_EQ(expected.depthMin, statistics.depthMin);
+    EXPECT_FLOAT_EQ(expected.depthMax, statistics.depthMax);
+    EXPECT_NEAR(expected.depthSum, statistics.depthSum, 1e-6 * expected.depthSum);
+    EXPECT_NEAR(expected.confidenceSum, statistics.confidenceSum, 1e-6 * expected.confidenceSum);
+    EXPECT_EQ(expected.confidencePoints, statistics.confidencePoints);
+    for (int i = 0; i < PointCloudStatistics::TextureHistogramBins; ++i) {
+        EXPECT_EQ(expected.textureHistogram[i], statistics.textureHistogram[i]);
+    }
+}
+
+TEST (PointCloudStatistics, sameAsConversion) {
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setWorkerThreads(4);
+    phoxiInterface.setPointCloudMinConfidence(2.0f);
+    phoxiInterface.setPointCloudJumpEdgeMaxDepthRatio(1.05f);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(320, 240, 0.2, 0, 4));
+
+    PointCloudStatistics expected;
+    phoxiInterface.getPointCloudFromFrame<pcl::PointXYZ>(frame, Eigen::Affine3f::Identity(), &expected);
+    ASSERT_GT(expected.validPoints, 0u);
+    ASSERT_LT(expected.validPoints, expected.totalPoints);
+    PointCloudStatistics statistics;
+    phoxiInterface.getPointCloudStatisticsFromFrame(frame, statistics);
+    expectSameStatistics(expected, statistics);
+
+    //plane points are not counted either, the plane is close to the floor of the synthetic scene
+    const uint64_t validPoints = expected.validPoints;
+    const Eigen::Vector3f normal = Eigen::Vector3f(0.0f, -0.15f, -0.99f).normalized();
+    ScopedPointCloudPlaneRemoval planeRemoval(phoxiInterface, true, Eigen::Vector4f(normal.x(), normal.y(), normal.z(), 1.1f), 0.05f);
+    expected.reset();
+    phoxiInterface.getPointCloudFromFrame<pcl::PointXYZ>(frame, Eigen::Affine3f::Identity(), &expected);
+    statistics.reset();
+    phoxiInterface.getPointCloudStatisticsFromFrame(frame, statistics);
+    EXPECT_LT(expected.validPoints, validPoints);
+    expectSameStatistics(expected, statistics);
+}
+
+TEST (PointCloudStatistics, corruptedFrame) {
+    PhoXiInterface phoxiInterface;
+    PointCloudStatistics statistics;
+    EXPECT_THROW(phoxiInterface.getPointCloudStatisticsFromFrame(PFramePostProcessed(), statistics), CorruptedFrame);
+}
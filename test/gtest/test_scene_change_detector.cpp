@@ -0,0 +1,106 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/SceneChangeDetector.h"
+#include "../benchmark/synthetic_frame.h"
+
+using namespace phoxi_camera;
+
+//moves the valid points of the rows [rowBegin, rowEnd) away from the scanner by offset mm
+static pho::api::PFrame createShiftedFrame(int rowBegin, int rowEnd, float offset) {
+    pho::api::PFrame frame = phoxi_camera_test::createSyntheticFrame(160, 120, 0.2, 0, 1);
+    for (int r = rowBegin; r < rowEnd; ++r) {
+        for (int c = 0; c < frame->DepthMap.Size.Width; ++c) {
+            if (frame->DepthMap[r][c] > 0.0f) {
+                frame->DepthMap[r][c] += offset;
+                frame->PointCloud[r][c].z += offset;
+            }
+        }
+    }
+    return frame;
+}
+
+TEST (SceneChangeDetector, changedAndUnchanged) {
+    SceneChangeDetector detector;
+    detector.setParameters(2, 5.0f, 0.05f, 0);
+    //the first frame has no reference
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+    EXPECT_FLOAT_EQ(1.0f, detector.getChangedRatio());
+
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+    EXPECT_FLOAT_EQ(0.0f, detector.getChangedRatio());
+    EXPECT_EQ(1u, detector.getUnchangedFrames());
+    //changes below the depth threshold or on too few samples are not reported
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 120, 4.0f)));
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 4, 20.0f)));
+    EXPECT_GT(detector.getChangedRatio(), 0.0f);
+    EXPECT_LE(detector.getChangedRatio(), 0.05f);
+    EXPECT_EQ(3u, detector.getUnchangedFrames());
+
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 60, 20.0f)));
+    EXPECT_NEAR(0.4f, detector.getChangedRatio(), 0.1f);
+    EXPECT_EQ(0u, detector.getUnchangedFrames());
+    //the changed frame is the new reference
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 60, 20.0f)));
+}
+
+TEST (SceneChangeDetector, maxUnchangedFrames) {
+    SceneChangeDetector detector;
+    detector.setParameters(4, 5.0f, 0.01f, 3);
+    pho::api::PFrame frame = createShiftedFrame(0, 0, 0.0f);
+    EXPECT_TRUE(detector.update(*frame));
+    for (int heartbeat = 0; heartbeat < 2; ++heartbeat) {
+        for (uint32_t i = 1; i <= 3; ++i) {
+            EXPECT_FALSE(detector.update(*frame));
+            EXPECT_EQ(i, detector.getUnchangedFrames());
+        }
+        //a static scene is reported every maxUnchangedFrames + 1 frames
+        EXPECT_TRUE(detector.update(*frame));
+        EXPECT_FLOAT_EQ(0.0f, detector.getChangedRatio());
+        EXPECT_EQ(0u, detector.getUnchangedFrames());
+    }
+}
+
+TEST (SceneChangeDetector, slowDriftAccumulated) {
+    SceneChangeDetector detector;
+    detector.setParameters(2, 5.0f, 0.05f, 0);
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+    //2 mm per frame, the unchanged frames do not replace the reference
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 120, 2.0f)));
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 120, 4.0f)));
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 120, 6.0f)));
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 120, 8.0f)));
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 120, 10.0f)));
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 120, 12.0f)));
+}
+
+TEST (SceneChangeDetector, resolutionChangeAndReset) {
+    SceneChangeDetector detector;
+    detector.setParameters(2, 5.0f, 0.05f, 0);
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+    EXPECT_FALSE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+
+    pho::api::PFrame otherResolution = phoxi_camera_test::createSyntheticFrame(80, 60, 0.2, 0, 1);
+    EXPECT_TRUE(detector.update(*otherResolution));
+    EXPECT_FLOAT_EQ(1.0f, detector.getChangedRatio());
+    EXPECT_FALSE(detector.update(*otherResolution));
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+
+    detector.reset();
+    EXPECT_EQ(0u, detector.getUnchangedFrames());
+    EXPECT_TRUE(detector.update(*createShiftedFrame(0, 0, 0.0f)));
+}
+
+TEST (SceneChangeDetector, depthFromPointCloud) {
+    SceneChangeDetector detector;
+    detector.setParameters(2, 5.0f, 0.05f, 0);
+    pho::api::PFrame frame = createShiftedFrame(0, 0, 0.0f);
+    frame->DepthMap = pho::api::DepthMap32f();
+    pho::api::PFrame shifted = createShiftedFrame(0, 60, 20.0f);
+    shifted->DepthMap = pho::api::DepthMap32f();
+    EXPECT_TRUE(detector.update(*frame));
+    EXPECT_FALSE(detector.update(*frame));
+    EXPECT_TRUE(detector.update(*shifted));
+}
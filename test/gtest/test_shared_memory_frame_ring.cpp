@@ -0,0 +1,155 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/SharedMemoryFrameWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace phoxi_camera;
+
+//point cloud and texture filled with the frame index, the other maps are not sent
+static pho::api::Frame createFrame(int width, int height, uint64_t frameIndex) {
+    pho::api::Frame frame;
+    pho::api::PhoXiSize size(width, height);
+    frame.PointCloud.Resize(size);
+    frame.Texture.Resize(size);
+    frame.Info.FrameIndex = frameIndex;
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            frame.PointCloud[r][c] = pho::api::Point3_32f((float) frameIndex, (float) frameIndex, (float) frameIndex);
+            frame.Texture[r][c] = (float) frameIndex;
+        }
+    }
+    return frame;
+}
+
+static std::string ringName(const std::string& test) {
+    return "/phoxi_camera_test_" + test + "_" + std::to_string(getpid());
+}
+
+TEST (SharedMemoryFrameRing, latestOrdering) {
+    SharedMemoryFrameWriter writer(ringName("latest"), 3, 16, 12);
+    SharedMemoryFrameReader reader(writer.getName());
+    SharedMemoryFrameView view;
+    EXPECT_FALSE(reader.latest(view));
+
+    ASSERT_TRUE(writer.write(createFrame(16, 12, 100), 1000));
+    ASSERT_TRUE(reader.latest(view));
+    EXPECT_EQ(1u, view.sequence);
+    EXPECT_EQ(100u, view.frameIndex);
+    EXPECT_EQ(1000, view.stamp);
+    EXPECT_EQ(16u, view.width);
+    EXPECT_EQ(12u, view.height);
+    ASSERT_NE(nullptr, view.pointCloud());
+    EXPECT_EQ(100.0f, view.pointCloud()[3 * (16 * 12 - 1) + 2]);
+    EXPECT_EQ(nullptr, view.normalMap());
+    EXPECT_EQ(nullptr, view.depthMap());
+    EXPECT_TRUE(reader.isValid(view));
+    EXPECT_FALSE(reader.latest(view));
+
+    //the newest frame is returned, the frames in between are counted as skipped
+    for (uint64_t frameIndex = 101; frameIndex <= 103; ++frameIndex) {
+        ASSERT_TRUE(writer.write(createFrame(8, 6, frameIndex), 1000 + frameIndex));
+    }
+    ASSERT_TRUE(reader.latest(view));
+    EXPECT_EQ(4u, view.sequence);
+    EXPECT_EQ(103u, view.frameIndex);
+    EXPECT_EQ(8u, view.width);
+    EXPECT_EQ(2u, reader.getSkippedFrames());
+    EXPECT_FALSE(reader.latest(view));
+
+    //frames bigger than the slots are not written
+    EXPECT_FALSE(writer.write(createFrame(17, 12, 104), 0));
+    EXPECT_FALSE(reader.latest(view));
+}
+
+TEST (SharedMemoryFrameRing, nextWrapAround) {
+    SharedMemoryFrameWriter writer(ringName("next"), 3, 4, 4);
+    SharedMemoryFrameReader reader(writer.getName());
+    SharedMemoryFrameView view;
+    for (uint64_t frameIndex = 1; frameIndex <= 2; ++frameIndex) {
+        ASSERT_TRUE(writer.write(createFrame(4, 4, frameIndex), 0));
+    }
+    for (uint64_t sequence = 1; sequence <= 2; ++sequence) {
+        ASSERT_TRUE(reader.next(view));
+        EXPECT_EQ(sequence, view.sequence);
+        EXPECT_EQ(sequence, view.frameIndex);
+        EXPECT_EQ((float) sequence, view.texture()[0]);
+    }
+    EXPECT_FALSE(reader.next(view));
+
+    //frames 3 and 4 were overwritten by 6 and 7 in the ring of 3 slots, next resumes at the oldest frame left
+    for (uint64_t frameIndex = 3; frameIndex <= 7; ++frameIndex) {
+        ASSERT_TRUE(writer.write(createFrame(4, 4, frameIndex), 0));
+    }
+    for (uint64_t sequence = 5; sequence <= 7; ++sequence) {
+        ASSERT_TRUE(reader.next(view));
+        EXPECT_EQ(sequence, view.sequence);
+        EXPECT_EQ(sequence, view.frameIndex);
+        EXPECT_TRUE(reader.isValid(view));
+    }
+    EXPECT_FALSE(reader.next(view));
+    EXPECT_EQ(2u, reader.getSkippedFrames());
+}
+
+TEST (SharedMemoryFrameRing, overwrittenViewIsInvalid) {
+    SharedMemoryFrameWriter writer(ringName("overwrite"), 2, 4, 4);
+    SharedMemoryFrameReader reader(writer.getName());
+    SharedMemoryFrameView view;
+    ASSERT_TRUE(writer.write(createFrame(4, 4, 1), 0));
+    ASSERT_TRUE(reader.next(view));
+    ASSERT_TRUE(writer.write(createFrame(4, 4, 2), 0));
+    //the other slot was written
+    EXPECT_TRUE(reader.isValid(view));
+    ASSERT_TRUE(writer.write(createFrame(4, 4, 3), 0));
+    EXPECT_FALSE(reader.isValid(view));
+}
+
+TEST (SharedMemoryFrameRing, tornReadsDetected) {
+    const int width = 64, height = 48;
+    SharedMemoryFrameWriter writer(ringName("torn"), 2, width, height);
+    SharedMemoryFrameReader reader(writer.getName());
+    std::vector<pho::api::Frame> frames;
+    for (uint64_t frameIndex = 1; frameIndex <= 8; ++frameIndex) {
+        frames.push_back(createFrame(width, height, frameIndex));
+    }
+    std::atomic<bool> writing(true);
+    std::thread writerThread([&] {
+        for (int i = 0; i < 20000; ++i) {
+            writer.write(frames[i % frames.size()], i);
+        }
+        writing = false;
+    });
+
+    //the copy of a frame is consistent whenever the view is still valid after it
+    uint64_t validCopies = 0;
+    std::vector<float> copy(width * height);
+    SharedMemoryFrameView view;
+    while (writing) {
+        if (!reader.latest(view)) {
+            continue;
+        }
+        const float* texture = view.texture();
+        std::copy(texture, texture + width * height, copy.begin());
+        if (!reader.isValid(view)) {
+            continue;
+        }
+        ++validCopies;
+        for (float value : copy) {
+            ASSERT_EQ((float) view.frameIndex, value);
+        }
+    }
+    writerThread.join();
+    EXPECT_GT(validCopies, 0u);
+}
+
+TEST (SharedMemoryFrameRing, missingRing) {
+    EXPECT_THROW(SharedMemoryFrameReader reader(ringName("missing")), SharedMemoryError);
+}
@@ -0,0 +1,121 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace phoxi_camera;
+
+//counts the calls of each index and records the chunks
+struct ChunkRecorder {
+    explicit ChunkRecorder(int size) : calls(new std::atomic<int>[size]), size(size) {
+        for (int i = 0; i < size; ++i) {
+            calls[i] = 0;
+        }
+    }
+    void operator()(int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            ++calls[i];
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(std::make_pair(begin, end));
+    }
+    std::unique_ptr<std::atomic<int>[]> calls;
+    int size;
+    std::mutex mutex;
+    std::vector<std::pair<int, int>> chunks;
+};
+
+static void expectEachIndexOnce(ChunkRecorder& recorder, int begin, int end) {
+    for (int i = 0; i < recorder.size; ++i) {
+        EXPECT_EQ(i >= begin && i < end ? 1 : 0, recorder.calls[i].load()) << "index " << i;
+    }
+}
+
+TEST (ThreadPool, eachIndexExactlyOnce) {
+    for (int threads : {1, 2, 4, 7}) {
+        ThreadPool threadPool;
+        threadPool.start(threads);
+        EXPECT_EQ(threads, threadPool.getThreadCount());
+        for (int end : {1, 2, 3, 17, 100, 1001}) {
+            ChunkRecorder recorder(end + 10);
+            threadPool.parallelFor(5, end + 5, std::ref(recorder));
+            expectEachIndexOnce(recorder, 5, end + 5);
+        }
+    }
+}
+
+TEST (ThreadPool, minChunk) {
+    ThreadPool threadPool;
+    threadPool.start(4);
+    for (int minChunk : {1, 8, 33, 1000}) {
+        ChunkRecorder recorder(1000);
+        threadPool.parallelFor(0, 1000, std::ref(recorder), minChunk);
+        expectEachIndexOnce(recorder, 0, 1000);
+        //only the last chunk may be shorter than minChunk
+        for (const std::pair<int, int>& chunk : recorder.chunks) {
+            EXPECT_TRUE(chunk.second - chunk.first >= minChunk || chunk.second == 1000);
+        }
+        if (minChunk >= 1000) {
+            EXPECT_EQ(1u, recorder.chunks.size());
+        }
+    }
+}
+
+TEST (ThreadPool, withoutWorkers) {
+    //the loops run inline on the calling thread
+    for (int threads : {0, 1}) {
+        ThreadPool threadPool;
+        if (threads > 0) {
+            threadPool.start(threads);
+            EXPECT_EQ(1, threadPool.getThreadCount());
+        }
+        ChunkRecorder recorder(64);
+        const std::thread::id caller = std::this_thread::get_id();
+        bool runsInline = true;
+        threadPool.parallelFor(0, 64, [&](int begin, int end) {
+            runsInline &= std::this_thread::get_id() == caller;
+            recorder(begin, end);
+        });
+        EXPECT_TRUE(runsInline);
+        EXPECT_EQ(1u, recorder.chunks.size());
+        expectEachIndexOnce(recorder, 0, 64);
+    }
+    ThreadPool threadPool;
+    bool called = false;
+    threadPool.parallelFor(3, 3, [&](int, int) { called = true; });
+    threadPool.parallelFor(3, 1, [&](int, int) { called = true; });
+    EXPECT_FALSE(called);
+}
+
+TEST (ThreadPool, exceptionRethrownOnCaller) {
+    ThreadPool threadPool;
+    threadPool.start(4);
+    for (int throwing : {0, 500, 999}) {
+        std::atomic<int> running(0);
+        EXPECT_THROW(threadPool.parallelFor(0, 1000, [&](int begin, int end) {
+            ++running;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            --running;
+            if (throwing >= begin && throwing < end) {
+                throw std::runtime_error("chunk failed");
+            }
+        }), std::runtime_error);
+        //no thread is left in the body once parallelFor returns
+        EXPECT_EQ(0, running.load());
+    }
+
+    //the pool is still usable after an exception
+    ChunkRecorder recorder(1000);
+    threadPool.parallelFor(0, 1000, std::ref(recorder));
+    expectEachIndexOnce(recorder, 0, 1000);
+}
@@ -0,0 +1,59 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/TraceRecorder.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace phoxi_camera;
+
+static std::string tracePath() {
+    return "/tmp/phoxi_camera_test_trace_" + std::to_string(getpid()) + ".json";
+}
+
+static void recordEvents(int count) {
+    for (int i = 0; i < count; ++i) {
+        TraceScope scope("event", "test", i);
+    }
+}
+
+TEST (TraceRecorder, eventsOfExitedThreadsWritten) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    recorder.start(64);
+    std::thread first(recordEvents, 10);
+    first.join();
+    std::thread second(recordEvents, 100);
+    second.join();
+    recordEvents(3);
+    //the buffers are full after 64 events
+    EXPECT_EQ(10u + 64u + 3u, recorder.stop(tracePath()));
+
+    std::ifstream file(tracePath().c_str());
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_NE(std::string::npos, content.str().find("\"name\":\"event\",\"cat\":\"test\""));
+    EXPECT_NE(std::string::npos, content.str().find("\"args\":{\"frame_index\":63}"));
+
+    //the buffers of the exited threads were released by stop
+    recorder.start(64);
+    recordEvents(2);
+    EXPECT_EQ(2u, recorder.stop(tracePath()));
+    std::remove(tracePath().c_str());
+}
+
+TEST (TraceRecorder, notRecording) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    std::thread thread(recordEvents, 10);
+    thread.join();
+    recorder.recordInstant("instant", "test");
+    recorder.start(16);
+    EXPECT_EQ(0u, recorder.stop(tracePath()));
+    std::remove(tracePath().c_str());
+}
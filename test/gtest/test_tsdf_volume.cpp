@@ -0,0 +1,123 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/TsdfVolume.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace phoxi_camera;
+
+//points of the plane z = 1 m of the volume seen from pose, in the frame of the sensor
+static std::vector<Eigen::Vector3f> createPlaneView(const Eigen::Affine3f& pose, float extent, float spacing) {
+    std::vector<Eigen::Vector3f> points;
+    const Eigen::Affine3f inversePose = pose.inverse();
+    for (float y = -extent; y <= extent; y += spacing) {
+        for (float x = -extent; x <= extent; x += spacing) {
+            points.push_back(inversePose * Eigen::Vector3f(x, y, 1.0f));
+        }
+    }
+    return points;
+}
+
+static Eigen::Affine3f createSecondPose() {
+    //moved aside and turned back to the center of the plane
+    Eigen::Affine3f pose = Eigen::Affine3f::Identity();
+    pose.translate(Eigen::Vector3f(0.25f, 0.05f, 0.1f));
+    pose.rotate(Eigen::AngleAxisf(-0.27f, Eigen::Vector3f::UnitY()));
+    return pose;
+}
+
+TEST (TsdfVolume, planeFromTwoPoses) {
+    ThreadPool threadPool;
+    threadPool.start(4);
+    TsdfVolume volume;
+    const float voxelSize = 0.004f;
+    volume.setParameters(voxelSize, 0.016f, 64.0f);
+    const Eigen::Affine3f poses[2] = {Eigen::Affine3f::Identity(), createSecondPose()};
+    for (const Eigen::Affine3f& pose : poses) {
+        const std::vector<Eigen::Vector3f> points = createPlaneView(pose, 0.1f, 0.002f);
+        //in the frame of the second sensor the plane is tilted, only the pose brings both views together
+        volume.integrate(points, std::vector<uint8_t>(points.size(), 200), pose, threadPool);
+    }
+    EXPECT_EQ(2u, volume.getIntegratedFrames());
+    EXPECT_GT(volume.getBlockCount(), 0u);
+    EXPECT_GT(volume.getMemoryUsage(), volume.getBlockCount() * sizeof(TsdfVolume::Block));
+
+    std::vector<Eigen::Vector3f> surface;
+    std::vector<uint8_t> intensities;
+    volume.extractSurface(surface, intensities, 2.0f, threadPool);
+    ASSERT_GT(surface.size(), 1000u);
+    ASSERT_EQ(surface.size(), intensities.size());
+    for (size_t i = 0; i < surface.size(); ++i) {
+        ASSERT_NEAR(1.0f, surface[i].z(), voxelSize);
+        ASSERT_LE(std::abs(surface[i].x()), 0.1f + voxelSize);
+        ASSERT_LE(std::abs(surface[i].y()), 0.1f + voxelSize);
+        ASSERT_NEAR(200, intensities[i], 1);
+    }
+
+    //the output does not depend on the number of threads
+    ThreadPool singleThread;
+    std::vector<Eigen::Vector3f> singleThreadSurface;
+    volume.extractSurface(singleThreadSurface, intensities, 2.0f, singleThread);
+    EXPECT_EQ(surface, singleThreadSurface);
+}
+
+TEST (TsdfVolume, reset) {
+    ThreadPool threadPool;
+    threadPool.start(2);
+    TsdfVolume volume;
+    const std::vector<Eigen::Vector3f> points = createPlaneView(Eigen::Affine3f::Identity(), 0.05f, 0.002f);
+    volume.integrate(points, std::vector<uint8_t>(), Eigen::Affine3f::Identity(), threadPool);
+    ASSERT_GT(volume.getBlockCount(), 0u);
+
+    volume.reset();
+    EXPECT_EQ(0u, volume.getBlockCount());
+    EXPECT_EQ(0u, volume.getIntegratedFrames());
+    std::vector<Eigen::Vector3f> surface;
+    std::vector<uint8_t> intensities;
+    volume.extractSurface(surface, intensities, 0.0f, threadPool);
+    EXPECT_TRUE(surface.empty());
+
+    //empty views are not counted
+    volume.integrate(std::vector<Eigen::Vector3f>(), std::vector<uint8_t>(), Eigen::Affine3f::Identity(), threadPool);
+    EXPECT_EQ(0u, volume.getIntegratedFrames());
+}
+
+TEST (TsdfVolume, parameterChanges) {
+    ThreadPool threadPool;
+    threadPool.start(2);
+    TsdfVolume volume;
+    volume.setParameters(0.004f, 0.016f, 64.0f);
+    const std::vector<Eigen::Vector3f> points = createPlaneView(Eigen::Affine3f::Identity(), 0.05f, 0.002f);
+    volume.integrate(points, std::vector<uint8_t>(), Eigen::Affine3f::Identity(), threadPool);
+    const size_t blocks = volume.getBlockCount();
+    ASSERT_GT(blocks, 0u);
+
+    //the weight limit applies to the next updates and keeps the volume
+    volume.setParameters(0.004f, 0.016f, 8.0f);
+    EXPECT_EQ(blocks, volume.getBlockCount());
+    EXPECT_EQ(1u, volume.getIntegratedFrames());
+
+    //voxels of another size or distances of another truncation cannot be merged
+    volume.setParameters(0.004f, 0.02f, 8.0f);
+    EXPECT_EQ(0u, volume.getBlockCount());
+    volume.integrate(points, std::vector<uint8_t>(), Eigen::Affine3f::Identity(), threadPool);
+    ASSERT_GT(volume.getBlockCount(), 0u);
+    volume.setParameters(0.002f, 0.02f, 8.0f);
+    EXPECT_EQ(0u, volume.getBlockCount());
+    EXPECT_EQ(0.002f, volume.getVoxelSize());
+
+    //the truncation distance is at least one voxel
+    volume.setParameters(0.002f, 0.0f, 8.0f);
+    EXPECT_EQ(0.002f, volume.getVoxelSize());
+    volume.integrate(points, std::vector<uint8_t>(), Eigen::Affine3f::Identity(), threadPool);
+    std::vector<Eigen::Vector3f> surface;
+    std::vector<uint8_t> intensities;
+    volume.extractSurface(surface, intensities, 0.0f, threadPool);
+    for (const Eigen::Vector3f& point : surface) {
+        ASSERT_NEAR(1.0f, point.z(), 0.002f);
+    }
+}
@@ -0,0 +1,171 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//brute force evaluation of the confidence, jump edge and valid neighbours filters, neighbours outside of the image do not exist
+static std::vector<uint8_t> validPointsMask(pho::api::Frame& frame, float minConfidence, float jumpEdgeMaxDepthRatio, int minValidNeighbours) {
+    const int width = frame.PointCloud.Size.Width;
+    const int height = frame.PointCloud.Size.Height;
+    std::vector<uint8_t> valid((size_t) width * height);
+    std::vector<float> depth((size_t) width * height);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            const pho::api::Point3_32f& point = frame.PointCloud[r][c];
+            bool pointValid = point.x != 0.0f || point.y != 0.0f || point.z != 0.0f;
+            if (minConfidence > 0.0f && !frame.ConfidenceMap.Empty()) {
+                pointValid = pointValid && frame.ConfidenceMap[r][c] >= minConfidence;
+            }
+            valid[(size_t) r * width + c] = pointValid;
+            depth[(size_t) r * width + c] = frame.DepthMap.Empty() ?
+                    std::sqrt(point.x * point.x + point.y * point.y + point.z * point.z) : frame.DepthMap[r][c];
+        }
+    }
+    auto isValid = [&](int r, int c) {
+        return r >= 0 && r < height && c >= 0 && c < width && valid[(size_t) r * width + c];
+    };
+    std::vector<uint8_t> mask(valid);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            if (!valid[(size_t) r * width + c]) {
+                continue;
+            }
+            if (jumpEdgeMaxDepthRatio > 1.0f) {
+                const float d = depth[(size_t) r * width + c];
+                const int neighbours[4][2] = {{r, c - 1}, {r, c + 1}, {r - 1, c}, {r + 1, c}};
+                for (const auto& neighbour : neighbours) {
+                    if (isValid(neighbour[0], neighbour[1])) {
+                        const float n = depth[(size_t) neighbour[0] * width + neighbour[1]];
+                        if (std::max(d, n) > jumpEdgeMaxDepthRatio * std::min(d, n)) {
+                            mask[(size_t) r * width + c] = 0;
+                        }
+                    }
+                }
+            }
+            if (minValidNeighbours > 0) {
+                int count = 0;
+                for (int dr = -1; dr <= 1; ++dr) {
+                    for (int dc = -1; dc <= 1; ++dc) {
+                        count += (dr != 0 || dc != 0) && isValid(r + dr, c + dc);
+                    }
+                }
+                if (count < minValidNeighbours) {
+                    mask[(size_t) r * width + c] = 0;
+                }
+            }
+        }
+    }
+    return mask;
+}
+
+//jumps and holes on the first and last rows and columns, where the filters read the padding of the row window
+static pho::api::PFrame createFrameWithBorderEdges(int width, int height, unsigned int seed) {
+    pho::api::PFrame frame = phoxi_camera_test::createSyntheticFrame(width, height, 0.2, 0, seed);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            if (r != 0 && r != height - 1 && c != 0 && c != width - 1) {
+                continue;
+            }
+            const int i = r + c;
+            pho::api::Point3_32f& point = frame->PointCloud[r][c];
+            if (i % 7 == 0) {
+                point = pho::api::Point3_32f(0.0f, 0.0f, 0.0f);
+                frame->DepthMap[r][c] = 0.0f;
+            } else if (i % 5 == 0) {
+                point = pho::api::Point3_32f(point.x * 1.3f, point.y * 1.3f, point.z * 1.3f);
+                frame->DepthMap[r][c] *= 1.3f;
+            }
+        }
+    }
+    return frame;
+}
+
+static void expectSameMask(const std::vector<uint8_t>& expected, const pcl::PointCloud<pcl::PointXYZ>& cloud, int rowBegin = 0) {
+    const size_t offset = (size_t) rowBegin * cloud.width;
+    for (size_t i = 0; i < cloud.points.size(); ++i) {
+        ASSERT_EQ((bool) expected[offset + i], !std::isnan(cloud.points[i].z)) << "row " << (offset + i) / cloud.width << " column " << (offset + i) % cloud.width;
+    }
+}
+
+static void expectFilter(PhoXiInterface& phoxiInterface, const pho::api::PFrame& phoxiFrame, float minConfidence, float jumpEdgeMaxDepthRatio, int minValidNeighbours) {
+    phoxiInterface.setPointCloudMinConfidence(minConfidence);
+    phoxiInterface.setPointCloudJumpEdgeMaxDepthRatio(jumpEdgeMaxDepthRatio);
+    phoxiInterface.setPointCloudMinValidNeighbours(minValidNeighbours);
+    const std::vector<uint8_t> expected = validPointsMask(*phoxiFrame, minConfidence, jumpEdgeMaxDepthRatio, minValidNeighbours);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxiFrame);
+    std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> cloud = phoxiInterface.getPointCloudFromFrame<pcl::PointXYZ>(frame);
+    ASSERT_EQ(expected.size(), cloud->points.size());
+    expectSameMask(expected, *cloud);
+    //bands start the row window in the middle of the frame
+    const int height = phoxiFrame->PointCloud.Size.Height;
+    for (int rowBegin = 0; rowBegin < height; rowBegin += 37) {
+        expectSameMask(expected, *phoxiInterface.getPointCloudBandFromFrame<pcl::PointXYZ>(frame, rowBegin, rowBegin + 37), rowBegin);
+    }
+}
+
+TEST (ValidPointsFilter, confidence) {
+    PhoXiInterface phoxiInterface;
+    pho::api::PFrame frame = createFrameWithBorderEdges(160, 120, 1);
+    expectFilter(phoxiInterface, frame, 2.5f, 0.0f, 0);
+    //the confidence filter is disabled without a confidence map
+    frame->ConfidenceMap = pho::api::ConfidenceMap32f();
+    expectFilter(phoxiInterface, frame, 2.5f, 0.0f, 0);
+}
+
+TEST (ValidPointsFilter, jumpEdge) {
+    PhoXiInterface phoxiInterface;
+    pho::api::PFrame frame = createFrameWithBorderEdges(160, 120, 2);
+    expectFilter(phoxiInterface, frame, 0.0f, 1.05f, 0);
+    //without the depth map the depth is the distance of the point
+    frame->DepthMap = pho::api::DepthMap32f();
+    expectFilter(phoxiInterface, frame, 0.0f, 1.05f, 0);
+}
+
+TEST (ValidPointsFilter, minValidNeighbours) {
+    PhoXiInterface phoxiInterface;
+    pho::api::PFrame frame = createFrameWithBorderEdges(160, 120, 3);
+    //corners have 3 neighbours and the other border points 5
+    for (int minValidNeighbours : {3, 5, 8}) {
+        expectFilter(phoxiInterface, frame, 0.0f, 0.0f, minValidNeighbours);
+    }
+}
+
+TEST (ValidPointsFilter, allFilters) {
+    PhoXiInterface phoxiInterface;
+    pho::api::PFrame frame = createFrameWithBorderEdges(161, 119, 4);
+    expectFilter(phoxiInterface, frame, 2.5f, 1.05f, 6);
+    frame->DepthMap = pho::api::DepthMap32f();
+    expectFilter(phoxiInterface, frame, 2.5f, 1.05f, 6);
+}
+
+TEST (ValidPointsFilter, onlyValidPoints) {
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setPointCloudMinConfidence(2.5f);
+    phoxiInterface.setPointCloudJumpEdgeMaxDepthRatio(1.05f);
+    phoxiInterface.setPointCloudMinValidNeighbours(6);
+    phoxiInterface.setGeneratePointCloudWithOnlyValidPoints(true);
+    pho::api::PFrame phoxiFrame = createFrameWithBorderEdges(160, 120, 5);
+    const std::vector<uint8_t> expected = validPointsMask(*phoxiFrame, 2.5f, 1.05f, 6);
+    std::shared_ptr<pcl::PointCloud<pcl::PointXYZ>> cloud = phoxiInterface.getPointCloudFromFrame<pcl::PointXYZ>(phoxiInterface.postProcessFrame(phoxiFrame));
+
+    //the valid points in row major order
+    EXPECT_TRUE(cloud->is_dense);
+    EXPECT_EQ(1u, cloud->height);
+    ASSERT_EQ((size_t) std::count(expected.begin(), expected.end(), 1), cloud->points.size());
+    size_t p = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (expected[i]) {
+            const pho::api::Point3_32f& point = phoxiFrame->PointCloud[i / 160][i % 160];
+            ASSERT_FLOAT_EQ(point.x * 0.001f, cloud->points[p].x);
+            ASSERT_FLOAT_EQ(point.z * 0.001f, cloud->points[p].z);
+            ++p;
+        }
+    }
+}
@@ -0,0 +1,113 @@
+//
+// Created by controller on 10/19/26.
+//
+
+#include <gtest/gtest.h>
+#include "phoxi_camera/PhoXiInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <cmath>
+#include <map>
+#include <tuple>
+#include <vector>
+
+struct ReferenceVoxel {
+    double x = 0.0, y = 0.0, z = 0.0;
+    Eigen::Vector3f normal = Eigen::Vector3f::Zero();
+    uint32_t intensity = 0;
+    uint32_t count = 0;
+};
+
+//voxels in the lexicographic order of their cell coordinates, the order of the packed keys of the voxel grid
+typedef std::map<std::tuple<int64_t, int64_t, int64_t>, ReferenceVoxel> ReferenceVoxelGrid;
+
+static ReferenceVoxelGrid voxelize(const FramePostProcessed& frame, float leafSize, const Eigen::Affine3f& transform) {
+    pho::api::Frame& phoxiFrame = *frame.PFrame;
+    const float cellsPerMeter = 1.0f / leafSize;
+    const Eigen::Matrix3f rotation = transform.linear();
+    const Eigen::Matrix3f rotationAndScale = rotation * 0.001f;
+    ReferenceVoxelGrid voxels;
+    for (int r = 0; r < phoxiFrame.PointCloud.Size.Height; ++r) {
+        for (int c = 0; c < phoxiFrame.PointCloud.Size.Width; ++c) {
+            const pho::api::Point3_32f& rawPoint = phoxiFrame.PointCloud[r][c];
+            if (rawPoint.x == 0.0f && rawPoint.y == 0.0f && rawPoint.z == 0.0f) {
+                continue;
+            }
+            const Eigen::Vector3f point = rotationAndScale * Eigen::Vector3f(rawPoint.x, rawPoint.y, rawPoint.z) + transform.translation();
+            ReferenceVoxel& voxel = voxels[std::make_tuple((int64_t) std::floor(point.x() * cellsPerMeter),
+                                                           (int64_t) std::floor(point.y() * cellsPerMeter),
+                                                           (int64_t) std::floor(point.z() * cellsPerMeter))];
+            voxel.x += point.x();
+            voxel.y += point.y();
+            voxel.z += point.z();
+            const pho::api::Point3_32f& normal = phoxiFrame.NormalMap[r][c];
+            voxel.normal += rotation * Eigen::Vector3f(normal.x, normal.y, normal.z);
+            if (!frame.TextureAfterPostProcessing.empty()) {
+                voxel.intensity += frame.TextureAfterPostProcessing.at<uint8_t>(r, c);
+            }
+            ++voxel.count;
+        }
+    }
+    return voxels;
+}
+
+static void expectSameVoxels(const ReferenceVoxelGrid& expected, const pcl::PointCloud<pcl::PointXYZRGBNormal>& cloud) {
+    ASSERT_EQ(expected.size(), cloud.points.size());
+    size_t i = 0;
+    for (const auto& entry : expected) {
+        const ReferenceVoxel& voxel = entry.second;
+        const pcl::PointXYZRGBNormal& point = cloud.points[i++];
+        EXPECT_NEAR(voxel.x / voxel.count, point.x, 1e-6);
+        EXPECT_NEAR(voxel.y / voxel.count, point.y, 1e-6);
+        EXPECT_NEAR(voxel.z / voxel.count, point.z, 1e-6);
+        const Eigen::Vector3f normal = voxel.normal.normalized();
+        EXPECT_NEAR(normal.x(), point.normal_x, 1e-5f);
+        EXPECT_NEAR(normal.y(), point.normal_y, 1e-5f);
+        EXPECT_NEAR(normal.z(), point.normal_z, 1e-5f);
+        //the intensity is 0 without texture
+        EXPECT_EQ((voxel.intensity + voxel.count / 2) / voxel.count, point.r);
+    }
+}
+
+TEST (VoxelGrid, sameAsBruteForce) {
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setWorkerThreads(4);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(320, 240, 0.2, 0, 1));
+    const float leafSize = 0.01f;
+    //the left and top of the scene have negative x and y in the camera space
+    std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> cloud = phoxiInterface.getVoxelGridPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, leafSize);
+    EXPECT_TRUE(cloud->is_dense);
+    EXPECT_EQ(1u, cloud->height);
+    expectSameVoxels(voxelize(*frame, leafSize, Eigen::Affine3f::Identity()), *cloud);
+}
+
+TEST (VoxelGrid, negativeCoordinatesWithTransform) {
+    PhoXiInterface phoxiInterface;
+    phoxiInterface.setWorkerThreads(3);
+    PFramePostProcessed frame = phoxiInterface.postProcessFrame(phoxi_camera_test::createSyntheticFrame(320, 240, 0.2, 0, 2));
+    //all the points end up with negative z, about half of them with negative x and y
+    Eigen::Affine3f transform = Eigen::Translation3f(0.05f, -0.1f, -2.0f) * Eigen::AngleAxisf(0.3f, Eigen::Vector3f(1.0f, 2.0f, 0.5f).normalized());
+    const float leafSize = 0.007f;
+    const ReferenceVoxelGrid expected = voxelize(*frame, leafSize, transform);
+    ASSERT_LT(std::get<0>(expected.begin()->first), 0);
+    ASSERT_LT(std::get<2>(expected.rbegin()->first), 0);
+    expectSameVoxels(expected, *phoxiInterface.getVoxelGridPointCloudFromFrame<pcl::PointXYZRGBNormal>(frame, leafSize, transform));
+}
+
+TEST (VoxelGrid, independentOfThreadCount) {
+    pho::api::PFrame phoxiFrame = phoxi_camera_test::createSyntheticFrame(320, 240, 0.2, 0, 3);
+    std::shared_ptr<pcl::PointCloud<pcl::PointXYZRGBNormal>> clouds[2];
+    for (int t = 0; t < 2; ++t) {
+        PhoXiInterface phoxiInterface;
+        phoxiInterface.setWorkerThreads(t == 0 ? 1 : 4);
+        clouds[t] = phoxiInterface.getVoxelGridPointCloudFromFrame<pcl::PointXYZRGBNormal>(phoxiInterface.postProcessFrame(phoxiFrame), 0.02f);
+    }
+    ASSERT_EQ(clouds[0]->points.size(), clouds[1]->points.size());
+    for (size_t i = 0; i < clouds[0]->points.size(); ++i) {
+        EXPECT_NEAR(clouds[0]->points[i].x, clouds[1]->points[i].x, 1e-6f);
+        EXPECT_NEAR(clouds[0]->points[i].y, clouds[1]->points[i].y, 1e-6f);
+        EXPECT_NEAR(clouds[0]->points[i].z, clouds[1]->points[i].z, 1e-6f);
+        EXPECT_NEAR(clouds[0]->points[i].normal_z, clouds[1]->points[i].normal_z, 1e-5f);
+        EXPECT_EQ(clouds[0]->points[i].r, clouds[1]->points[i].r);
+    }
+}
@@ -10,15 +10,33 @@ srv_timeout = 1
 class topic:
     diagnostics         = "/diagnostics"
     confidence_map      = node_name + "/confidence_map"
+    depth_map           = node_name + "/depth_map"
+    depth_map_camera_info = node_name + "/depth_map/camera_info"
+    height_map          = node_name + "/height_map"
+    image_raw           = node_name + "/image_raw"
+    image_rect          = node_name + "/image_rect"
+    mesh                = node_name + "/mesh"
     normal_map          = node_name + "/normal_map"
     param_description   = node_name + "/parameter_descriptions"
     param_update        = node_name + "/parameter_updates"
+    plane               = node_name + "/plane"
+    plane_mask          = node_name + "/plane_mask"
     point_cloud         = node_name + "/pointcloud"
+    point_cloud_bands   = node_name + "/pointcloud_bands"
+    point_cloud_foreground = node_name + "/pointcloud_foreground"
+    point_cloud_preview = node_name + "/pointcloud_preview"
+    point_cloud_statistics = node_name + "/pointcloud_statistics"
+    point_cloud_voxel_grid = node_name + "/pointcloud_voxel_grid"
+    scene_change        = node_name + "/scene_change"
     texture             = node_name + "/texture"
+    texture_camera_info = node_name + "/texture/camera_info"
+    tsdf_cloud          = node_name + "/tsdf_cloud"
 
 class service:
+    capture_background  = node_name + "/capture_background"
     connect_camera      = node_name + "/connect_camera"
     disconnect_camera   = node_name + "/disconnect_camera"
+    extract_tsdf        = node_name + "/extract_tsdf"
     get_device_list     = node_name + "/get_device_list"
     get_frame           = node_name + "/get_frame"
     get_hardware_indentification = node_name + "/get_hardware_indentification"
@@ -26,11 +44,16 @@ class service:
     get_supported_capturing_modes = node_name + "/get_supported_capturing_modes"
     is_acquiring        = node_name + "/is_acquiring"
     is_connected        = node_name + "/is_connected"
+    reset_background    = node_name + "/reset_background"
+    reset_tsdf          = node_name + "/reset_tsdf"
     save_frame          = node_name + "/save_frame"
+    set_capture_profile = node_name + "/set_capture_profile"
     set_logger_level    = node_name + "/set_logger_level"
     set_parameters      = node_name + "/set_parameters"
     start_acquisition   = node_name + "/start_acquisition"
+    start_trace_capture = node_name + "/start_trace_capture"
     stop_acquisition    = node_name + "/stop_acquisition"
+    stop_trace_capture  = node_name + "/stop_trace_capture"
     trigger_image       = node_name + "/trigger_image"
     # V2
     V2_is_acquiring         = node_name + "/V2/is_acquiring"
@@ -70,6 +70,54 @@ class Test_phoxi_camera_interfaces(TestCase):
         assert topic_is_running(topic.texture) == True, \
             "Topic %s, not exist" % (topic.texture)
 
+        assert topic_is_running(topic.depth_map) == True, \
+            "Topic %s, not exist" % (topic.depth_map)
+
+        assert topic_is_running(topic.depth_map_camera_info) == True, \
+            "Topic %s, not exist" % (topic.depth_map_camera_info)
+
+        assert topic_is_running(topic.height_map) == True, \
+            "Topic %s, not exist" % (topic.height_map)
+
+        assert topic_is_running(topic.image_raw) == True, \
+            "Topic %s, not exist" % (topic.image_raw)
+
+        assert topic_is_running(topic.image_rect) == True, \
+            "Topic %s, not exist" % (topic.image_rect)
+
+        assert topic_is_running(topic.mesh) == True, \
+            "Topic %s, not exist" % (topic.mesh)
+
+        assert topic_is_running(topic.plane) == True, \
+            "Topic %s, not exist" % (topic.plane)
+
+        assert topic_is_running(topic.plane_mask) == True, \
+            "Topic %s, not exist" % (topic.plane_mask)
+
+        assert topic_is_running(topic.point_cloud_bands) == True, \
+            "Topic %s, not exist" % (topic.point_cloud_bands)
+
+        assert topic_is_running(topic.point_cloud_foreground) == True, \
+            "Topic %s, not exist" % (topic.point_cloud_foreground)
+
+        assert topic_is_running(topic.point_cloud_preview) == True, \
+            "Topic %s, not exist" % (topic.point_cloud_preview)
+
+        assert topic_is_running(topic.point_cloud_statistics) == True, \
+            "Topic %s, not exist" % (topic.point_cloud_statistics)
+
+        assert topic_is_running(topic.point_cloud_voxel_grid) == True, \
+            "Topic %s, not exist" % (topic.point_cloud_voxel_grid)
+
+        assert topic_is_running(topic.scene_change) == True, \
+            "Topic %s, not exist" % (topic.scene_change)
+
+        assert topic_is_running(topic.texture_camera_info) == True, \
+            "Topic %s, not exist" % (topic.texture_camera_info)
+
+        assert topic_is_running(topic.tsdf_cloud) == True, \
+            "Topic %s, not exist" % (topic.tsdf_cloud)
+
     def test4_services_running(self):
         """
         test if there are all the necessary services that have been created
@@ -120,6 +168,27 @@ class Test_phoxi_camera_interfaces(TestCase):
         assert service_is_running(service.trigger_image) == True, \
             "Service %s is not exist" % service.trigger_image
 
+        assert service_is_running(service.capture_background) == True, \
+            "Service %s is not exist" % service.capture_background
+
+        assert service_is_running(service.extract_tsdf) == True, \
+            "Service %s is not exist" % service.extract_tsdf
+
+        assert service_is_running(service.reset_background) == True, \
+            "Service %s is not exist" % service.reset_background
+
+        assert service_is_running(service.reset_tsdf) == True, \
+            "Service %s is not exist" % service.reset_tsdf
+
+        assert service_is_running(service.set_capture_profile) == True, \
+            "Service %s is not exist" % service.set_capture_profile
+
+        assert service_is_running(service.start_trace_capture) == True, \
+            "Service %s is not exist" % service.start_trace_capture
+
+        assert service_is_running(service.stop_trace_capture) == True, \
+            "Service %s is not exist" % service.stop_trace_capture
+
         assert service_is_running(service.V2_is_acquiring) == True, \
             "Service %s is not exist" % service.V2_is_acquiring
 
@@ -0,0 +1,283 @@
+//
+// Soak test of the RosInterface frame pipeline (post-processing, point cloud conversion and publishing of all the
+// outputs) fed by synthetic frames, so neither a scanner nor PhoXi Control is needed.
+//
+// Resident memory, allocations per frame, latency and dropped frames are sampled periodically and the test fails
+// (exit code 1) when they grow more than the configured thresholds between the first and the last period after warmup.
+//
+
+#include "phoxi_camera/RosInterface.h"
+#include "../benchmark/synthetic_frame.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+//allocations of the whole process, counted by the replaced global operator new
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocationBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+/**
+ * Resident set size of the process in bytes
+ */
+static size_t residentMemory() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t residentPages = 0;
+    statm >> pages >> residentPages;
+    return residentPages * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * Measurements of one sampling period
+ */
+struct SoakSample {
+    double time;
+    uint64_t frames;
+    uint64_t droppedFrames;
+    size_t residentMemory;
+    double allocationsPerFrame;
+    double allocatedBytesPerFrame;
+    double latencyP50;
+    double latencyP99;
+    double latencyMax;
+};
+
+static double percentile(std::vector<double>& values, double rank) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::vector<double>::iterator selected = values.begin() + std::min(values.size() - 1, (size_t) (rank * values.size()));
+    std::nth_element(values.begin(), selected, values.end());
+    return *selected;
+}
+
+//* SoakTestInterface
+/**
+ * RosInterface whose frames come from a pool of synthetic frames instead of the scanner
+ */
+class SoakTestInterface : public RosInterface {
+public:
+    SoakTestInterface(int width, int height, double invalidRatio, int poolSize) {
+        for (int i = 0; i < std::max(1, poolSize); ++i) {
+            framePool.push_back(phoxi_camera_test::createSyntheticFrame(width, height, invalidRatio, 0, i));
+        }
+    }
+
+    /**
+    * Post-process and publish the next synthetic frame
+    *
+    * \return trigger to publish latency in seconds
+    */
+    double processFrame(uint64_t frameIndex) {
+        pho::api::PFrame frame = framePool[frameIndex % framePool.size()];
+        frame->Info.FrameIndex = frameIndex;
+        std::chrono::steady_clock::time_point triggerTime = std::chrono::steady_clock::now();
+        PFramePostProcessed frameProcessed = postProcessFrame(frame);
+        frameProcessed->TriggerTime = triggerTime;
+        publishFrame(frameProcessed);
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - triggerTime).count();
+    }
+
+private:
+    std::vector<pho::api::PFrame> framePool;
+};
+
+int main(int argc, char **argv) {
+    ros::init(argc, argv, "phoxi_camera_soak_test");
+    ros::NodeHandle nh("~");
+
+    double duration, warmup, samplePeriod, frameRate, invalidRatio;
+    int width, height, poolSize;
+    double maxResidentMemoryGrowth, maxAllocationsGrowth, maxLatencyP99, maxLatencyGrowth;
+    int maxDroppedFrames;
+    std::string csvPath;
+    nh.param<double>("duration", duration, 3600.0);                         //in s
+    nh.param<double>("warmup", warmup, 60.0);                               //in s, excluded from the checks
+    nh.param<double>("sample_period", samplePeriod, 60.0);                  //in s
+    nh.param<double>("frame_rate", frameRate, 0.0);                         //in Hz, 0 = as fast as possible
+    nh.param<int>("width", width, phoxi_camera_test::HighResolutionWidth);
+    nh.param<int>("height", height, phoxi_camera_test::HighResolutionHeight);
+    nh.param<double>("invalid_ratio", invalidRatio, 0.2);
+    nh.param<int>("frame_pool_size", poolSize, 4);
+    nh.param<double>("max_resident_memory_growth", maxResidentMemoryGrowth, 32.0);  //in MB
+    nh.param<double>("max_allocations_growth", maxAllocationsGrowth, 0.05);         //ratio of allocations per frame
+    nh.param<double>("max_latency_p99", maxLatencyP99, 0.0);                        //in s, 0 = disabled
+    nh.param<double>("max_latency_growth", maxLatencyGrowth, 0.25);                 //ratio of latency p99
+    nh.param<int>("max_dropped_frames", maxDroppedFrames, 0);
+    nh.param<std::string>("csv_path", csvPath, "");
+
+    SoakTestInterface soakTestInterface(width, height, invalidRatio, poolSize);
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    ROS_INFO("Soak test of %d x %d frames for %.0f s (warmup %.0f s)", width, height, duration, warmup);
+    std::vector<SoakSample> samples;
+    std::vector<double> latencies;
+    std::vector<double> allLatencies;
+    uint64_t frameIndex = 0;
+    uint64_t droppedFrames = 0;
+    uint64_t periodFrames = 0;
+    uint64_t periodAllocations = allocationCount.load();
+    uint64_t periodAllocatedBytes = allocationBytes.load();
+    bool warmedUp = warmup <= 0.0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point periodStart = start;
+    std::chrono::steady_clock::time_point nextFrame = start;
+
+    while (ros::ok()) {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - start).count();
+        if (elapsed >= duration) {
+            break;
+        }
+        try {
+            double latency = soakTestInterface.processFrame(++frameIndex);
+            latencies.push_back(latency);
+        } catch (PhoXiInterfaceException &e) {
+            ROS_WARN("Frame %lu dropped: %s", (unsigned long) frameIndex, e.what());
+            ++droppedFrames;
+        }
+        ++periodFrames;
+
+        if (!warmedUp && elapsed >= warmup) {
+            //the period in progress is discarded, it contains the allocations of the first frames
+            warmedUp = true;
+            periodStart = std::chrono::steady_clock::now();
+            periodFrames = 0;
+            droppedFrames = 0;
+            periodAllocations = allocationCount.load();
+            periodAllocatedBytes = allocationBytes.load();
+            latencies.clear();
+            ROS_INFO("Warmup finished after %lu frames", (unsigned long) frameIndex);
+        } else if (warmedUp && std::chrono::duration<double>(std::chrono::steady_clock::now() - periodStart).count() >= samplePeriod && periodFrames > 0) {
+            SoakSample sample;
+            sample.time = elapsed;
+            sample.frames = periodFrames;
+            sample.droppedFrames = droppedFrames;
+            sample.residentMemory = residentMemory();
+            const uint64_t allocations = allocationCount.load();
+            const uint64_t allocatedBytes = allocationBytes.load();
+            sample.allocationsPerFrame = (double) (allocations - periodAllocations) / periodFrames;
+            sample.allocatedBytesPerFrame = (double) (allocatedBytes - periodAllocatedBytes) / periodFrames;
+            sample.latencyMax = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+            allLatencies.insert(allLatencies.end(), latencies.begin(), latencies.end());
+            sample.latencyP50 = percentile(latencies, 0.5);
+            sample.latencyP99 = percentile(latencies, 0.99);
+            samples.push_back(sample);
+            ROS_INFO("t=%.0f s frames=%lu dropped=%lu rss=%.1f MB allocations/frame=%.1f (%.1f MB) latency p50=%.1f ms p99=%.1f ms max=%.1f ms",
+                     sample.time, (unsigned long) sample.frames, (unsigned long) sample.droppedFrames, sample.residentMemory / (1024.0 * 1024.0),
+                     sample.allocationsPerFrame, sample.allocatedBytesPerFrame / (1024.0 * 1024.0),
+                     sample.latencyP50 * 1000.0, sample.latencyP99 * 1000.0, sample.latencyMax * 1000.0);
+
+            periodStart = std::chrono::steady_clock::now();
+            periodFrames = 0;
+            droppedFrames = 0;
+            periodAllocations = allocationCount.load();
+            periodAllocatedBytes = allocationBytes.load();
+            latencies.clear();
+        }
+
+        if (frameRate > 0.0) {
+            nextFrame += std::chrono::microseconds((int64_t) (1e6 / frameRate));
+            std::this_thread::sleep_until(nextFrame);
+        }
+    }
+    spinner.stop();
+
+    if (!csvPath.empty()) {
+        std::ofstream csv(csvPath.c_str());
+        csv << "time,frames,dropped_frames,resident_memory,allocations_per_frame,allocated_bytes_per_frame,latency_p50,latency_p99,latency_max\n";
+        for (size_t i = 0; i < samples.size(); ++i) {
+            const SoakSample& sample = samples[i];
+            csv << sample.time << "," << sample.frames << "," << sample.droppedFrames << "," << sample.residentMemory << ","
+                << sample.allocationsPerFrame << "," << sample.allocatedBytesPerFrame << ","
+                << sample.latencyP50 << "," << sample.latencyP99 << "," << sample.latencyMax << "\n";
+        }
+    }
+
+    if (samples.size() < 2) {
+        ROS_ERROR("Soak test too short, %lu sampling periods after warmup, at least 2 are needed", (unsigned long) samples.size());
+        return 1;
+    }
+    const SoakSample& first = samples.front();
+    const SoakSample& last = samples.back();
+    std::vector<std::string> failures;
+    char message[256];
+
+    const double residentMemoryGrowth = ((double) last.residentMemory - (double) first.residentMemory) / (1024.0 * 1024.0);
+    if (residentMemoryGrowth > maxResidentMemoryGrowth) {
+        std::snprintf(message, sizeof(message), "resident memory grew %.1f MB (max %.1f MB)", residentMemoryGrowth, maxResidentMemoryGrowth);
+        failures.push_back(message);
+    }
+    if (last.allocationsPerFrame > first.allocationsPerFrame * (1.0 + maxAllocationsGrowth) + 1.0) {
+        std::snprintf(message, sizeof(message), "allocations per frame grew from %.1f to %.1f (max growth %.0f %%)",
+                      first.allocationsPerFrame, last.allocationsPerFrame, maxAllocationsGrowth * 100.0);
+        failures.push_back(message);
+    }
+    if (last.latencyP99 > first.latencyP99 * (1.0 + maxLatencyGrowth)) {
+        std::snprintf(message, sizeof(message), "latency p99 grew from %.1f ms to %.1f ms (max growth %.0f %%)",
+                      first.latencyP99 * 1000.0, last.latencyP99 * 1000.0, maxLatencyGrowth * 100.0);
+        failures.push_back(message);
+    }
+    const double latencyP99 = percentile(allLatencies, 0.99);
+    if (maxLatencyP99 > 0.0 && latencyP99 > maxLatencyP99) {
+        std::snprintf(message, sizeof(message), "latency p99 %.1f ms (max %.1f ms)", latencyP99 * 1000.0, maxLatencyP99 * 1000.0);
+        failures.push_back(message);
+    }
+    uint64_t totalDroppedFrames = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        totalDroppedFrames += samples[i].droppedFrames;
+    }
+    if (totalDroppedFrames > (uint64_t) maxDroppedFrames) {
+        std::snprintf(message, sizeof(message), "%lu frames dropped (max %d)", (unsigned long) totalDroppedFrames, maxDroppedFrames);
+        failures.push_back(message);
+    }
+
+    for (size_t i = 0; i < failures.size(); ++i) {
+        ROS_ERROR("Soak test failed: %s", failures[i].c_str());
+    }
+    if (failures.empty()) {
+        ROS_INFO("Soak test passed: %lu frames, resident memory growth %.1f MB, latency p99 %.1f ms",
+                 (unsigned long) frameIndex, residentMemoryGrowth, latencyP99 * 1000.0);
+    }
+    return failures.empty() ? 0 : 1;
+}